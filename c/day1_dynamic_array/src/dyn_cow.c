@@ -0,0 +1,297 @@
+#include "dyn_cow.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define OK      (0)
+#define ERR    (-1)
+
+#define CHUNK_MASK (DYN_COW_CHUNK_ELEMS - 1)
+
+typedef struct {
+    size_t refs; // directories referencing this chunk
+    int    data[DYN_COW_CHUNK_ELEMS];
+} cow_chunk_t;
+
+struct dyn_cow_dir {
+    size_t        refs;     // handles referencing this directory
+    size_t        nchunks;
+    size_t        capacity; // slots in chunks
+    cow_chunk_t** chunks;
+};
+
+static void ref_get(size_t* refs)
+{
+    __atomic_add_fetch(refs, 1, __ATOMIC_RELAXED);
+}
+
+/* Returns 1 when the last reference was dropped. */
+static int ref_put(size_t* refs)
+{
+    return __atomic_sub_fetch(refs, 1, __ATOMIC_ACQ_REL) == 0;
+}
+
+static int ref_exclusive(size_t* refs)
+{
+    return __atomic_load_n(refs, __ATOMIC_ACQUIRE) == 1;
+}
+
+static void chunk_release(cow_chunk_t* chunk)
+{
+    if (ref_put(&chunk->refs)) {
+        free(chunk);
+    }
+}
+
+static void dir_release(dyn_cow_dir_t* dir)
+{
+    if (!ref_put(&dir->refs)) {
+        return;
+    }
+
+    for (size_t c = 0; c < dir->nchunks; c++) {
+        chunk_release(dir->chunks[c]);
+    }
+    free(dir->chunks);
+    free(dir);
+}
+
+static dyn_cow_dir_t* dir_create(size_t capacity)
+{
+    dyn_cow_dir_t* dir = malloc(sizeof(*dir));
+    if (dir == NULL) {
+        return NULL;
+    }
+
+    dir->chunks = malloc(capacity * sizeof(cow_chunk_t*));
+    if (dir->chunks == NULL) {
+        free(dir);
+        return NULL;
+    }
+
+    dir->refs = 1;
+    dir->nchunks = 0;
+    dir->capacity = capacity;
+    return dir;
+}
+
+/* Make arr->dir private to arr, cloning the chunk pointers if shared. */
+static int dir_make_exclusive(dyn_cow_array_t* arr)
+{
+    dyn_cow_dir_t* old_dir = arr->dir;
+
+    if (old_dir == NULL) {
+        arr->dir = dir_create(1);
+        return arr->dir ? OK : ERR;
+    }
+
+    if (ref_exclusive(&old_dir->refs)) {
+        return OK;
+    }
+
+    dyn_cow_dir_t* new_dir = dir_create(old_dir->nchunks ? old_dir->nchunks : 1);
+    if (new_dir == NULL) {
+        return ERR;
+    }
+
+    for (size_t c = 0; c < old_dir->nchunks; c++) {
+        ref_get(&old_dir->chunks[c]->refs);
+        new_dir->chunks[c] = old_dir->chunks[c];
+    }
+    new_dir->nchunks = old_dir->nchunks;
+
+    arr->dir = new_dir;
+    dir_release(old_dir);
+    return OK;
+}
+
+/* Make chunk c of an exclusive directory writable, copying it if shared. */
+static int chunk_make_exclusive(dyn_cow_dir_t* dir, size_t c)
+{
+    cow_chunk_t* old_chunk = dir->chunks[c];
+
+    if (ref_exclusive(&old_chunk->refs)) {
+        return OK;
+    }
+
+    cow_chunk_t* new_chunk = malloc(sizeof(*new_chunk));
+    if (new_chunk == NULL) {
+        return ERR;
+    }
+
+    memcpy(new_chunk->data, old_chunk->data, sizeof(new_chunk->data));
+    new_chunk->refs = 1;
+    dir->chunks[c] = new_chunk;
+    chunk_release(old_chunk);
+    return OK;
+}
+
+static int dir_add_chunk(dyn_cow_dir_t* dir)
+{
+    if (dir->nchunks == dir->capacity) {
+        size_t new_capacity = dir->capacity * 2;
+        cow_chunk_t** chunks = realloc(dir->chunks, new_capacity * sizeof(cow_chunk_t*));
+        if (chunks == NULL) {
+            return ERR;
+        }
+        dir->chunks = chunks;
+        dir->capacity = new_capacity;
+    }
+
+    cow_chunk_t* chunk = malloc(sizeof(*chunk));
+    if (chunk == NULL) {
+        return ERR;
+    }
+
+    chunk->refs = 1;
+    dir->chunks[dir->nchunks++] = chunk;
+    return OK;
+}
+
+int dyn_cow_init(dyn_cow_array_t* arr)
+{
+    if (arr == NULL) {
+        return ERR;
+    }
+
+    arr->dir = NULL;
+    arr->size = 0;
+
+    return OK;
+}
+
+int dyn_cow_init_from_array(dyn_cow_array_t* arr, const dyn_array_t* src)
+{
+    if (dyn_cow_init(arr) != OK || src == NULL) {
+        return ERR;
+    }
+
+    if (src->size == 0) {
+        return OK;
+    }
+
+    size_t nchunks = (src->size + CHUNK_MASK) >> DYN_COW_CHUNK_SHIFT;
+    arr->dir = dir_create(nchunks);
+    if (arr->dir == NULL) {
+        return ERR;
+    }
+
+    for (size_t c = 0; c < nchunks; c++) {
+        if (dir_add_chunk(arr->dir) != OK) {
+            dyn_cow_free(arr);
+            return ERR;
+        }
+
+        size_t first = c << DYN_COW_CHUNK_SHIFT;
+        size_t len = src->size - first;
+        if (len > DYN_COW_CHUNK_ELEMS) {
+            len = DYN_COW_CHUNK_ELEMS;
+        }
+        memcpy(arr->dir->chunks[c]->data, &src->data[first], len * sizeof(int));
+    }
+    arr->size = src->size;
+
+    return OK;
+}
+
+void dyn_cow_free(dyn_cow_array_t* arr)
+{
+    if (arr == NULL) {
+        return;
+    }
+
+    dyn_cow_dir_t* dir = arr->dir;
+
+    arr->dir = NULL;
+    arr->size = 0;
+
+    if (dir) {
+        dir_release(dir);
+    }
+}
+
+int dyn_cow_snapshot(const dyn_cow_array_t* src, dyn_cow_array_t* snap)
+{
+    if (src == NULL || snap == NULL || src == snap) {
+        return ERR;
+    }
+
+    if (src->dir) {
+        ref_get(&src->dir->refs);
+    }
+    snap->dir = src->dir;
+    snap->size = src->size;
+
+    return OK;
+}
+
+int dyn_cow_push_back(dyn_cow_array_t* arr, int value)
+{
+    if (arr == NULL) {
+        return ERR;
+    }
+
+    if (dir_make_exclusive(arr) != OK) {
+        return ERR;
+    }
+
+    dyn_cow_dir_t* dir = arr->dir;
+    size_t c = arr->size >> DYN_COW_CHUNK_SHIFT;
+
+    if (c == dir->nchunks) {
+        if (dir_add_chunk(dir) != OK) {
+            return ERR;
+        }
+    } else if (chunk_make_exclusive(dir, c) != OK) {
+        return ERR;
+    }
+
+    dir->chunks[c]->data[arr->size & CHUNK_MASK] = value;
+    arr->size++;
+
+    return OK;
+}
+
+int dyn_cow_set(dyn_cow_array_t* arr, size_t index, int value)
+{
+    if (arr == NULL || index >= arr->size) {
+        return ERR;
+    }
+
+    size_t c = index >> DYN_COW_CHUNK_SHIFT;
+
+    if (dir_make_exclusive(arr) != OK || chunk_make_exclusive(arr->dir, c) != OK) {
+        return ERR;
+    }
+
+    arr->dir->chunks[c]->data[index & CHUNK_MASK] = value;
+
+    return OK;
+}
+
+int dyn_cow_get(const dyn_cow_array_t* arr, size_t index, int* out_value)
+{
+    if (arr == NULL || out_value == NULL || index >= arr->size) {
+        return ERR;
+    }
+
+    *out_value = arr->dir->chunks[index >> DYN_COW_CHUNK_SHIFT]->data[index & CHUNK_MASK];
+
+    return OK;
+}
+
+const int* dyn_cow_chunk(const dyn_cow_array_t* arr, size_t chunk_index, size_t* out_len)
+{
+    if (arr == NULL || out_len == NULL) {
+        return NULL;
+    }
+
+    size_t first = chunk_index << DYN_COW_CHUNK_SHIFT;
+    if (first >= arr->size || (first >> DYN_COW_CHUNK_SHIFT) != chunk_index) {
+        return NULL;
+    }
+
+    size_t len = arr->size - first;
+    *out_len = len > DYN_COW_CHUNK_ELEMS ? DYN_COW_CHUNK_ELEMS : len;
+
+    return arr->dir->chunks[chunk_index]->data;
+}
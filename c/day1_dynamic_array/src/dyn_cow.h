@@ -0,0 +1,69 @@
+#ifndef DYN_COW_H
+#define DYN_COW_H
+
+#include <stddef.h>
+
+#include "dyn_array.h"
+
+/* Chunked int array with O(1) copy-on-write snapshots.
+ *
+ * Elements live in fixed-size chunks listed in a shared directory; both
+ * directory and chunks are reference counted. A snapshot only takes a
+ * reference on the directory. The first write through any handle that
+ * shares the directory clones the directory (pointers only), and a write
+ * into a shared chunk copies just that chunk.
+ *
+ * A handle is used by one thread at a time; snapshots of it may be read and
+ * freed concurrently from other threads. dyn_cow_snapshot() must be called by
+ * the thread that owns src.
+ */
+
+#define DYN_COW_CHUNK_SHIFT (12)
+#define DYN_COW_CHUNK_ELEMS ((size_t)1 << DYN_COW_CHUNK_SHIFT)
+
+typedef struct dyn_cow_dir dyn_cow_dir_t;
+
+typedef struct {
+    dyn_cow_dir_t* dir; // NULL while empty
+    size_t size;
+} dyn_cow_array_t;
+
+/* Initialize empty array. Returns 0 on success, -1 on invalid args. */
+int dyn_cow_init(dyn_cow_array_t* arr);
+
+/* Initialize with a copy of src contents.
+ * Returns 0 on success, -1 on allocation failure or invalid args.
+ */
+int dyn_cow_init_from_array(dyn_cow_array_t* arr, const dyn_array_t* src);
+
+/* Drop this handle's references. Safe to call multiple times. */
+void dyn_cow_free(dyn_cow_array_t* arr);
+
+/* Make snap a point-in-time view of src in O(1).
+ * snap must not be initialized (or already freed); free it with dyn_cow_free.
+ * Returns 0 on success, -1 on invalid args.
+ */
+int dyn_cow_snapshot(const dyn_cow_array_t* src, dyn_cow_array_t* snap);
+
+/* Append value to the end.
+ * Returns 0 on success, -1 on allocation failure or invalid args.
+ */
+int dyn_cow_push_back(dyn_cow_array_t* arr, int value);
+
+/* Overwrite element at index.
+ * Returns 0 on success, -1 if index is out of bounds or allocation failed.
+ */
+int dyn_cow_set(dyn_cow_array_t* arr, size_t index, int value);
+
+/* Get element at index.
+ * Returns 0 on success, -1 if index is out of bounds.
+ */
+int dyn_cow_get(const dyn_cow_array_t* arr, size_t index, int* out_value);
+
+/* Read-only access to chunk chunk_index for chunk-at-a-time scans.
+ * Writes the number of valid elements to *out_len.
+ * Returns NULL if chunk_index is out of bounds.
+ */
+const int* dyn_cow_chunk(const dyn_cow_array_t* arr, size_t chunk_index, size_t* out_len);
+
+#endif
@@ -0,0 +1,334 @@
+#include "dyn_hist.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define OK      (0)
+#define ERR    (-1)
+
+#define MAX_THREADS           (64)
+#define MIN_ELEMS_PER_THREAD  (1u << 16)
+#define HIST_MIN_CAPACITY     (16)
+
+typedef struct {
+    const int* data;
+    size_t     begin;
+    size_t     end;
+    /* dense path */
+    int        min_value;
+    size_t     nbuckets;
+    size_t*    counts;
+    /* hash path */
+    dyn_hist_t* hist;
+    int        ret;
+} hist_job_t;
+
+static unsigned pick_threads(size_t n, unsigned nthreads)
+{
+    size_t max_useful = n / MIN_ELEMS_PER_THREAD;
+
+    if (nthreads == 0) {
+        nthreads = 4;
+    }
+    if (nthreads > MAX_THREADS) {
+        nthreads = MAX_THREADS;
+    }
+    if (nthreads > max_useful) {
+        nthreads = max_useful ? (unsigned)max_useful : 1;
+    }
+    return nthreads;
+}
+
+/* Run fn over nthreads jobs: job 0 on the calling thread, the rest on
+ * pthreads. A job whose thread cannot be created runs inline instead. */
+static void run_jobs(hist_job_t* jobs, unsigned nthreads, void* (*fn)(void*))
+{
+    pthread_t tids[MAX_THREADS];
+    int started[MAX_THREADS] = {0};
+
+    for (unsigned t = 1; t < nthreads; t++) {
+        started[t] = pthread_create(&tids[t], NULL, fn, &jobs[t]) == 0;
+    }
+
+    fn(&jobs[0]);
+
+    for (unsigned t = 1; t < nthreads; t++) {
+        if (started[t]) {
+            pthread_join(tids[t], NULL);
+        } else {
+            fn(&jobs[t]);
+        }
+    }
+}
+
+static void* dense_worker(void* arg)
+{
+    hist_job_t* job = arg;
+    const int* data = job->data;
+    size_t* counts = job->counts;
+    uint32_t base = (uint32_t)job->min_value;
+    size_t nbuckets = job->nbuckets;
+    int ret = OK;
+
+    for (size_t i = job->begin; i < job->end; i++) {
+        /* unsigned wrap-around folds both range checks into one compare */
+        size_t off = (uint32_t)data[i] - base;
+        if (off < nbuckets) {
+            counts[off]++;
+        } else {
+            ret = ERR;
+        }
+    }
+
+    job->ret = ret;
+    return NULL;
+}
+
+int dyn_array_histogram_dense(const dyn_array_t* arr, int min_value, int max_value,
+                              size_t* counts, unsigned nthreads)
+{
+    if (arr == NULL || counts == NULL || min_value > max_value ||
+        (arr->size && arr->data == NULL)) {
+        return ERR;
+    }
+
+    size_t nbuckets = (size_t)((int64_t)max_value - min_value) + 1;
+    memset(counts, 0, nbuckets * sizeof(size_t));
+
+    nthreads = pick_threads(arr->size, nthreads);
+
+    hist_job_t jobs[MAX_THREADS];
+    size_t* private_counts = NULL;
+
+    if (nthreads > 1) {
+        private_counts = calloc((size_t)(nthreads - 1) * nbuckets, sizeof(size_t));
+        if (private_counts == NULL) {
+            /* fall back to a single pass on this thread */
+            nthreads = 1;
+        }
+    }
+
+    size_t slice = arr->size / nthreads;
+    for (unsigned t = 0; t < nthreads; t++) {
+        jobs[t].data = arr->data;
+        jobs[t].begin = t * slice;
+        jobs[t].end = (t == nthreads - 1) ? arr->size : (t + 1) * slice;
+        jobs[t].min_value = min_value;
+        jobs[t].nbuckets = nbuckets;
+        jobs[t].counts = t ? &private_counts[(t - 1) * nbuckets] : counts;
+        jobs[t].hist = NULL;
+        jobs[t].ret = OK;
+    }
+
+    run_jobs(jobs, nthreads, dense_worker);
+
+    int ret = OK;
+    for (unsigned t = 0; t < nthreads; t++) {
+        if (jobs[t].ret != OK) {
+            ret = ERR;
+        }
+        if (t) {
+            const size_t* src = jobs[t].counts;
+            for (size_t b = 0; b < nbuckets; b++) {
+                counts[b] += src[b];
+            }
+        }
+    }
+
+    free(private_counts);
+    return ret;
+}
+
+static inline size_t hash_int(int key, size_t mask)
+{
+    /* Fibonacci hashing; the high bits are the well-mixed ones */
+    uint64_t h = (uint64_t)(uint32_t)key * 0x9E3779B97F4A7C15ull;
+    return (size_t)(h >> 32) & mask;
+}
+
+static int hist_rehash(dyn_hist_t* h, size_t new_capacity)
+{
+    int* keys = malloc(new_capacity * sizeof(int));
+    size_t* counts = calloc(new_capacity, sizeof(size_t));
+
+    if (keys == NULL || counts == NULL) {
+        free(keys);
+        free(counts);
+        return ERR;
+    }
+
+    size_t mask = new_capacity - 1;
+    for (size_t i = 0; i < h->capacity; i++) {
+        if (h->counts[i]) {
+            size_t slot = hash_int(h->keys[i], mask);
+            while (counts[slot]) {
+                slot = (slot + 1) & mask;
+            }
+            keys[slot] = h->keys[i];
+            counts[slot] = h->counts[i];
+        }
+    }
+
+    free(h->keys);
+    free(h->counts);
+    h->keys = keys;
+    h->counts = counts;
+    h->capacity = new_capacity;
+    return OK;
+}
+
+int dyn_hist_init(dyn_hist_t* h, size_t expected_keys)
+{
+    if (h == NULL) {
+        return ERR;
+    }
+
+    size_t capacity = HIST_MIN_CAPACITY;
+    /* keep load factor at or below 1/2 */
+    while (capacity / 2 < expected_keys) {
+        if (capacity > SIZE_MAX / 4) {
+            return ERR;
+        }
+        capacity *= 2;
+    }
+
+    h->keys = NULL;
+    h->counts = NULL;
+    h->size = 0;
+    h->capacity = 0;
+
+    return hist_rehash(h, capacity);
+}
+
+void dyn_hist_free(dyn_hist_t* h)
+{
+    if (h == NULL) {
+        return;
+    }
+
+    free(h->keys);
+    free(h->counts);
+    h->keys = NULL;
+    h->counts = NULL;
+    h->size = 0;
+    h->capacity = 0;
+}
+
+int dyn_hist_add(dyn_hist_t* h, int key, size_t count)
+{
+    if (h == NULL || h->counts == NULL) {
+        return ERR;
+    }
+
+    if (count == 0) {
+        return OK;
+    }
+
+    size_t mask = h->capacity - 1;
+    size_t slot = hash_int(key, mask);
+
+    while (h->counts[slot]) {
+        if (h->keys[slot] == key) {
+            h->counts[slot] += count;
+            return OK;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    if ((h->size + 1) * 2 > h->capacity) {
+        if (hist_rehash(h, h->capacity * 2) != OK) {
+            return ERR;
+        }
+        return dyn_hist_add(h, key, count);
+    }
+
+    h->keys[slot] = key;
+    h->counts[slot] = count;
+    h->size++;
+    return OK;
+}
+
+size_t dyn_hist_get(const dyn_hist_t* h, int key)
+{
+    if (h == NULL || h->counts == NULL) {
+        return 0;
+    }
+
+    size_t mask = h->capacity - 1;
+    size_t slot = hash_int(key, mask);
+
+    while (h->counts[slot]) {
+        if (h->keys[slot] == key) {
+            return h->counts[slot];
+        }
+        slot = (slot + 1) & mask;
+    }
+    return 0;
+}
+
+static void* hash_worker(void* arg)
+{
+    hist_job_t* job = arg;
+    const int* data = job->data;
+    int ret = OK;
+
+    for (size_t i = job->begin; i < job->end && ret == OK; i++) {
+        ret = dyn_hist_add(job->hist, data[i], 1);
+    }
+
+    job->ret = ret;
+    return NULL;
+}
+
+int dyn_array_histogram_hash(const dyn_array_t* arr, dyn_hist_t* out, unsigned nthreads)
+{
+    if (arr == NULL || out == NULL || out->counts == NULL ||
+        (arr->size && arr->data == NULL)) {
+        return ERR;
+    }
+
+    nthreads = pick_threads(arr->size, nthreads);
+
+    hist_job_t jobs[MAX_THREADS];
+    dyn_hist_t privates[MAX_THREADS];
+    unsigned ready = 1;
+
+    /* thread 0 counts straight into out */
+    for (; ready < nthreads; ready++) {
+        if (dyn_hist_init(&privates[ready], 0) != OK) {
+            break;
+        }
+    }
+    nthreads = ready;
+
+    size_t slice = arr->size / nthreads;
+    for (unsigned t = 0; t < nthreads; t++) {
+        jobs[t].data = arr->data;
+        jobs[t].begin = t * slice;
+        jobs[t].end = (t == nthreads - 1) ? arr->size : (t + 1) * slice;
+        jobs[t].counts = NULL;
+        jobs[t].hist = t ? &privates[t] : out;
+        jobs[t].ret = OK;
+    }
+
+    run_jobs(jobs, nthreads, hash_worker);
+
+    int ret = OK;
+    for (unsigned t = 0; t < nthreads; t++) {
+        if (jobs[t].ret != OK) {
+            ret = ERR;
+        }
+        if (t) {
+            const dyn_hist_t* src = &privates[t];
+            for (size_t i = 0; i < src->capacity && ret == OK; i++) {
+                if (src->counts[i]) {
+                    ret = dyn_hist_add(out, src->keys[i], src->counts[i]);
+                }
+            }
+            dyn_hist_free(&privates[t]);
+        }
+    }
+
+    return ret;
+}
@@ -0,0 +1,54 @@
+#ifndef DYN_HIST_H
+#define DYN_HIST_H
+
+#include <stddef.h>
+
+#include "dyn_array.h"
+
+/* Value-frequency counting (group-by-count) over dyn_array_t.
+ * Both paths make a single pass over the data; with nthreads > 1 the array
+ * is split into slices counted into per-thread private tables which are
+ * merged at the end, so there is no sharing between threads while counting.
+ * nthreads == 0 picks a thread count from the array size.
+ */
+
+/* Open-addressing key -> count map used by the wide-range path.
+ * A slot is empty when its count is 0.
+ */
+typedef struct {
+    int*    keys;
+    size_t* counts;
+    size_t  size;     // number of distinct keys
+    size_t  capacity; // number of slots, power of two
+} dyn_hist_t;
+
+/* Dense path for small key ranges.
+ * counts must hold (max_value - min_value + 1) entries; it is overwritten
+ * with counts[v - min_value] for every value v in arr.
+ * Returns 0 on success, -1 on invalid args, allocation failure or when arr
+ * holds a value outside [min_value, max_value] (counts are then undefined).
+ */
+int dyn_array_histogram_dense(const dyn_array_t* arr, int min_value, int max_value,
+                              size_t* counts, unsigned nthreads);
+
+/* Hash path for wide key ranges.
+ * Counts are added to out, which must be initialized with dyn_hist_init.
+ * Returns 0 on success, -1 on invalid args or allocation failure.
+ */
+int dyn_array_histogram_hash(const dyn_array_t* arr, dyn_hist_t* out, unsigned nthreads);
+
+/* Initialize empty map sized for about expected_keys distinct keys.
+ * Returns 0 on success, -1 on allocation failure or invalid args.
+ */
+int dyn_hist_init(dyn_hist_t* h, size_t expected_keys);
+
+/* Free all resources. Safe to call multiple times. */
+void dyn_hist_free(dyn_hist_t* h);
+
+/* Add count to key. Returns 0 on success, -1 on allocation failure or invalid args. */
+int dyn_hist_add(dyn_hist_t* h, int key, size_t count);
+
+/* Count for key, 0 if absent. */
+size_t dyn_hist_get(const dyn_hist_t* h, int key);
+
+#endif
@@ -0,0 +1,421 @@
+#include "dyn_table.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define OK      (0)
+#define ERR    (-1)
+
+#define MIN_GROW_ROWS (16)
+
+static size_t col_elem_size(dyn_col_type_t type)
+{
+    switch (type) {
+    case DYN_COL_INT:    return sizeof(int);
+    case DYN_COL_INT64:  return sizeof(int64_t);
+    case DYN_COL_DOUBLE: return sizeof(double);
+    }
+    return 0;
+}
+
+static int grow_columns(dyn_table_t* t, size_t new_capacity)
+{
+    /* realloc column by column; on failure the columns already grown
+     * simply keep the larger block, capacity stays at the old value */
+    for (size_t c = 0; c < t->ncols; c++) {
+        size_t elem = col_elem_size(t->types[c]);
+        if (new_capacity > SIZE_MAX / elem) {
+            return ERR;
+        }
+        void* mem_chunk = realloc(t->columns[c], new_capacity * elem);
+        if (mem_chunk == NULL) {
+            return ERR;
+        }
+        t->columns[c] = mem_chunk;
+    }
+    t->capacity = new_capacity;
+    return OK;
+}
+
+int dyn_table_init(dyn_table_t* t, const dyn_col_type_t* types, size_t ncols,
+                   size_t initial_capacity)
+{
+    if (t == NULL || types == NULL || ncols == 0) {
+        return ERR;
+    }
+
+    for (size_t c = 0; c < ncols; c++) {
+        if (col_elem_size(types[c]) == 0) {
+            return ERR;
+        }
+    }
+
+    t->columns = calloc(ncols, sizeof(void*));
+    t->types = calloc(ncols, sizeof(dyn_col_type_t));
+    t->ncols = ncols;
+    t->size = 0;
+    t->capacity = 0;
+
+    if (t->columns == NULL || t->types == NULL) {
+        dyn_table_free(t);
+        return ERR;
+    }
+    memcpy(t->types, types, ncols * sizeof(dyn_col_type_t));
+
+    if (initial_capacity && grow_columns(t, initial_capacity) != OK) {
+        dyn_table_free(t);
+        return ERR;
+    }
+
+    return OK;
+}
+
+int dyn_table_init_from_arrays(dyn_table_t* t, const dyn_array_t* arrays, size_t ncols)
+{
+    if (t == NULL || arrays == NULL || ncols == 0) {
+        return ERR;
+    }
+
+    size_t rows = arrays[0].size;
+    for (size_t c = 1; c < ncols; c++) {
+        if (arrays[c].size != rows) {
+            return ERR;
+        }
+    }
+
+    dyn_col_type_t* types = malloc(ncols * sizeof(dyn_col_type_t));
+    if (types == NULL) {
+        return ERR;
+    }
+    for (size_t c = 0; c < ncols; c++) {
+        types[c] = DYN_COL_INT;
+    }
+
+    int ret = dyn_table_init(t, types, ncols, rows);
+    free(types);
+    if (ret != OK) {
+        return ERR;
+    }
+
+    for (size_t c = 0; c < ncols; c++) {
+        if (rows) {
+            memcpy(t->columns[c], arrays[c].data, rows * sizeof(int));
+        }
+    }
+    t->size = rows;
+
+    return OK;
+}
+
+void dyn_table_free(dyn_table_t* t)
+{
+    if (t == NULL) {
+        return;
+    }
+
+    if (t->columns) {
+        for (size_t c = 0; c < t->ncols; c++) {
+            free(t->columns[c]);
+        }
+    }
+    free(t->columns);
+    free(t->types);
+
+    t->columns = NULL;
+    t->types = NULL;
+    t->ncols = 0;
+    t->size = 0;
+    t->capacity = 0;
+}
+
+int dyn_table_reserve(dyn_table_t* t, size_t min_capacity)
+{
+    if (t == NULL || t->columns == NULL) {
+        return ERR;
+    }
+
+    if (min_capacity <= t->capacity) {
+        return OK;
+    }
+
+    return grow_columns(t, min_capacity);
+}
+
+int dyn_table_append_row(dyn_table_t* t, const dyn_cell_t* row)
+{
+    if (t == NULL || t->columns == NULL || row == NULL) {
+        return ERR;
+    }
+
+    if (t->size == t->capacity) {
+        /* grow all columns together, geometric */
+        size_t new_capacity = t->capacity < MIN_GROW_ROWS ? MIN_GROW_ROWS : t->capacity * 2;
+        if (new_capacity < t->capacity) {
+            /* Overflow */
+            return ERR;
+        }
+        if (grow_columns(t, new_capacity) != OK) {
+            return ERR;
+        }
+    }
+
+    size_t r = t->size;
+    for (size_t c = 0; c < t->ncols; c++) {
+        switch (t->types[c]) {
+        case DYN_COL_INT:    ((int*)t->columns[c])[r] = row[c].i;       break;
+        case DYN_COL_INT64:  ((int64_t*)t->columns[c])[r] = row[c].i64; break;
+        case DYN_COL_DOUBLE: ((double*)t->columns[c])[r] = row[c].f64;  break;
+        }
+    }
+    t->size++;
+
+    return OK;
+}
+
+int dyn_table_get(const dyn_table_t* t, size_t row, size_t col, dyn_cell_t* out_value)
+{
+    if (t == NULL || out_value == NULL || col >= t->ncols || row >= t->size) {
+        return ERR;
+    }
+
+    switch (t->types[col]) {
+    case DYN_COL_INT:    out_value->i = ((const int*)t->columns[col])[row];       break;
+    case DYN_COL_INT64:  out_value->i64 = ((const int64_t*)t->columns[col])[row]; break;
+    case DYN_COL_DOUBLE: out_value->f64 = ((const double*)t->columns[col])[row];  break;
+    }
+
+    return OK;
+}
+
+static void* col_typed(const dyn_table_t* t, size_t col, dyn_col_type_t type)
+{
+    if (t == NULL || col >= t->ncols || t->types[col] != type) {
+        return NULL;
+    }
+    return t->columns[col];
+}
+
+int* dyn_table_col_int(const dyn_table_t* t, size_t col)
+{
+    return col_typed(t, col, DYN_COL_INT);
+}
+
+int64_t* dyn_table_col_int64(const dyn_table_t* t, size_t col)
+{
+    return col_typed(t, col, DYN_COL_INT64);
+}
+
+double* dyn_table_col_double(const dyn_table_t* t, size_t col)
+{
+    return col_typed(t, col, DYN_COL_DOUBLE);
+}
+
+int dyn_sel_init(dyn_sel_t* sel, size_t initial_capacity)
+{
+    if (sel == NULL) {
+        return ERR;
+    }
+
+    sel->rows = NULL;
+    sel->size = 0;
+    sel->capacity = 0;
+
+    if (initial_capacity) {
+        sel->rows = malloc(initial_capacity * sizeof(size_t));
+        if (sel->rows == NULL) {
+            return ERR;
+        }
+        sel->capacity = initial_capacity;
+    }
+
+    return OK;
+}
+
+void dyn_sel_free(dyn_sel_t* sel)
+{
+    if (sel == NULL) {
+        return;
+    }
+
+    free(sel->rows);
+    sel->rows = NULL;
+    sel->size = 0;
+    sel->capacity = 0;
+}
+
+static int sel_reserve(dyn_sel_t* sel, size_t min_capacity)
+{
+    if (min_capacity <= sel->capacity) {
+        return OK;
+    }
+    if (min_capacity > SIZE_MAX / sizeof(size_t)) {
+        return ERR;
+    }
+
+    size_t* mem_chunk = realloc(sel->rows, min_capacity * sizeof(size_t));
+    if (mem_chunk == NULL) {
+        return ERR;
+    }
+    sel->rows = mem_chunk;
+    sel->capacity = min_capacity;
+    return OK;
+}
+
+#define SEL_BLOCK (256)
+
+/* Two passes per block of SEL_BLOCK candidates: the predicate is first
+ * evaluated into a byte mask by a loop with no stores that depend on it
+ * (so it vectorizes), then the mask is compacted into sel. The
+ * compaction always writes the output slot and advances the cursor by
+ * the mask byte, so neither pass has a data-dependent branch. */
+#define SELECT_RANGE(NAME, T)                                                 \
+    static long select_range_##NAME(const T* restrict v, size_t n,            \
+                                    T lo, T hi,                               \
+                                    const dyn_sel_t* in, dyn_sel_t* sel)      \
+    {                                                                         \
+        size_t cand = in ? in->size : n;                                      \
+        if (sel_reserve(sel, cand ? cand : 1) != OK) {                        \
+            return ERR;                                                       \
+        }                                                                     \
+        size_t* restrict out = sel->rows;                                     \
+        const size_t* rows = in ? in->rows : NULL;                            \
+        unsigned char mask[SEL_BLOCK];                                        \
+        size_t k = 0;                                                         \
+        for (size_t base = 0; base < cand; base += SEL_BLOCK) {               \
+            size_t len = cand - base < SEL_BLOCK ? cand - base : SEL_BLOCK;   \
+            if (rows) {                                                       \
+                for (size_t j = 0; j < len; j++) {                            \
+                    T x = v[rows[base + j]];                                  \
+                    mask[j] = (unsigned char)((x >= lo) & (x <= hi));         \
+                }                                                             \
+                for (size_t j = 0; j < len; j++) {                            \
+                    out[k] = rows[base + j];                                  \
+                    k += mask[j];                                             \
+                }                                                             \
+            } else {                                                          \
+                const T* restrict x = v + base;                               \
+                for (size_t j = 0; j < len; j++) {                            \
+                    mask[j] = (unsigned char)((x[j] >= lo) & (x[j] <= hi));   \
+                }                                                             \
+                for (size_t j = 0; j < len; j++) {                            \
+                    out[k] = base + j;                                        \
+                    k += mask[j];                                             \
+                }                                                             \
+            }                                                                 \
+        }                                                                     \
+        sel->size = k;                                                        \
+        return (long)k;                                                       \
+    }
+
+SELECT_RANGE(int, int)
+SELECT_RANGE(int64, int64_t)
+SELECT_RANGE(double, double)
+
+/* Every row listed in sel must be inside the table. */
+static int check_sel_rows(const dyn_table_t* t, const dyn_sel_t* sel)
+{
+    if (sel->size && sel->rows == NULL) {
+        return ERR;
+    }
+    for (size_t i = 0; i < sel->size; i++) {
+        if (sel->rows[i] >= t->size) {
+            return ERR;
+        }
+    }
+    return OK;
+}
+
+static int check_sel_args(const dyn_table_t* t, const dyn_sel_t* in, dyn_sel_t* sel)
+{
+    if (sel == NULL || in == sel) {
+        return ERR;
+    }
+    if (in && check_sel_rows(t, in) != OK) {
+        return ERR;
+    }
+    return OK;
+}
+
+long dyn_table_select_range_int(const dyn_table_t* t, size_t col, int lo, int hi,
+                                const dyn_sel_t* in, dyn_sel_t* sel)
+{
+    const int* v = dyn_table_col_int(t, col);
+    if (v == NULL || check_sel_args(t, in, sel) != OK) {
+        return ERR;
+    }
+    return select_range_int(v, t->size, lo, hi, in, sel);
+}
+
+long dyn_table_select_range_int64(const dyn_table_t* t, size_t col, int64_t lo, int64_t hi,
+                                  const dyn_sel_t* in, dyn_sel_t* sel)
+{
+    const int64_t* v = dyn_table_col_int64(t, col);
+    if (v == NULL || check_sel_args(t, in, sel) != OK) {
+        return ERR;
+    }
+    return select_range_int64(v, t->size, lo, hi, in, sel);
+}
+
+long dyn_table_select_range_double(const dyn_table_t* t, size_t col, double lo, double hi,
+                                   const dyn_sel_t* in, dyn_sel_t* sel)
+{
+    const double* v = dyn_table_col_double(t, col);
+    if (v == NULL || check_sel_args(t, in, sel) != OK) {
+        return ERR;
+    }
+    return select_range_double(v, t->size, lo, hi, in, sel);
+}
+
+int dyn_table_sum_int(const dyn_table_t* t, size_t col, const dyn_sel_t* sel, int64_t* out_sum)
+{
+    if (t == NULL || out_sum == NULL || col >= t->ncols) {
+        return ERR;
+    }
+    if (sel && check_sel_rows(t, sel) != OK) {
+        return ERR;
+    }
+
+    int64_t sum = 0;
+    size_t n = sel ? sel->size : t->size;
+
+    if (t->types[col] == DYN_COL_INT) {
+        const int* restrict v = t->columns[col];
+        if (sel) {
+            for (size_t i = 0; i < n; i++) sum += v[sel->rows[i]];
+        } else {
+            for (size_t i = 0; i < n; i++) sum += v[i];
+        }
+    } else if (t->types[col] == DYN_COL_INT64) {
+        const int64_t* restrict v = t->columns[col];
+        if (sel) {
+            for (size_t i = 0; i < n; i++) sum += v[sel->rows[i]];
+        } else {
+            for (size_t i = 0; i < n; i++) sum += v[i];
+        }
+    } else {
+        return ERR;
+    }
+
+    *out_sum = sum;
+    return OK;
+}
+
+int dyn_table_sum_double(const dyn_table_t* t, size_t col, const dyn_sel_t* sel, double* out_sum)
+{
+    const double* restrict v = dyn_table_col_double(t, col);
+    if (v == NULL || out_sum == NULL) {
+        return ERR;
+    }
+    if (sel && check_sel_rows(t, sel) != OK) {
+        return ERR;
+    }
+
+    double sum = 0.0;
+    if (sel) {
+        for (size_t i = 0; i < sel->size; i++) sum += v[sel->rows[i]];
+    } else {
+        for (size_t i = 0; i < t->size; i++) sum += v[i];
+    }
+
+    *out_sum = sum;
+    return OK;
+}
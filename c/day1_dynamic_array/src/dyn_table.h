@@ -0,0 +1,102 @@
+#ifndef DYN_TABLE_H
+#define DYN_TABLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "dyn_array.h"
+
+/* Column-oriented (struct-of-arrays) table.
+ * Every column is a plain contiguous array of its element type; all columns
+ * share one size and one capacity and grow together, so a row append pays a
+ * single capacity check for the whole row.
+ */
+
+typedef enum {
+    DYN_COL_INT,    // int, same element type as dyn_array_t
+    DYN_COL_INT64,  // int64_t
+    DYN_COL_DOUBLE, // double
+} dyn_col_type_t;
+
+typedef union {
+    int     i;
+    int64_t i64;
+    double  f64;
+} dyn_cell_t;
+
+typedef struct {
+    void**          columns;  // ncols arrays, capacity elements each
+    dyn_col_type_t* types;    // element type of each column
+    size_t          ncols;
+    size_t          size;     // number of rows
+    size_t          capacity; // rows allocated in every column
+} dyn_table_t;
+
+/* Selection vector: ascending row indices produced by a scan. */
+typedef struct {
+    size_t* rows;
+    size_t  size;
+    size_t  capacity;
+} dyn_sel_t;
+
+/* Initialize table with ncols columns of the given types.
+ * initial_capacity may be 0 (lazy alloc).
+ * Returns 0 on success, -1 on allocation failure or invalid args.
+ */
+int dyn_table_init(dyn_table_t* t, const dyn_col_type_t* types, size_t ncols,
+                   size_t initial_capacity);
+
+/* Build a table of DYN_COL_INT columns from parallel dyn_arrays.
+ * All arrays must have the same size; data is copied.
+ * Returns 0 on success, -1 on allocation failure or invalid args.
+ */
+int dyn_table_init_from_arrays(dyn_table_t* t, const dyn_array_t* arrays, size_t ncols);
+
+/* Free all resources. Safe to call multiple times. */
+void dyn_table_free(dyn_table_t* t);
+
+/* Grow every column to hold at least min_capacity rows.
+ * Returns 0 on success, -1 on allocation failure or overflow.
+ */
+int dyn_table_reserve(dyn_table_t* t, size_t min_capacity);
+
+/* Append one row; row[i] is read as the member matching types[i].
+ * Returns 0 on success, -1 on allocation failure or invalid args.
+ */
+int dyn_table_append_row(dyn_table_t* t, const dyn_cell_t* row);
+
+/* Get a cell. Returns 0 on success, -1 if row/col is out of bounds. */
+int dyn_table_get(const dyn_table_t* t, size_t row, size_t col, dyn_cell_t* out_value);
+
+/* Typed column access; returns NULL on bad index or type mismatch.
+ * The pointer is valid until the next append/reserve.
+ */
+int*     dyn_table_col_int(const dyn_table_t* t, size_t col);
+int64_t* dyn_table_col_int64(const dyn_table_t* t, size_t col);
+double*  dyn_table_col_double(const dyn_table_t* t, size_t col);
+
+/* Selection vectors. */
+int  dyn_sel_init(dyn_sel_t* sel, size_t initial_capacity);
+void dyn_sel_free(dyn_sel_t* sel);
+
+/* Scan column col and store into sel the rows with lo <= value <= hi.
+ * If in is not NULL only rows listed in it are tested (refinement).
+ * Each block of rows is scanned into a predicate mask by a branch-free
+ * loop the compiler can vectorize, then compacted into sel.
+ * Returns the number of selected rows, or -1 on invalid args/allocation failure.
+ */
+long dyn_table_select_range_int(const dyn_table_t* t, size_t col, int lo, int hi,
+                                const dyn_sel_t* in, dyn_sel_t* sel);
+long dyn_table_select_range_int64(const dyn_table_t* t, size_t col, int64_t lo, int64_t hi,
+                                  const dyn_sel_t* in, dyn_sel_t* sel);
+long dyn_table_select_range_double(const dyn_table_t* t, size_t col, double lo, double hi,
+                                   const dyn_sel_t* in, dyn_sel_t* sel);
+
+/* Sum a column, over all rows (sel == NULL) or over the selected rows.
+ * Returns 0 on success, -1 on invalid args, type mismatch or a selected
+ * row that is out of bounds.
+ */
+int dyn_table_sum_int(const dyn_table_t* t, size_t col, const dyn_sel_t* sel, int64_t* out_sum);
+int dyn_table_sum_double(const dyn_table_t* t, size_t col, const dyn_sel_t* sel, double* out_sum);
+
+#endif
@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include "dyn_cow.h"
+}
+
+static std::vector<int> to_vec(const dyn_cow_array_t* arr) {
+    std::vector<int> out;
+    size_t len = 0;
+    for (size_t c = 0; const int* chunk = dyn_cow_chunk(arr, c, &len); ++c) {
+        out.insert(out.end(), chunk, chunk + len);
+    }
+    return out;
+}
+
+TEST(DynCowTest, InitPushGetAndFree) {
+    dyn_cow_array_t arr;
+    ASSERT_EQ(dyn_cow_init(&arr), 0);
+    EXPECT_EQ(arr.size, 0u);
+
+    int value;
+    EXPECT_EQ(dyn_cow_get(&arr, 0, &value), -1);
+
+    const size_t n = DYN_COW_CHUNK_ELEMS * 2 + 5;
+    for (size_t i = 0; i < n; ++i) {
+        ASSERT_EQ(dyn_cow_push_back(&arr, (int)i), 0);
+    }
+    EXPECT_EQ(arr.size, n);
+    ASSERT_EQ(dyn_cow_get(&arr, n - 1, &value), 0);
+    EXPECT_EQ(value, (int)(n - 1));
+    EXPECT_EQ(dyn_cow_set(&arr, n, 0), -1);
+
+    dyn_cow_free(&arr);
+    EXPECT_EQ(arr.dir, nullptr);
+    dyn_cow_free(&arr);
+}
+
+TEST(DynCowTest, InitFromDynArrayCopiesContents) {
+    dyn_array_t src;
+    ASSERT_EQ(dyn_array_init(&src, 10000), 0);
+    for (int i = 0; i < 10000; ++i) {
+        dyn_array_push_back(&src, i * 3);
+    }
+
+    dyn_cow_array_t arr;
+    ASSERT_EQ(dyn_cow_init_from_array(&arr, &src), 0);
+    auto v = to_vec(&arr);
+    ASSERT_EQ(v.size(), 10000u);
+    EXPECT_EQ(v[9999], 9999 * 3);
+
+    dyn_cow_free(&arr);
+    dyn_array_free(&src);
+}
+
+TEST(DynCowTest, SnapshotIsPointInTime) {
+    dyn_cow_array_t arr, snap;
+    ASSERT_EQ(dyn_cow_init(&arr), 0);
+    for (int i = 0; i < 100; ++i) {
+        ASSERT_EQ(dyn_cow_push_back(&arr, i), 0);
+    }
+
+    ASSERT_EQ(dyn_cow_snapshot(&arr, &snap), 0);
+    EXPECT_EQ(snap.dir, arr.dir);
+
+    ASSERT_EQ(dyn_cow_set(&arr, 0, -1), 0);
+    ASSERT_EQ(dyn_cow_push_back(&arr, 100), 0);
+
+    int value;
+    ASSERT_EQ(dyn_cow_get(&snap, 0, &value), 0);
+    EXPECT_EQ(value, 0);
+    EXPECT_EQ(snap.size, 100u);
+    ASSERT_EQ(dyn_cow_get(&arr, 0, &value), 0);
+    EXPECT_EQ(value, -1);
+    EXPECT_EQ(arr.size, 101u);
+
+    // snapshots are writable handles too and do not affect the source
+    ASSERT_EQ(dyn_cow_set(&snap, 1, 42), 0);
+    ASSERT_EQ(dyn_cow_get(&arr, 1, &value), 0);
+    EXPECT_EQ(value, 1);
+
+    dyn_cow_free(&snap);
+    dyn_cow_free(&arr);
+}
+
+TEST(DynCowTest, WriteCopiesOnlyTouchedChunk) {
+    dyn_cow_array_t arr, snap;
+    ASSERT_EQ(dyn_cow_init(&arr), 0);
+    for (size_t i = 0; i < DYN_COW_CHUNK_ELEMS * 4; ++i) {
+        ASSERT_EQ(dyn_cow_push_back(&arr, (int)i), 0);
+    }
+    ASSERT_EQ(dyn_cow_snapshot(&arr, &snap), 0);
+
+    ASSERT_EQ(dyn_cow_set(&arr, DYN_COW_CHUNK_ELEMS * 2, 7), 0);
+
+    size_t len;
+    for (size_t c = 0; c < 4; ++c) {
+        const int* a = dyn_cow_chunk(&arr, c, &len);
+        const int* s = dyn_cow_chunk(&snap, c, &len);
+        if (c == 2) {
+            EXPECT_NE(a, s);
+        } else {
+            EXPECT_EQ(a, s) << "chunk " << c << " should still be shared";
+        }
+    }
+
+    // a second write to the same chunk does not copy again
+    const int* before = dyn_cow_chunk(&arr, 2, &len);
+    ASSERT_EQ(dyn_cow_set(&arr, DYN_COW_CHUNK_ELEMS * 2 + 1, 8), 0);
+    EXPECT_EQ(dyn_cow_chunk(&arr, 2, &len), before);
+
+    dyn_cow_free(&snap);
+    dyn_cow_free(&arr);
+}
+
+TEST(DynCowTest, SnapshotOfEmptyArray) {
+    dyn_cow_array_t arr, snap;
+    ASSERT_EQ(dyn_cow_init(&arr), 0);
+    ASSERT_EQ(dyn_cow_snapshot(&arr, &snap), 0);
+    ASSERT_EQ(dyn_cow_push_back(&arr, 1), 0);
+    EXPECT_EQ(snap.size, 0u);
+    EXPECT_EQ(arr.size, 1u);
+    EXPECT_EQ(dyn_cow_snapshot(&arr, &arr), -1);
+    dyn_cow_free(&snap);
+    dyn_cow_free(&arr);
+}
+
+TEST(DynCowTest, ReadersSeeConsistentSnapshotsWhileWriterAppends) {
+    dyn_cow_array_t arr;
+    ASSERT_EQ(dyn_cow_init(&arr), 0);
+
+    const int kSnapshots = 50;
+    std::vector<dyn_cow_array_t> snaps(kSnapshots);
+    std::atomic<int> published{0};
+    std::atomic<bool> bad{false};
+
+    std::thread reader([&] {
+        for (int s = 0; s < kSnapshots; ++s) {
+            while (published.load(std::memory_order_acquire) <= s) {
+                std::this_thread::yield();
+            }
+            // every snapshot holds 0..size-1 with element 0 overwritten by -s
+            auto v = to_vec(&snaps[s]);
+            for (size_t i = 1; i < v.size(); ++i) {
+                if (v[i] != (int)i) bad = true;
+            }
+            if (v.empty() || v[0] != -s) bad = true;
+            dyn_cow_free(&snaps[s]);
+        }
+    });
+
+    for (int s = 0; s < kSnapshots; ++s) {
+        for (int i = 0; i < 1000; ++i) {
+            ASSERT_EQ(dyn_cow_push_back(&arr, (int)arr.size), 0);
+        }
+        ASSERT_EQ(dyn_cow_set(&arr, 0, -s), 0);
+        ASSERT_EQ(dyn_cow_snapshot(&arr, &snaps[s]), 0);
+        published.store(s + 1, std::memory_order_release);
+    }
+
+    reader.join();
+    EXPECT_FALSE(bad);
+    dyn_cow_free(&arr);
+}
@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+#include <map>
+#include <random>
+#include <vector>
+
+extern "C" {
+#include "dyn_hist.h"
+}
+
+static void fill(dyn_array_t* arr, const std::vector<int>& values) {
+    ASSERT_EQ(dyn_array_init(arr, values.empty() ? 1 : values.size()), 0);
+    for (int v : values) {
+        ASSERT_EQ(dyn_array_push_back(arr, v), 0);
+    }
+}
+
+static std::vector<int> random_values(size_t n, int lo, int hi, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> dist(lo, hi);
+    std::vector<int> out(n);
+    for (auto& v : out) v = dist(rng);
+    return out;
+}
+
+TEST(DynHistTest, DenseSmallArray) {
+    dyn_array_t arr;
+    fill(&arr, {3, 1, 3, 2, 3, -1});
+
+    size_t counts[5];
+    ASSERT_EQ(dyn_array_histogram_dense(&arr, -1, 3, counts, 1), 0);
+    EXPECT_EQ(counts[0], 1u); // -1
+    EXPECT_EQ(counts[1], 0u); //  0
+    EXPECT_EQ(counts[2], 1u); //  1
+    EXPECT_EQ(counts[3], 1u); //  2
+    EXPECT_EQ(counts[4], 3u); //  3
+
+    dyn_array_free(&arr);
+}
+
+TEST(DynHistTest, DenseRejectsOutOfRangeAndBadArgs) {
+    dyn_array_t arr;
+    fill(&arr, {0, 1, 9});
+
+    size_t counts[4];
+    EXPECT_EQ(dyn_array_histogram_dense(&arr, 0, 3, counts, 1), -1);
+    EXPECT_EQ(dyn_array_histogram_dense(&arr, 3, 0, counts, 1), -1);
+    EXPECT_EQ(dyn_array_histogram_dense(&arr, 0, 3, nullptr, 1), -1);
+    EXPECT_EQ(dyn_array_histogram_dense(nullptr, 0, 3, counts, 1), -1);
+
+    dyn_array_free(&arr);
+}
+
+TEST(DynHistTest, DenseMultiThreadedMatchesReference) {
+    auto values = random_values(1 << 20, -50, 200, 7);
+    dyn_array_t arr;
+    fill(&arr, values);
+
+    std::vector<size_t> expected(251, 0);
+    for (int v : values) expected[v + 50]++;
+
+    for (unsigned threads : {0u, 1u, 3u, 8u}) {
+        std::vector<size_t> counts(251, 123);
+        ASSERT_EQ(dyn_array_histogram_dense(&arr, -50, 200, counts.data(), threads), 0);
+        EXPECT_EQ(counts, expected) << "threads=" << threads;
+    }
+
+    dyn_array_free(&arr);
+}
+
+TEST(DynHistTest, HashMapAddGetAndGrow) {
+    dyn_hist_t h;
+    ASSERT_EQ(dyn_hist_init(&h, 0), 0);
+    EXPECT_EQ(dyn_hist_get(&h, 42), 0u);
+
+    for (int k = 0; k < 1000; ++k) {
+        ASSERT_EQ(dyn_hist_add(&h, k * 7919, (size_t)k + 1), 0);
+    }
+    ASSERT_EQ(dyn_hist_add(&h, 0, 10), 0);
+
+    EXPECT_EQ(h.size, 1000u);
+    EXPECT_LE(h.size * 2, h.capacity);
+    EXPECT_EQ(dyn_hist_get(&h, 0), 11u);
+    EXPECT_EQ(dyn_hist_get(&h, 999 * 7919), 1000u);
+    EXPECT_EQ(dyn_hist_get(&h, 1), 0u);
+
+    dyn_hist_free(&h);
+    dyn_hist_free(&h);
+}
+
+TEST(DynHistTest, HashMultiThreadedMatchesReference) {
+    auto values = random_values(1 << 18, -1000000000, 1000000000, 11);
+    // add heavy duplicates so counts are interesting
+    for (size_t i = 0; i < values.size(); i += 3) values[i] = (int)(i % 97);
+
+    dyn_array_t arr;
+    fill(&arr, values);
+
+    std::map<int, size_t> expected;
+    for (int v : values) expected[v]++;
+
+    for (unsigned threads : {1u, 4u}) {
+        dyn_hist_t h;
+        ASSERT_EQ(dyn_hist_init(&h, 0), 0);
+        ASSERT_EQ(dyn_array_histogram_hash(&arr, &h, threads), 0);
+        EXPECT_EQ(h.size, expected.size());
+        for (const auto& kv : expected) {
+            ASSERT_EQ(dyn_hist_get(&h, kv.first), kv.second) << kv.first;
+        }
+        dyn_hist_free(&h);
+    }
+
+    dyn_array_free(&arr);
+}
+
+TEST(DynHistTest, HashAccumulatesIntoExistingMap) {
+    dyn_array_t arr;
+    fill(&arr, {5, 5, INT32_MIN});
+
+    dyn_hist_t h;
+    ASSERT_EQ(dyn_hist_init(&h, 4), 0);
+    ASSERT_EQ(dyn_array_histogram_hash(&arr, &h, 1), 0);
+    ASSERT_EQ(dyn_array_histogram_hash(&arr, &h, 1), 0);
+    EXPECT_EQ(dyn_hist_get(&h, 5), 4u);
+    EXPECT_EQ(dyn_hist_get(&h, INT32_MIN), 2u);
+
+    dyn_hist_t uninit = {nullptr, nullptr, 0, 0};
+    EXPECT_EQ(dyn_array_histogram_hash(&arr, &uninit, 1), -1);
+
+    dyn_hist_free(&h);
+    dyn_array_free(&arr);
+}
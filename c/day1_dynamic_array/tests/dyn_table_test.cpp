@@ -0,0 +1,202 @@
+#include <gtest/gtest.h>
+#include <vector>
+
+extern "C" {
+#include "dyn_table.h"
+}
+
+static const dyn_col_type_t kTypes[] = {DYN_COL_INT, DYN_COL_INT64, DYN_COL_DOUBLE};
+
+static void append(dyn_table_t* t, int a, int64_t b, double c) {
+    dyn_cell_t row[3];
+    row[0].i = a;
+    row[1].i64 = b;
+    row[2].f64 = c;
+    ASSERT_EQ(dyn_table_append_row(t, row), 0);
+}
+
+TEST(DynTableTest, InitAndFree) {
+    dyn_table_t t;
+    EXPECT_EQ(dyn_table_init(&t, kTypes, 3, 0), 0);
+    EXPECT_EQ(t.ncols, 3u);
+    EXPECT_EQ(t.size, 0u);
+    EXPECT_EQ(t.capacity, 0u);
+
+    dyn_table_free(&t);
+    EXPECT_EQ(t.columns, nullptr);
+    dyn_table_free(&t);
+}
+
+TEST(DynTableTest, InitRejectsInvalidArgs) {
+    dyn_table_t t;
+    EXPECT_EQ(dyn_table_init(nullptr, kTypes, 3, 0), -1);
+    EXPECT_EQ(dyn_table_init(&t, nullptr, 3, 0), -1);
+    EXPECT_EQ(dyn_table_init(&t, kTypes, 0, 0), -1);
+}
+
+TEST(DynTableTest, AppendRowsGrowsColumnsTogether) {
+    dyn_table_t t;
+    ASSERT_EQ(dyn_table_init(&t, kTypes, 3, 1), 0);
+
+    for (int i = 0; i < 1000; ++i) {
+        append(&t, i, (int64_t)i * 1000000000LL, i * 0.5);
+    }
+    EXPECT_EQ(t.size, 1000u);
+    EXPECT_GE(t.capacity, t.size);
+
+    dyn_cell_t cell;
+    ASSERT_EQ(dyn_table_get(&t, 999, 0, &cell), 0);
+    EXPECT_EQ(cell.i, 999);
+    ASSERT_EQ(dyn_table_get(&t, 999, 1, &cell), 0);
+    EXPECT_EQ(cell.i64, 999000000000LL);
+    ASSERT_EQ(dyn_table_get(&t, 10, 2, &cell), 0);
+    EXPECT_DOUBLE_EQ(cell.f64, 5.0);
+
+    EXPECT_EQ(dyn_table_get(&t, 1000, 0, &cell), -1);
+    EXPECT_EQ(dyn_table_get(&t, 0, 3, &cell), -1);
+
+    dyn_table_free(&t);
+}
+
+TEST(DynTableTest, TypedColumnAccessChecksType) {
+    dyn_table_t t;
+    ASSERT_EQ(dyn_table_init(&t, kTypes, 3, 4), 0);
+    append(&t, 7, 8, 9.0);
+
+    ASSERT_NE(dyn_table_col_int(&t, 0), nullptr);
+    EXPECT_EQ(dyn_table_col_int(&t, 0)[0], 7);
+    EXPECT_EQ(dyn_table_col_int64(&t, 1)[0], 8);
+    EXPECT_EQ(dyn_table_col_double(&t, 2)[0], 9.0);
+
+    EXPECT_EQ(dyn_table_col_int(&t, 1), nullptr);
+    EXPECT_EQ(dyn_table_col_double(&t, 0), nullptr);
+    EXPECT_EQ(dyn_table_col_int64(&t, 5), nullptr);
+
+    dyn_table_free(&t);
+}
+
+TEST(DynTableTest, InitFromParallelArrays) {
+    dyn_array_t cols[2];
+    ASSERT_EQ(dyn_array_init(&cols[0], 4), 0);
+    ASSERT_EQ(dyn_array_init(&cols[1], 4), 0);
+    for (int i = 0; i < 4; ++i) {
+        dyn_array_push_back(&cols[0], i);
+        dyn_array_push_back(&cols[1], i * 10);
+    }
+
+    dyn_table_t t;
+    ASSERT_EQ(dyn_table_init_from_arrays(&t, cols, 2), 0);
+    EXPECT_EQ(t.size, 4u);
+    EXPECT_EQ(dyn_table_col_int(&t, 1)[3], 30);
+
+    dyn_table_free(&t);
+
+    // size mismatch is rejected
+    dyn_array_push_back(&cols[1], 40);
+    EXPECT_EQ(dyn_table_init_from_arrays(&t, cols, 2), -1);
+
+    dyn_array_free(&cols[0]);
+    dyn_array_free(&cols[1]);
+}
+
+TEST(DynTableTest, SelectRangeAndRefine) {
+    dyn_table_t t;
+    ASSERT_EQ(dyn_table_init(&t, kTypes, 3, 0), 0);
+    for (int i = 0; i < 100; ++i) {
+        append(&t, i, i % 10, i * 1.0);
+    }
+
+    dyn_sel_t sel, sel2;
+    ASSERT_EQ(dyn_sel_init(&sel, 0), 0);
+    ASSERT_EQ(dyn_sel_init(&sel2, 0), 0);
+
+    EXPECT_EQ(dyn_table_select_range_int(&t, 0, 20, 39, nullptr, &sel), 20);
+    EXPECT_EQ(sel.rows[0], 20u);
+    EXPECT_EQ(sel.rows[19], 39u);
+
+    // refine: rows 20..39 whose second column is 0..1
+    EXPECT_EQ(dyn_table_select_range_int64(&t, 1, 0, 1, &sel, &sel2), 4);
+    std::vector<size_t> got(sel2.rows, sel2.rows + sel2.size);
+    EXPECT_EQ(got, (std::vector<size_t>{20, 21, 30, 31}));
+
+    EXPECT_EQ(dyn_table_select_range_double(&t, 2, 98.5, 1000.0, nullptr, &sel), 1);
+    EXPECT_EQ(sel.rows[0], 99u);
+
+    // nothing selected
+    EXPECT_EQ(dyn_table_select_range_int(&t, 0, 500, 600, nullptr, &sel), 0);
+    EXPECT_EQ(sel.size, 0u);
+
+    // wrong column type / aliasing input and output
+    EXPECT_EQ(dyn_table_select_range_int(&t, 2, 0, 1, nullptr, &sel), -1);
+    EXPECT_EQ(dyn_table_select_range_int(&t, 0, 0, 1, &sel, &sel), -1);
+
+    dyn_sel_free(&sel);
+    dyn_sel_free(&sel2);
+    dyn_table_free(&t);
+}
+
+TEST(DynTableTest, SelectRangeAcrossBlocks) {
+    dyn_table_t t;
+    ASSERT_EQ(dyn_table_init(&t, kTypes, 3, 0), 0);
+    const int n = 1000;
+    for (int i = 0; i < n; ++i) {
+        append(&t, (i * 37) % 101, i, i * 0.5);
+    }
+
+    dyn_sel_t sel, sel2;
+    ASSERT_EQ(dyn_sel_init(&sel, 0), 0);
+    ASSERT_EQ(dyn_sel_init(&sel2, 0), 0);
+
+    std::vector<size_t> want;
+    for (int i = 0; i < n; ++i) {
+        if ((i * 37) % 101 <= 50) want.push_back(i);
+    }
+    ASSERT_EQ(dyn_table_select_range_int(&t, 0, 0, 50, nullptr, &sel), (long)want.size());
+    EXPECT_EQ(std::vector<size_t>(sel.rows, sel.rows + sel.size), want);
+
+    std::vector<size_t> want2;
+    for (size_t r : want) {
+        if (r >= 300 && r < 700) want2.push_back(r);
+    }
+    ASSERT_EQ(dyn_table_select_range_int64(&t, 1, 300, 699, &sel, &sel2), (long)want2.size());
+    EXPECT_EQ(std::vector<size_t>(sel2.rows, sel2.rows + sel2.size), want2);
+
+    dyn_sel_free(&sel);
+    dyn_sel_free(&sel2);
+    dyn_table_free(&t);
+}
+
+TEST(DynTableTest, SumWithAndWithoutSelection) {
+    dyn_table_t t;
+    ASSERT_EQ(dyn_table_init(&t, kTypes, 3, 0), 0);
+    for (int i = 1; i <= 10; ++i) {
+        append(&t, i, (int64_t)i << 32, i * 0.25);
+    }
+
+    int64_t isum = 0;
+    ASSERT_EQ(dyn_table_sum_int(&t, 0, nullptr, &isum), 0);
+    EXPECT_EQ(isum, 55);
+    ASSERT_EQ(dyn_table_sum_int(&t, 1, nullptr, &isum), 0);
+    EXPECT_EQ(isum, 55LL << 32);
+
+    double dsum = 0.0;
+    ASSERT_EQ(dyn_table_sum_double(&t, 2, nullptr, &dsum), 0);
+    EXPECT_DOUBLE_EQ(dsum, 13.75);
+    EXPECT_EQ(dyn_table_sum_double(&t, 0, nullptr, &dsum), -1);
+
+    dyn_sel_t sel;
+    ASSERT_EQ(dyn_sel_init(&sel, 0), 0);
+    ASSERT_EQ(dyn_table_select_range_int(&t, 0, 1, 3, nullptr, &sel), 3);
+    ASSERT_EQ(dyn_table_sum_int(&t, 0, &sel, &isum), 0);
+    EXPECT_EQ(isum, 6);
+
+    // a selected row past the end is rejected, not read
+    sel.rows[1] = 10;
+    isum = -7;
+    EXPECT_EQ(dyn_table_sum_int(&t, 0, &sel, &isum), -1);
+    EXPECT_EQ(isum, -7);
+    EXPECT_EQ(dyn_table_sum_double(&t, 2, &sel, &dsum), -1);
+
+    dyn_sel_free(&sel);
+    dyn_table_free(&t);
+}
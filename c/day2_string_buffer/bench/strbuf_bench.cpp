@@ -0,0 +1,194 @@
+// Micro-benchmarks for strbuf; not part of ctest. Run ./strbuf_bench.
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+extern "C" {
+#include "strbuf.h"
+#include "strbuf_io.h"
+}
+
+template <typename Fn>
+static void bench(const char* name, size_t items, Fn fn) {
+    auto t0 = std::chrono::steady_clock::now();
+    fn();
+    auto t1 = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+    printf("%-32s %8.2f ns/item\n", name, ns / (double)items);
+}
+
+static void bench_numbers() {
+    const size_t n = 2000000;
+    std::mt19937_64 rng(1);
+    std::vector<int64_t> ints(n);
+    std::vector<double> dbls(n);
+    for (size_t i = 0; i < n; ++i) {
+        ints[i] = (int64_t)(rng() >> (rng() % 64));
+        dbls[i] = (double)(rng() % 100000000) / (double)(1 + rng() % 10000);
+    }
+
+    strbuf_t sb;
+    strbuf_init(&sb, 0);
+    char tmp[32];
+
+    bench("snprintf %lld + append_n", n, [&] {
+        strbuf_clear(&sb);
+        for (int64_t v : ints) {
+            int len = snprintf(tmp, sizeof(tmp), "%" PRId64, v);
+            strbuf_append_n(&sb, tmp, (size_t)len);
+        }
+    });
+    bench("strbuf_append_int", n, [&] {
+        strbuf_clear(&sb);
+        for (int64_t v : ints) strbuf_append_int(&sb, v);
+    });
+    bench("snprintf %llx + append_n", n, [&] {
+        strbuf_clear(&sb);
+        for (int64_t v : ints) {
+            int len = snprintf(tmp, sizeof(tmp), "%" PRIx64, (uint64_t)v);
+            strbuf_append_n(&sb, tmp, (size_t)len);
+        }
+    });
+    bench("strbuf_append_hex", n, [&] {
+        strbuf_clear(&sb);
+        for (int64_t v : ints) strbuf_append_hex(&sb, (uint64_t)v);
+    });
+    bench("snprintf %.17g + append_n", n, [&] {
+        strbuf_clear(&sb);
+        for (double v : dbls) {
+            int len = snprintf(tmp, sizeof(tmp), "%.17g", v);
+            strbuf_append_n(&sb, tmp, (size_t)len);
+        }
+    });
+    bench("strbuf_append_double", n, [&] {
+        strbuf_clear(&sb);
+        for (double v : dbls) strbuf_append_double(&sb, v);
+    });
+
+    strbuf_free(&sb);
+}
+
+static void bench_lines() {
+    const size_t n = 2000000;
+    std::mt19937 rng(2);
+    FILE* f = tmpfile();
+    if (f == nullptr) return;
+    for (size_t i = 0; i < n; ++i) {
+        fprintf(f, "%*zu\n", (int)(rng() % 120), i);
+    }
+    fflush(f);
+
+    strbuf_t sb;
+    strbuf_init(&sb, 0);
+    char line[256];
+
+    rewind(f);
+    bench("fgets + append_cstr", n, [&] {
+        while (fgets(line, sizeof(line), f)) {
+            strbuf_clear(&sb);
+            strbuf_append_cstr(&sb, line);
+        }
+    });
+
+    size_t total = 0;
+    lseek(fileno(f), 0, SEEK_SET);
+    bench("strbuf_read_line", n, [&] {
+        strbuf_line_reader_t lr;
+        strbuf_line_reader_init(&lr, fileno(f), 0);
+        const char* p;
+        size_t len;
+        while (strbuf_read_line(&lr, &p, &len) == 1) total += len;
+        strbuf_line_reader_free(&lr);
+    });
+
+    strbuf_free(&sb);
+    fclose(f);
+    printf("(%zu bytes of lines)\n", total);
+}
+
+static void bench_utf8() {
+    const size_t n = 64u << 20;
+    std::mt19937 rng(3);
+    strbuf_t sb;
+    strbuf_init(&sb, 0);
+    // mostly ASCII with some 2- and 3-byte sequences
+    while (sb.size < n) {
+        unsigned r = rng() % 16;
+        if (r == 0) strbuf_append_cstr(&sb, "\xC3\xA9");
+        else if (r == 1) strbuf_append_cstr(&sb, "\xE2\x82\xAC");
+        else strbuf_append_n(&sb, "abcdefgh" + r % 8, 1);
+    }
+
+    int valid = 0;
+    size_t length = 0;
+    bench("strbuf_validate_utf8 (per byte)", sb.size, [&] { valid = strbuf_validate_utf8(&sb); });
+    bench("strbuf_utf8_length (per byte)", sb.size, [&] { length = strbuf_utf8_length(&sb); });
+    printf("(valid %d, %zu code points)\n", valid, length);
+
+    strbuf_free(&sb);
+}
+
+static void bench_hash() {
+    const size_t n = 64u << 20;
+    std::string big(n, 'x');
+    strbuf_t sb;
+    strbuf_init(&sb, 0);
+    strbuf_append_n(&sb, big.data(), big.size());
+
+    uint64_t h = 0;
+    bench("strbuf_hash_bytes (per byte)", n, [&] { h ^= strbuf_hash_bytes(sb.data, sb.size, 0); });
+
+    // repeated lookups with the same short key
+    const size_t lookups = 10000000;
+    strbuf_t key;
+    strbuf_init(&key, 0);
+    strbuf_append_cstr(&key, "content-type: application/json");
+    bench("strbuf_hash_bytes 31-byte key", lookups, [&] {
+        for (size_t i = 0; i < lookups; ++i) h ^= strbuf_hash_bytes(key.data, key.size, i);
+    });
+    bench("strbuf_hash cached 31-byte key", lookups, [&] {
+        for (size_t i = 0; i < lookups; ++i) h += strbuf_hash(&key);
+    });
+    printf("(hash %llx)\n", (unsigned long long)h);
+
+    strbuf_free(&key);
+    strbuf_free(&sb);
+}
+
+static void bench_crc() {
+    const size_t n = 64u << 20;
+    std::mt19937 rng(9);
+    std::string data(n, '\0');
+    for (auto& c : data) c = (char)rng();
+
+    uint32_t crc = 0;
+    bench("strbuf_crc32c_update (per byte)", n, [&] { crc ^= strbuf_crc32c_update(0, data.data(), n); });
+
+    // 64-byte records appended to a tracked buffer vs. checksumming afterwards
+    strbuf_t sb;
+    strbuf_init(&sb, 0);
+    strbuf_reserve(&sb, n);
+    bench("append_n + tracked crc (per byte)", n, [&] {
+        strbuf_clear(&sb);
+        strbuf_crc32c_track(&sb);
+        for (size_t off = 0; off < n; off += 64) strbuf_append_n(&sb, &data[off], 64);
+        crc ^= strbuf_crc32c(&sb);
+    });
+    printf("(crc %08x)\n", crc);
+
+    strbuf_free(&sb);
+}
+
+int main() {
+    bench_numbers();
+    bench_lines();
+    bench_utf8();
+    bench_hash();
+    bench_crc();
+    return 0;
+}
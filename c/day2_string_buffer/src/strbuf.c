@@ -1,4 +1,8 @@
 #include "strbuf.h"
+#include "strbuf_priv.h"
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -7,13 +11,118 @@
 
 static const char kEmptyStr[] = "";
 
-// static int ensure_capacity(strbuf_t* sb, size_t min_capacity)
-// {
-//     /* TODO: grow sb->capacity to at least min_capacity bytes */
-//     /* min_capacity counts bytes including the required trailing '\0'. */
-//     (void)sb; (void)min_capacity;
-//     return ERR;
-// }
+#define MIN_GROW_CAPACITY (16)
+
+/* Resize the allocation to exactly new_capacity bytes (new_capacity > size). */
+static int grow_to(strbuf_t* sb, size_t new_capacity)
+{
+    if ((sb->flags & (STRBUF_F_ARENA | STRBUF_F_INLINE)) == STRBUF_F_ARENA && sb->data &&
+        strbuf_arena_extend(sb, new_capacity) == OK) {
+        return OK;
+    }
+
+    if (sb->flags & (STRBUF_F_MAPPED | STRBUF_F_INLINE | STRBUF_F_ARENA)) {
+        /* move the content out of storage that cannot be realloc'ed */
+        char *mem_chunk;
+        if (sb->flags & STRBUF_F_ARENA) {
+            mem_chunk = strbuf_arena_take(sb->arena, new_capacity);
+        } else {
+            mem_chunk = malloc(new_capacity);
+        }
+        if (mem_chunk == NULL) {
+            return ERR;
+        }
+        if (sb->data) {
+            memcpy(mem_chunk, sb->data, sb->size);
+        }
+        mem_chunk[sb->size] = '\0';
+        if (sb->flags & STRBUF_F_MAPPED) {
+            strbuf_unmap(sb);
+        }
+        if (sb->flags & STRBUF_F_INLINE) {
+            /* the heap-only fields held inline bytes until now; this
+             * overwrites the old copy, so callers reading from it must
+             * relocate their pointers into the new storage */
+            sb->arena = NULL;
+            sb->crc_len = 0;
+            sb->flags &= ~STRBUF_F_HASHED;
+            if (sb->flags & STRBUF_F_CRC) {
+                sb->crc = strbuf_crc32c_update(0, mem_chunk, sb->size);
+                sb->crc_len = sb->size;
+            }
+        }
+        sb->data = mem_chunk;
+        sb->capacity = new_capacity;
+        sb->flags &= ~(STRBUF_F_MAPPED | STRBUF_F_INLINE);
+        return OK;
+    }
+
+    char *mem_chunk = realloc(sb->data, new_capacity);
+
+    if (mem_chunk == NULL) {
+        return ERR;
+    }
+
+    if (sb->data == NULL) {
+        /* lazy alloc: nothing to preserve, just terminate */
+        mem_chunk[0] = '\0';
+    }
+
+    sb->data = mem_chunk;
+    sb->capacity = new_capacity;
+    return OK;
+}
+
+/* Point an unallocated buffer at its inline storage (never an arena
+ * buffer: inline_buf overlays the arena pointer). */
+static void use_inline(strbuf_t* sb)
+{
+    sb->data = sb->inline_buf;
+    sb->data[0] = '\0';
+    sb->capacity = STRBUF_INLINE_CAP;
+    sb->flags |= STRBUF_F_INLINE;
+}
+
+/* Make room for extra more bytes after size, plus the trailing '\0'.
+ * Capacity grows geometrically so a sequence of appends is amortized O(1)
+ * per byte, and realloc lets the allocator extend the block in place.
+ */
+static int ensure_capacity(strbuf_t* sb, size_t extra)
+{
+    if (extra > SIZE_MAX - sb->size - 1) {
+        /* Overflow */
+        return ERR;
+    }
+
+    size_t min_capacity = sb->size + extra + 1;
+
+    /* a mapped view only has to move once bytes are actually written */
+    if (sb->data && min_capacity <= sb->capacity &&
+        (extra == 0 || !(sb->flags & STRBUF_F_MAPPED))) {
+        return OK;
+    }
+
+    if (sb->data == NULL && min_capacity <= STRBUF_INLINE_CAP && !(sb->flags & STRBUF_F_ARENA)) {
+        /* first allocation of a short string */
+        use_inline(sb);
+        return OK;
+    }
+
+    size_t new_capacity;
+    if (sb->capacity > SIZE_MAX / 2) {
+        new_capacity = SIZE_MAX;
+    } else {
+        new_capacity = sb->capacity * 2;
+    }
+    if (new_capacity < MIN_GROW_CAPACITY) {
+        new_capacity = MIN_GROW_CAPACITY;
+    }
+    if (new_capacity < min_capacity) {
+        new_capacity = min_capacity;
+    }
+
+    return grow_to(sb, new_capacity);
+}
 
 int strbuf_init(strbuf_t* sb, size_t initial_capacity)
 {
@@ -24,6 +133,17 @@ int strbuf_init(strbuf_t* sb, size_t initial_capacity)
         return ERR;
     }
 
+    sb->size = 0;
+    sb->flags = 0;
+    sb->arena = NULL;
+    sb->crc = 0;
+    sb->crc_len = 0;
+
+    if (initial_capacity > 0 && initial_capacity <= STRBUF_INLINE_CAP) {
+        use_inline(sb);
+        return OK;
+    }
+
     if (initial_capacity == 0) {
         /* lazy alloc */
         mem_chunk = NULL;
@@ -40,7 +160,6 @@ int strbuf_init(strbuf_t* sb, size_t initial_capacity)
     }
 
     sb->data = mem_chunk;
-    sb->size = 0;
     sb->capacity = initial_capacity;
 
     return ret;
@@ -52,13 +171,40 @@ void strbuf_free(strbuf_t* sb)
         return;
     }
 
-    char *mem_chunk = sb->data;
+    if (sb->flags & STRBUF_F_MAPPED) {
+        strbuf_unmap(sb);
+    } else if (sb->flags & STRBUF_F_INLINE) {
+        /* nothing to release */
+    } else if (sb->flags & STRBUF_F_ARENA) {
+        strbuf_arena_release(sb);
+    } else {
+        free(sb->data);
+    }
 
     sb->data = NULL;
     sb->size = 0;
     sb->capacity = 0;
+    sb->flags = 0;
+    sb->arena = NULL;
+}
+
+void strbuf_move(strbuf_t* dst, strbuf_t* src)
+{
+    if (dst == NULL || src == NULL || dst == src) {
+        return;
+    }
+
+    *dst = *src;
+    if (src->flags & STRBUF_F_INLINE) {
+        /* re-point at dst's own copy of the inline bytes */
+        dst->data = dst->inline_buf;
+    }
 
-    free(mem_chunk);
+    src->data = NULL;
+    src->size = 0;
+    src->capacity = 0;
+    src->flags = 0;
+    src->arena = NULL;
 }
 
 const char* strbuf_c_str(const strbuf_t* sb)
@@ -80,112 +226,217 @@ int strbuf_append_cstr(strbuf_t* sb, const char* suffix)
         return ERR;
     }
 
-    size_t suffix_len = strlen(suffix);
-    size_t vacant_len = sb->capacity - sb->size - 1;
+    return strbuf_append_n(sb, suffix, strlen(suffix));
+}
 
-    if (suffix_len == 0) {
-        /* suffix is '\0' */
-        return OK;
+void strbuf_appended(strbuf_t* sb)
+{
+    sb->flags &= ~STRBUF_F_HASHED;
+
+    /* an inline buffer has no crc_len; its CRC is computed on demand */
+    if ((sb->flags & (STRBUF_F_CRC | STRBUF_F_INLINE)) == STRBUF_F_CRC && sb->crc_len <= sb->size) {
+        sb->crc = strbuf_crc32c_update(sb->crc, &sb->data[sb->crc_len], sb->size - sb->crc_len);
+        sb->crc_len = sb->size;
     }
+}
 
-    if (sb->data && suffix_len <= vacant_len) {
-        /* we have place in memory - store and return */
-        memcpy(&sb->data[sb->size], suffix, suffix_len);
-        sb->size += suffix_len;
-        /* terminate with NUL */
-        sb->data[sb->size] = '\0';
-        return OK;
+void strbuf_truncate(strbuf_t* sb, size_t size)
+{
+    sb->size = size;
+    if (!(sb->flags & STRBUF_F_MAPPED)) {
+        /* a mapping is read-only; nothing was appended to it */
+        sb->data[size] = '\0';
     }
+    sb->flags &= ~STRBUF_F_HASHED;
 
-    /* need to grow or lazy alloc */
-    /* TODO: watchout the sb->capacity overflow */
-    size_t new_capacity = sb->capacity + suffix_len;
+    if ((sb->flags & (STRBUF_F_CRC | STRBUF_F_INLINE)) == STRBUF_F_CRC && sb->crc_len > size) {
+        /* the next append checksums the content again from the start */
+        sb->crc = 0;
+        sb->crc_len = 0;
+    }
+}
 
-    char *old_mem_chunk = sb->data;
-    char *new_mem_chunk = calloc(new_capacity, sizeof(char));
+/* Address of p after sb's storage moved from old_data to sb->data, for
+ * pointers into the old content; other pointers are returned unchanged.
+ */
+static const char* relocate(const strbuf_t* sb, const char* old_data, size_t old_size, const char* p)
+{
+    if (old_data && p >= old_data && p < old_data + old_size) {
+        return sb->data + (p - old_data);
+    }
+    return p;
+}
 
-    if (new_mem_chunk == NULL) {
+int strbuf_append_n(strbuf_t* sb, const char* s, size_t n)
+{
+    if (sb == NULL || (s == NULL && n > 0)) {
         return ERR;
     }
 
-    if (sb->size == 0 && old_mem_chunk == NULL) {
-        /* lazy alloc */
-        new_capacity++;
-    } else {
-        memcpy(new_mem_chunk, old_mem_chunk, sb->size);
+    if (n == 0) {
+        return OK;
     }
-    memcpy(new_mem_chunk + sb->size, suffix, suffix_len);
-    sb->data = new_mem_chunk;
-    sb->size += suffix_len;
-    sb->capacity = new_capacity;
-    /* termination */
-    sb->data[sb->size] = '\0';
 
-    if (old_mem_chunk != NULL) {
-        free(old_mem_chunk);
+    /* s may point into sb, whose storage growth can free */
+    const char* old_data = sb->data;
+    size_t old_size = sb->size;
+    if (ensure_capacity(sb, n) != OK) {
+        return ERR;
     }
+    s = relocate(sb, old_data, old_size, s);
+
+    memcpy(&sb->data[sb->size], s, n);
+    sb->size += n;
+    /* terminate with NUL */
+    sb->data[sb->size] = '\0';
+    strbuf_appended(sb);
+
     return OK;
 }
 
-int strbuf_append_n(strbuf_t* sb, const char* s, size_t n)
+/* Copy pieces[0..count) joined by sep[0..sep_len) to the end of sb. */
+static int append_joined(strbuf_t* sb, const strbuf_view_t* pieces, size_t count,
+                         const char* sep, size_t sep_len)
 {
-    if (sb == NULL || (s == NULL && n > 0)) {
+    if (sb == NULL || (pieces == NULL && count > 0)) {
         return ERR;
     }
 
-    size_t suffix_len = n;
-    size_t vacant_len = sb->capacity - sb->size - 1;
+    size_t total = count > 1 ? sep_len * (count - 1) : 0;
+    if (count > 1 && sep_len > 0 && total / sep_len != count - 1) {
+        return ERR;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (pieces[i].data == NULL && pieces[i].size > 0) {
+            return ERR;
+        }
+        if (pieces[i].size > SIZE_MAX - total) {
+            return ERR;
+        }
+        total += pieces[i].size;
+    }
 
-    if (suffix_len == 0) {
+    if (total == 0) {
         return OK;
     }
 
-    if (sb->data && suffix_len <= vacant_len) {
-        /* we have place in memory - store and return */
-        memcpy(&sb->data[sb->size], s, suffix_len);
-        sb->size += suffix_len;
-        /* terminate with NUL */
-        sb->data[sb->size] = '\0';
-        return OK;
+    /* pieces inside sb move with it if the buffer is reallocated */
+    const char* old_data = sb->data;
+    size_t old_size = sb->size;
+    if (ensure_capacity(sb, total) != OK) {
+        return ERR;
     }
 
-    /* need to grow or lazy alloc */
-    /* TODO: watchout the sb->capacity overflow */
-    size_t new_capacity = sb->capacity + suffix_len;
+    sep = relocate(sb, old_data, old_size, sep);
 
-    char *old_mem_chunk = sb->data;
-    char *new_mem_chunk = calloc(new_capacity, sizeof(char));
+    char* out = &sb->data[sb->size];
+    for (size_t i = 0; i < count; i++) {
+        const char* src = relocate(sb, old_data, old_size, pieces[i].data);
+        if (i > 0 && sep_len > 0) {
+            memcpy(out, sep, sep_len);
+            out += sep_len;
+        }
+        if (pieces[i].size) {
+            memcpy(out, src, pieces[i].size);
+            out += pieces[i].size;
+        }
+    }
+
+    sb->size += total;
+    sb->data[sb->size] = '\0';
+    strbuf_appended(sb);
+    return OK;
+}
 
-    if (new_mem_chunk == NULL) {
+int strbuf_append_iov(strbuf_t* sb, const strbuf_view_t* pieces, size_t count)
+{
+    return append_joined(sb, pieces, count, NULL, 0);
+}
+
+int strbuf_join(strbuf_t* sb, const strbuf_view_t* pieces, size_t count, const char* sep)
+{
+    return append_joined(sb, pieces, count, sep, sep ? strlen(sep) : 0);
+}
+
+int strbuf_vappendf(strbuf_t* sb, const char* fmt, va_list ap)
+{
+    if (sb == NULL || fmt == NULL) {
         return ERR;
     }
 
-    if (sb->size == 0 && old_mem_chunk == NULL) {
-        /* lazy alloc */
-        new_capacity++;
-    } else {
-        memcpy(new_mem_chunk, old_mem_chunk, sb->size);
+    va_list ap_retry;
+    va_copy(ap_retry, ap);
+
+    /* first attempt goes straight into the spare capacity */
+    size_t vacant_len = 0;
+    if (sb->data && !(sb->flags & STRBUF_F_MAPPED)) {
+        vacant_len = sb->capacity - sb->size;
     }
-    memcpy(new_mem_chunk + sb->size, s, suffix_len);
-    sb->data = new_mem_chunk;
-    sb->size += suffix_len;
-    sb->capacity = new_capacity;
-    /* termination */
-    sb->data[sb->size] = '\0';
+    int len = vsnprintf(vacant_len ? &sb->data[sb->size] : NULL, vacant_len, fmt, ap);
+
+    if (len > 0 && (size_t)len >= vacant_len) {
+        /* did not fit: grow once to the exact size and format again */
+        if (ensure_capacity(sb, (size_t)len) == OK) {
+            vsnprintf(&sb->data[sb->size], (size_t)len + 1, fmt, ap_retry);
+        } else {
+            len = -1;
+        }
+    }
+    va_end(ap_retry);
 
-    if (old_mem_chunk != NULL) {
-        free(old_mem_chunk);
+    if (len < 0) {
+        /* a truncated attempt may have overwritten the terminator */
+        if (sb->data && !(sb->flags & STRBUF_F_MAPPED)) {
+            sb->data[sb->size] = '\0';
+        }
+        return ERR;
     }
+
+    sb->size += (size_t)len;
+    strbuf_appended(sb);
     return OK;
 }
 
+int strbuf_appendf(strbuf_t* sb, const char* fmt, ...)
+{
+    va_list ap;
+
+    va_start(ap, fmt);
+    int ret = strbuf_vappendf(sb, fmt, ap);
+    va_end(ap);
+
+    return ret;
+}
+
+int strbuf_reserve(strbuf_t* sb, size_t additional)
+{
+    if (sb == NULL) {
+        return ERR;
+    }
+
+    return ensure_capacity(sb, additional);
+}
+
 void strbuf_clear(strbuf_t* sb)
 {
     if (sb == NULL) {
         return;
     }
 
+    if (sb->flags & STRBUF_F_MAPPED) {
+        /* nothing worth copying: drop the view, become lazy-empty */
+        strbuf_unmap(sb);
+        sb->data = NULL;
+        sb->capacity = 0;
+        sb->flags &= ~STRBUF_F_MAPPED;
+    }
+
     sb->size = 0;
+    sb->flags &= ~STRBUF_F_HASHED;
+    sb->crc = 0;
+    if (!(sb->flags & STRBUF_F_INLINE)) {
+        sb->crc_len = 0;
+    }
 
     if (sb->data) {
         /* not lazy alloc */
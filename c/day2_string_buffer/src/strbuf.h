@@ -1,16 +1,73 @@
 #ifndef STRBUF_H
 #define STRBUF_H
 
+#include <stdarg.h>
 #include <stddef.h>
+#include <stdint.h>
+
+#if defined(__GNUC__)
+#define STRBUF_PRINTF(fmt_idx, args_idx) __attribute__((format(printf, fmt_idx, args_idx)))
+#else
+#define STRBUF_PRINTF(fmt_idx, args_idx)
+#endif
+
+/* "not found" result of the search functions */
+#define STRBUF_NPOS ((size_t)-1)
+
+/* Strings shorter than STRBUF_INLINE_CAP bytes are kept in the struct
+ * itself (small-string optimization): data then points at inline_buf and no
+ * heap memory is used until the content outgrows it. inline_buf shares its
+ * bytes with the fields only a heap buffer needs (arena, hash, crc_len), so
+ * the struct is no larger than without it; arena-backed buffers therefore
+ * never go inline, and an inline buffer computes its hash and tracked CRC
+ * on demand instead of caching them.
+ *
+ * Because data may point into the struct, a strbuf_t must not be copied or
+ * moved by value (assignment, memcpy, realloc of an array of them) while in
+ * use; transfer one with strbuf_move.
+ */
+#define STRBUF_INLINE_CAP (24)
+
+/* strbuf_t.flags
+ * Any call that writes to a read-only buffer (STRBUF_F_MAPPED) first turns it
+ * into an ordinary heap buffer holding a copy of the content; appending
+ * nothing, or reserving 0 bytes, leaves the mapping in place.
+ */
+#define STRBUF_F_MAPPED (1u << 0) // data is a read-only file mapping (strbuf_map_file)
+#define STRBUF_F_INLINE (1u << 1) // data points at inline_buf
+#define STRBUF_F_ARENA  (1u << 2) // storage comes from arena (strbuf_init_arena)
+#define STRBUF_F_HASHED (1u << 3) // hash holds strbuf_hash of the current content
+#define STRBUF_F_CRC    (1u << 4) // crc is kept up to date by appends (strbuf_crc32c_track)
+
+struct strbuf_arena;
 
 typedef struct {
-    char*  data;     // NUL-terminated
-    size_t size;     // number of characters excluding the final '\0'
-    size_t capacity; // allocated bytes in data (including space for '\0')
+    char*    data;     // NUL-terminated
+    size_t   size;     // number of characters excluding the final '\0'
+    size_t   capacity; // allocated bytes in data (including space for '\0')
+    unsigned flags;    // STRBUF_F_* storage mode and cache bits
+    uint32_t crc;      // CRC-32C of data[0..crc_len) if STRBUF_F_CRC
+    union {
+        char inline_buf[STRBUF_INLINE_CAP]; // if STRBUF_F_INLINE
+        struct {                            // otherwise
+            struct strbuf_arena* arena;     // owner of data if STRBUF_F_ARENA
+            uint64_t             hash;      // cached strbuf_hash if STRBUF_F_HASHED
+            size_t               crc_len;
+        };
+    };
 } strbuf_t;
 
+/* Non-owning reference to size bytes at data; not NUL-terminated.
+ * Valid only while the buffer it points into is neither modified nor freed.
+ */
+typedef struct {
+    const char* data;
+    size_t      size;
+} strbuf_view_t;
+
 /* Initialize with initial_capacity bytes (including space for '\0').
  * If initial_capacity == 0, initialize as empty with capacity 0 (lazy alloc).
+ * Up to STRBUF_INLINE_CAP bytes are served from the inline buffer.
  * Returns 0 on success, -1 on allocation failure or invalid args.
  */
 int strbuf_init(strbuf_t* sb, size_t initial_capacity);
@@ -18,6 +75,11 @@ int strbuf_init(strbuf_t* sb, size_t initial_capacity);
 /* Free resources; safe to call multiple times. */
 void strbuf_free(strbuf_t* sb);
 
+/* Transfer the content of src to dst, leaving src empty (lazy).
+ * dst must not hold a buffer (freed or never initialized).
+ */
+void strbuf_move(strbuf_t* dst, strbuf_t* src);
+
 /* Return internal C-string pointer.
  * Must never return NULL; return "" for empty/unallocated buffers.
  */
@@ -30,9 +92,185 @@ int strbuf_append_cstr(strbuf_t* sb, const char* suffix);
 
 /* Append exactly n bytes from s (bytes may include '\0'; treat as raw bytes).
  * Still ensure the buffer remains NUL-terminated at sb->data[sb->size].
+ * s may point into sb's own content.
  */
 int strbuf_append_n(strbuf_t* sb, const char* s, size_t n);
 
+/* Append printf-style formatted text.
+ * Formats straight into the spare capacity; if the result does not fit the
+ * buffer grows once to the exact needed size and formatting is redone.
+ * Returns 0 on success, -1 on allocation failure, encoding error or invalid args
+ * (content is left unchanged on failure).
+ */
+int strbuf_appendf(strbuf_t* sb, const char* fmt, ...) STRBUF_PRINTF(2, 3);
+int strbuf_vappendf(strbuf_t* sb, const char* fmt, va_list ap) STRBUF_PRINTF(2, 0);
+
+/* Append the concatenation of pieces[0..count), or with strbuf_join the
+ * pieces separated by the C-string sep (NULL for none). The total length is
+ * computed first, so the buffer grows at most once and every piece is
+ * copied straight into place. Pieces may point into sb itself.
+ * Returns 0 on success, -1 on allocation failure, overflow or invalid args
+ * (content is then unchanged).
+ */
+int strbuf_append_iov(strbuf_t* sb, const strbuf_view_t* pieces, size_t count);
+int strbuf_join(strbuf_t* sb, const strbuf_view_t* pieces, size_t count, const char* sep);
+
+/* Append the decimal text of an integer (as printf "%lld" / "%llu"),
+ * the lowercase hexadecimal digits of value without prefix (as "%llx"), or
+ * the shortest text that parses back to the same double (Grisu2).
+ * Doubles use plain notation for 1e-5 <= |v| < 1e21 and "d.ddde+XX"
+ * otherwise; non-finite values are "nan", "inf" and "-inf".
+ * Returns 0 on success, -1 on allocation failure or invalid args.
+ */
+int strbuf_append_int(strbuf_t* sb, int64_t value);
+int strbuf_append_uint64(strbuf_t* sb, uint64_t value);
+int strbuf_append_hex(strbuf_t* sb, uint64_t value);
+int strbuf_append_double(strbuf_t* sb, double value);
+
+/* Binary-to-text codecs (RFC 4648 base64 with padding, lowercase hex).
+ * The encoders reserve the exact output size once and write into it; the
+ * decoders append the decoded bytes and accept hex digits in either case.
+ * With AVX2 both directions work on 32 characters per step and the
+ * decoders validate whole blocks before converting them.
+ * Returns 0 on success, -1 on allocation failure or invalid args; the
+ * decoders also return -1 for malformed input (wrong length, a character
+ * outside the alphabet, misplaced '='), leaving the content unchanged.
+ */
+int strbuf_append_base64(strbuf_t* sb, const void* data, size_t n);
+int strbuf_decode_base64(strbuf_t* sb, const char* s, size_t n);
+int strbuf_append_hex_bytes(strbuf_t* sb, const void* data, size_t n);
+int strbuf_decode_hex(strbuf_t* sb, const char* s, size_t n);
+
+/* Escaping appenders. Bytes that need work are found 32 (AVX2) or 16 (SSE2)
+ * at a time and the clean runs between them are copied with one append each.
+ * s may point into sb's own content.
+ */
+
+/* Append s[0..n) escaped for use inside a JSON string literal (the quotes
+ * themselves are not added): '"', '\\' and control characters become
+ * \", \\, \b, \f, \n, \r, \t or \u00XX; all other bytes, including UTF-8
+ * sequences, are copied unchanged.
+ * Returns 0 on success, -1 on allocation failure or invalid args.
+ */
+int strbuf_append_json_escaped(strbuf_t* sb, const char* s, size_t n);
+
+/* Append s[0..n) as one CSV field (RFC 4180) for delimiter delim: fields
+ * containing delim, '"', '\n' or '\r' are wrapped in quotes with inner
+ * quotes doubled, all others are copied as they are.
+ * Returns 0 on success, -1 on allocation failure or invalid args.
+ */
+int strbuf_append_csv_escaped(strbuf_t* sb, const char* s, size_t n, char delim);
+
+/* Search the raw bytes data[0..size) (embedded '\0' bytes included).
+ * find_byte/find return the offset of the first match at or after start,
+ * rfind the offset of the last match; STRBUF_NPOS if there is none.
+ * An empty needle matches at start (find) or at size (rfind).
+ * Candidates are filtered 16 positions at a time on the needle's first and
+ * last byte; inputs that defeat the filter fall back to Two-Way matching,
+ * so the worst case stays linear.
+ */
+size_t strbuf_find_byte(const strbuf_t* sb, size_t start, char c);
+size_t strbuf_find(const strbuf_t* sb, size_t start, const char* needle, size_t needle_len);
+size_t strbuf_rfind(const strbuf_t* sb, const char* needle, size_t needle_len);
+
+/* Iterator splitting a buffer into the fields between delimiter bytes.
+ * n delimiters give n + 1 fields, empty ones included (an empty buffer is
+ * one empty field), like Python's str.split(sep). Fields are views into the
+ * buffer; nothing is allocated or copied. Delimiter positions are found 64
+ * bytes at a time into a bitmap that later calls consume bit by bit.
+ */
+typedef struct {
+    const char*   data;
+    size_t        size;
+    size_t        pos;       // start of the next field
+    size_t        scan;      // bytes before scan are already in bits
+    size_t        base;      // offset of bit 0 of bits
+    uint64_t      bits;      // delimiter positions not yet returned
+    uint64_t      table[4];  // the delimiter set as a 256-bit bitmap
+    unsigned char delims[8]; // the set itself, compared with SIMD
+    unsigned      ndelims;   // entries in delims; 0 for larger sets
+    int           done;
+} strbuf_split_t;
+
+/* Split sb on a single delimiter byte, or on any byte of delims[0..n).
+ * sb must stay unmodified while the iterator is in use.
+ * Returns 0 on success, -1 on invalid args.
+ */
+int strbuf_split_init(strbuf_split_t* it, const strbuf_t* sb, char delim);
+int strbuf_split_init_any(strbuf_split_t* it, const strbuf_t* sb, const char* delims, size_t n);
+
+/* Store the next field in *field.
+ * Returns 1 if a field was stored, 0 after the last field, -1 on invalid args.
+ */
+int strbuf_split_next(strbuf_split_t* it, strbuf_view_t* field);
+
+/* UTF-8 checks (RFC 3629: no overlong forms, surrogates or code points
+ * above U+10FFFF).
+ * strbuf_validate_utf8 returns 1 if the content is valid UTF-8, 0 if not,
+ * -1 on invalid args. With AVX2 it uses the lookup-table algorithm of
+ * Keiser & Lemire, 32 bytes per step; otherwise a scalar check with an
+ * 8-byte ASCII fast path.
+ * strbuf_utf8_length returns the number of code points of valid content
+ * (for invalid content, the number of bytes that are not 10xxxxxx).
+ */
+int strbuf_validate_utf8(const strbuf_t* sb);
+size_t strbuf_utf8_length(const strbuf_t* sb);
+
+/* Append n bytes from s only if the content stays valid UTF-8, checking
+ * just the new bytes and the sequence they continue. The content may end
+ * in an incomplete sequence, so input can arrive in arbitrary chunks; call
+ * strbuf_validate_utf8 once it is complete.
+ * Returns 0 on success, -1 on invalid UTF-8 (content is left unchanged),
+ * allocation failure or invalid args.
+ */
+int strbuf_append_utf8(strbuf_t* sb, const char* s, size_t n);
+
+/* 64-bit non-cryptographic hash (wyhash) of n bytes at data; equal bytes
+ * and seed give equal hashes across calls and processes on one platform.
+ */
+uint64_t strbuf_hash_bytes(const void* data, size_t n, uint64_t seed);
+
+/* Hash of a view's bytes, with seed 0: equals strbuf_hash of a buffer
+ * holding the same content, so views can probe tables keyed by buffers.
+ */
+uint64_t strbuf_view_hash(strbuf_view_t v);
+
+/* Hash of the content with seed 0, cached in the buffer: repeated calls on
+ * an unchanged buffer are O(1) (inline buffers are short enough to hash
+ * again on every call). Every strbuf_* call that modifies the
+ * content drops the cached value; code writing sb->data directly must clear
+ * STRBUF_F_HASHED itself.
+ */
+uint64_t strbuf_hash(strbuf_t* sb);
+
+/* CRC-32C (Castagnoli, as used by iSCSI, ext4 and many storage formats).
+ * strbuf_crc32c_update extends crc (0 to start) by n more bytes, so
+ * update(update(0, a), b) equals the CRC of a followed by b. With SSE4.2
+ * three independent crc32 instruction chains run in parallel and are
+ * merged with PCLMUL carry-less multiplies where available; elsewhere a
+ * slicing-by-8 table is used.
+ */
+uint32_t strbuf_crc32c_update(uint32_t crc, const void* data, size_t n);
+
+/* CRC-32C of the content. On a tracked buffer only the bytes appended since
+ * the last append call are left to checksum, normally none.
+ */
+uint32_t strbuf_crc32c(const strbuf_t* sb);
+
+/* Start tracking the CRC-32C of sb: the current content is checksummed
+ * once, then every strbuf_* append folds its new bytes into sb->crc while
+ * they are still in cache, and clearing resets it.
+ * Returns 0 on success, -1 on invalid args.
+ */
+int strbuf_crc32c_track(strbuf_t* sb);
+
+/* Make room for at least `additional` more bytes (plus the '\0') so the
+ * following appends of that many bytes do not reallocate.
+ * Capacity grows geometrically; never shrinks.
+ * Returns 0 on success, -1 on allocation failure, overflow or invalid args.
+ */
+int strbuf_reserve(strbuf_t* sb, size_t additional);
+
 /* Clear content to empty string (size=0, keep capacity).
  * After clear, c_str() must be "" (i.e., first char is '\0').
  */
@@ -0,0 +1,526 @@
+#define _GNU_SOURCE
+#include "strbuf_aio.h"
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#define STRBUF_URING (1)
+#endif
+#endif
+
+#define OK  (0)
+#define ERR (-1)
+
+#define AIO_DEPTH_DEFAULT (64)
+
+/* Largest single write submitted; longer buffers complete in pieces. */
+#define AIO_MAX_WRITE (1u << 30)
+
+/* Buffers handed to one pwritev call by the fallback. */
+#define FALLBACK_BATCH (64)
+
+struct strbuf_aio_slot {
+    strbuf_t* sb;
+    off_t     offset;  // file offset of sb->data[0]
+    size_t    written; // bytes already completed
+};
+
+#ifdef STRBUF_URING
+struct strbuf_aio_ring {
+    int                  fd;
+    unsigned             to_submit; // SQEs queued since the last io_uring_enter
+    unsigned*            sq_tail;
+    unsigned             sq_mask;
+    unsigned*            sq_array;
+    struct io_uring_sqe* sqes;
+    unsigned*            cq_head;
+    unsigned*            cq_tail;
+    unsigned             cq_mask;
+    struct io_uring_cqe* cqes;
+    void*                sq_map;
+    size_t               sq_map_len;
+    void*                cq_map; // == sq_map with IORING_FEAT_SINGLE_MMAP
+    size_t               cq_map_len;
+    size_t               sqes_len;
+    struct iovec*        regs;     // registered buffers
+    const strbuf_t**     reg_bufs; // the strbuf each of regs came from
+    unsigned             nregs;
+    unsigned*            free_slots;
+    unsigned             nfree;
+};
+
+static int sys_uring_setup(unsigned entries, struct io_uring_params* p)
+{
+    return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int sys_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+{
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+static int sys_uring_register(int fd, unsigned opcode, const void* arg, unsigned nr_args)
+{
+    return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+static void ring_destroy(strbuf_aio_ring_t* r)
+{
+    if (r->sqes) {
+        munmap(r->sqes, r->sqes_len);
+    }
+    if (r->cq_map && r->cq_map != r->sq_map) {
+        munmap(r->cq_map, r->cq_map_len);
+    }
+    if (r->sq_map) {
+        munmap(r->sq_map, r->sq_map_len);
+    }
+    if (r->fd >= 0) {
+        close(r->fd);
+    }
+    free(r->regs);
+    free(r->reg_bufs);
+    free(r->free_slots);
+    free(r);
+}
+
+static void* map_ring(int fd, size_t len, off_t what)
+{
+    void* p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, what);
+    return p == MAP_FAILED ? NULL : p;
+}
+
+/* Whether the kernel behind ring fd supports both write opcodes. The probe
+ * and IORING_OP_WRITE both arrived in Linux 5.6, so an older kernel fails
+ * the register call itself.
+ */
+static int ring_supports_writes(int fd)
+{
+    size_t len = sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op);
+    struct io_uring_probe* probe = calloc(1, len);
+    if (probe == NULL) {
+        return 0;
+    }
+
+    int ok = sys_uring_register(fd, IORING_REGISTER_PROBE, probe, 256) == 0 &&
+             probe->last_op >= IORING_OP_WRITE && probe->last_op >= IORING_OP_WRITE_FIXED &&
+             (probe->ops[IORING_OP_WRITE].flags & IO_URING_OP_SUPPORTED) &&
+             (probe->ops[IORING_OP_WRITE_FIXED].flags & IO_URING_OP_SUPPORTED);
+    free(probe);
+    return ok;
+}
+
+/* Set up a ring for depth requests; NULL if io_uring is unusable. */
+static strbuf_aio_ring_t* ring_create(unsigned depth)
+{
+    strbuf_aio_ring_t* r = calloc(1, sizeof(*r));
+    if (r == NULL) {
+        return NULL;
+    }
+    r->fd = -1;
+
+    r->free_slots = malloc(depth * sizeof(*r->free_slots));
+    if (r->free_slots == NULL) {
+        ring_destroy(r);
+        return NULL;
+    }
+    for (unsigned i = 0; i < depth; i++) {
+        r->free_slots[i] = depth - 1 - i;
+    }
+    r->nfree = depth;
+
+    /* the CQ gets twice the SQ entries, so depth completions always fit */
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    r->fd = sys_uring_setup(depth, &p);
+    if (r->fd < 0 || !ring_supports_writes(r->fd)) {
+        ring_destroy(r);
+        return NULL;
+    }
+
+    r->sq_map_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    r->cq_map_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        if (r->cq_map_len > r->sq_map_len) {
+            r->sq_map_len = r->cq_map_len;
+        }
+        r->sq_map = map_ring(r->fd, r->sq_map_len, IORING_OFF_SQ_RING);
+        r->cq_map = r->sq_map;
+    } else {
+        r->sq_map = map_ring(r->fd, r->sq_map_len, IORING_OFF_SQ_RING);
+        r->cq_map = map_ring(r->fd, r->cq_map_len, IORING_OFF_CQ_RING);
+    }
+    r->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+    r->sqes = map_ring(r->fd, r->sqes_len, IORING_OFF_SQES);
+    if (r->sq_map == NULL || r->cq_map == NULL || r->sqes == NULL) {
+        ring_destroy(r);
+        return NULL;
+    }
+
+    char* sq = r->sq_map;
+    char* cq = r->cq_map;
+    r->sq_tail = (unsigned*)(sq + p.sq_off.tail);
+    r->sq_mask = *(unsigned*)(sq + p.sq_off.ring_mask);
+    r->sq_array = (unsigned*)(sq + p.sq_off.array);
+    r->cq_head = (unsigned*)(cq + p.cq_off.head);
+    r->cq_tail = (unsigned*)(cq + p.cq_off.tail);
+    r->cq_mask = *(unsigned*)(cq + p.cq_off.ring_mask);
+    r->cqes = (struct io_uring_cqe*)(cq + p.cq_off.cqes);
+    return r;
+}
+
+/* Registered buffer of sb, or -1 if sb was not registered or its storage
+ * changed since: matching the address alone could pick a registration
+ * made for another buffer that has since been freed.
+ */
+static int fixed_index(const strbuf_aio_ring_t* r, const strbuf_t* sb)
+{
+    for (unsigned i = 0; i < r->nregs; i++) {
+        if (r->reg_bufs[i] == sb) {
+            if (r->regs[i].iov_base == sb->data && r->regs[i].iov_len == sb->capacity) {
+                return (int)i;
+            }
+            return -1;
+        }
+    }
+    return -1;
+}
+
+/* Queue an SQE for the unwritten rest of slot i. The SQ has room for every
+ * slot, so this cannot fail; the kernel sees it at the next enter.
+ */
+static void queue_slot(strbuf_aio_t* w, unsigned i)
+{
+    strbuf_aio_ring_t* r = w->ring;
+    strbuf_aio_slot_t* s = &w->slots[i];
+    size_t len = s->sb->size - s->written;
+    int fixed = fixed_index(r, s->sb);
+
+    unsigned tail = *r->sq_tail;
+    unsigned idx = tail & r->sq_mask;
+    struct io_uring_sqe* sqe = &r->sqes[idx];
+
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = fixed >= 0 ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+    sqe->fd = w->fd;
+    sqe->off = (uint64_t)(s->offset + (off_t)s->written);
+    sqe->addr = (uint64_t)(uintptr_t)&s->sb->data[s->written];
+    sqe->len = len > AIO_MAX_WRITE ? AIO_MAX_WRITE : (unsigned)len;
+    sqe->buf_index = fixed >= 0 ? (uint16_t)fixed : 0;
+    sqe->user_data = i;
+
+    r->sq_array[idx] = idx;
+    /* the SQE must be visible before the kernel sees the new tail */
+    __atomic_store_n(r->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    r->to_submit++;
+}
+
+static void complete_slot(strbuf_aio_t* w, unsigned i, int err)
+{
+    strbuf_t* sb = w->slots[i].sb;
+
+    w->slots[i].sb = NULL;
+    w->ring->free_slots[w->ring->nfree++] = i;
+    w->inflight--;
+    if (w->done) {
+        w->done(sb, err, w->ctx);
+    }
+}
+
+/* Run the callbacks of all posted completions; resubmit short writes. */
+static int reap(strbuf_aio_t* w)
+{
+    strbuf_aio_ring_t* r = w->ring;
+    unsigned head = *r->cq_head;
+    unsigned tail = __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE);
+    int completed = 0;
+
+    for (; head != tail; head++) {
+        const struct io_uring_cqe* cqe = &r->cqes[head & r->cq_mask];
+        unsigned i = (unsigned)cqe->user_data;
+        int res = cqe->res;
+        strbuf_aio_slot_t* s = &w->slots[i];
+
+        if (res == -EAGAIN || res == -EINTR) {
+            queue_slot(w, i);
+        } else if (res < 0) {
+            complete_slot(w, i, -res);
+            completed++;
+        } else if (res == 0 && s->written < s->sb->size) {
+            complete_slot(w, i, EIO);
+            completed++;
+        } else {
+            s->written += (size_t)res;
+            if (s->written < s->sb->size) {
+                /* short write: continue with the rest */
+                queue_slot(w, i);
+            } else {
+                complete_slot(w, i, 0);
+                completed++;
+            }
+        }
+    }
+    __atomic_store_n(r->cq_head, head, __ATOMIC_RELEASE);
+    return completed;
+}
+
+static int uring_poll(strbuf_aio_t* w, unsigned min_complete)
+{
+    strbuf_aio_ring_t* r = w->ring;
+    int completed = reap(w);
+
+    while (r->to_submit > 0 ||
+           (min_complete > (unsigned)completed && w->inflight > 0)) {
+        unsigned want = 0;
+        if (min_complete > (unsigned)completed) {
+            want = min_complete - (unsigned)completed;
+            if (want > w->inflight) {
+                want = w->inflight;
+            }
+        }
+
+        int n = sys_uring_enter(r->fd, r->to_submit, want, want ? IORING_ENTER_GETEVENTS : 0);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EBUSY) {
+                /* completion queue backed up: make room and retry */
+                completed += reap(w);
+                continue;
+            }
+            return ERR;
+        }
+        r->to_submit -= (unsigned)n < r->to_submit ? (unsigned)n : r->to_submit;
+        completed += reap(w);
+    }
+    return completed;
+}
+#endif
+
+/* Synchronously write every queued buffer, FALLBACK_BATCH per pwritev. */
+static int fallback_poll(strbuf_aio_t* w)
+{
+    unsigned done = 0;
+
+    while (done < w->inflight) {
+        const strbuf_t* batch[FALLBACK_BATCH];
+        unsigned n = 0;
+        while (n < FALLBACK_BATCH && done + n < w->inflight) {
+            batch[n] = w->slots[done + n].sb;
+            n++;
+        }
+
+        size_t consumed = 0;
+        int rc = strbuf_pwritev_fd(w->fd, batch, n, w->slots[done].offset, &consumed);
+        int err = rc == STRBUF_IO_DONE ? 0 : (rc == STRBUF_IO_PENDING ? EAGAIN : errno);
+
+        /* buffers entirely within consumed made it to the file */
+        for (unsigned k = 0; k < n; k++) {
+            strbuf_t* sb = w->slots[done + k].sb;
+            size_t len = sb->data ? sb->size : 0;
+            int sb_err = consumed >= len ? 0 : err;
+            consumed = consumed >= len ? consumed - len : 0;
+            if (w->done) {
+                w->done(sb, sb_err, w->ctx);
+            }
+        }
+        done += n;
+    }
+
+    w->inflight = 0;
+    return (int)done;
+}
+
+int strbuf_aio_init(strbuf_aio_t* w, int fd, off_t offset, unsigned depth, unsigned flags,
+                    strbuf_aio_done_fn done, void* ctx)
+{
+    if (w == NULL || fd < 0 || offset < 0 || (flags & ~STRBUF_AIO_NO_URING)) {
+        errno = EINVAL;
+        return ERR;
+    }
+
+    memset(w, 0, sizeof(*w));
+    w->fd = fd;
+    w->offset = offset;
+    w->depth = depth ? depth : AIO_DEPTH_DEFAULT;
+    w->done = done;
+    w->ctx = ctx;
+
+    w->slots = calloc(w->depth, sizeof(*w->slots));
+    if (w->slots == NULL) {
+        errno = ENOMEM;
+        return ERR;
+    }
+
+#ifdef STRBUF_URING
+    if (!(flags & STRBUF_AIO_NO_URING)) {
+        w->ring = ring_create(w->depth);
+    }
+#endif
+    return OK;
+}
+
+void strbuf_aio_free(strbuf_aio_t* w)
+{
+    if (w == NULL || w->slots == NULL) {
+        return;
+    }
+
+    /* the kernel may still read from queued buffers */
+    strbuf_aio_flush(w);
+
+#ifdef STRBUF_URING
+    if (w->ring) {
+        ring_destroy(w->ring);
+    }
+#endif
+    free(w->slots);
+    memset(w, 0, sizeof(*w));
+    w->fd = -1;
+}
+
+int strbuf_aio_register(strbuf_aio_t* w, strbuf_t* const* bufs, unsigned count)
+{
+    if (w == NULL || w->slots == NULL || (bufs == NULL && count > 0)) {
+        errno = EINVAL;
+        return ERR;
+    }
+
+#ifdef STRBUF_URING
+    strbuf_aio_ring_t* r = w->ring;
+    if (r == NULL) {
+        return OK;
+    }
+    if (w->inflight > 0) {
+        errno = EBUSY;
+        return ERR;
+    }
+
+    if (r->nregs > 0) {
+        sys_uring_register(r->fd, IORING_UNREGISTER_BUFFERS, NULL, 0);
+        free(r->regs);
+        free(r->reg_bufs);
+        r->regs = NULL;
+        r->reg_bufs = NULL;
+        r->nregs = 0;
+    }
+    if (count == 0) {
+        return OK;
+    }
+
+    struct iovec* regs = malloc(count * sizeof(*regs));
+    const strbuf_t** reg_bufs = malloc(count * sizeof(*reg_bufs));
+    if (regs == NULL || reg_bufs == NULL) {
+        free(regs);
+        free(reg_bufs);
+        errno = ENOMEM;
+        return ERR;
+    }
+    for (unsigned i = 0; i < count; i++) {
+        if (bufs[i] == NULL || bufs[i]->data == NULL || (bufs[i]->flags & STRBUF_F_INLINE)) {
+            /* lazy or inline storage moves; nothing stable to pin */
+            free(regs);
+            free(reg_bufs);
+            errno = EINVAL;
+            return ERR;
+        }
+        regs[i].iov_base = bufs[i]->data;
+        regs[i].iov_len = bufs[i]->capacity;
+        reg_bufs[i] = bufs[i];
+    }
+
+    if (sys_uring_register(r->fd, IORING_REGISTER_BUFFERS, regs, count) != 0) {
+        int saved = errno;
+        free(regs);
+        free(reg_bufs);
+        errno = saved;
+        return ERR;
+    }
+    r->regs = regs;
+    r->reg_bufs = reg_bufs;
+    r->nregs = count;
+#else
+    (void)bufs;
+    (void)count;
+#endif
+    return OK;
+}
+
+int strbuf_aio_write(strbuf_aio_t* w, strbuf_t* sb)
+{
+    if (w == NULL || w->slots == NULL || sb == NULL) {
+        errno = EINVAL;
+        return STRBUF_IO_ERR;
+    }
+
+    size_t len = sb->data ? sb->size : 0;
+
+#ifdef STRBUF_URING
+    if (w->ring && w->inflight == w->depth) {
+        /* pick up completions the kernel already posted */
+        reap(w);
+    }
+#endif
+    if (w->inflight == w->depth) {
+        return STRBUF_IO_PENDING;
+    }
+
+    unsigned i = w->inflight;
+#ifdef STRBUF_URING
+    if (w->ring) {
+        i = w->ring->free_slots[--w->ring->nfree];
+    }
+#endif
+    w->slots[i].sb = sb;
+    w->slots[i].offset = w->offset;
+    w->slots[i].written = 0;
+    w->inflight++;
+    w->offset += (off_t)len;
+
+#ifdef STRBUF_URING
+    if (w->ring) {
+        queue_slot(w, i);
+    }
+#endif
+    return STRBUF_IO_DONE;
+}
+
+int strbuf_aio_poll(strbuf_aio_t* w, unsigned min_complete)
+{
+    if (w == NULL || w->slots == NULL) {
+        errno = EINVAL;
+        return ERR;
+    }
+
+#ifdef STRBUF_URING
+    if (w->ring) {
+        return uring_poll(w, min_complete);
+    }
+#endif
+    (void)min_complete;
+    return fallback_poll(w);
+}
+
+int strbuf_aio_flush(strbuf_aio_t* w)
+{
+    if (w == NULL || w->slots == NULL) {
+        errno = EINVAL;
+        return ERR;
+    }
+
+    while (w->inflight > 0) {
+        if (strbuf_aio_poll(w, w->inflight) < 0) {
+            return ERR;
+        }
+    }
+    return OK;
+}
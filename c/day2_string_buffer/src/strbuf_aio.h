@@ -0,0 +1,95 @@
+#ifndef STRBUF_AIO_H
+#define STRBUF_AIO_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#include "strbuf.h"
+#include "strbuf_io.h"
+
+/* Asynchronous appending writer for batches of strbuf_t.
+ * Each strbuf_aio_write queues one buffer to be written at the next file
+ * offset; queued writes are handed to the kernel together by
+ * strbuf_aio_poll through io_uring, and the done callback runs for every
+ * buffer once the kernel has finished with it, typically to clear it and
+ * hand it back to a producer. Queuing never waits for the disk: when depth
+ * writes are in flight strbuf_aio_write returns STRBUF_IO_PENDING instead.
+ * Without io_uring (kernel before 5.6, seccomp, no <linux/io_uring.h>) the writer
+ * falls back to one synchronous pwritev per batch inside strbuf_aio_poll;
+ * ring is NULL then.
+ * A queued buffer must not be modified or freed until its callback ran.
+ * The writer is not thread-safe. Callbacks run inside strbuf_aio_* calls
+ * on the calling thread (strbuf_aio_write reaps finished writes when all
+ * slots are taken) and must not call back into the writer.
+ */
+
+#define STRBUF_AIO_NO_URING (1u << 0) // always use the pwritev fallback
+
+/* Completion of one buffer: err is 0, or the errno of the failed write. */
+typedef void (*strbuf_aio_done_fn)(strbuf_t* sb, int err, void* ctx);
+
+typedef struct strbuf_aio_ring strbuf_aio_ring_t;
+typedef struct strbuf_aio_slot strbuf_aio_slot_t;
+
+typedef struct {
+    int                 fd;
+    off_t               offset;   // file offset of the next queued write
+    unsigned            depth;    // maximum writes queued or in flight
+    unsigned            inflight; // writes queued or in flight
+    strbuf_aio_ring_t*  ring;     // io_uring state; NULL for the fallback
+    strbuf_aio_slot_t*  slots;    // depth request slots
+    strbuf_aio_done_fn  done;
+    void*               ctx;
+} strbuf_aio_t;
+
+/* Write to fd starting at file offset offset, with up to depth writes in
+ * flight (0 picks 64). done (may be NULL) is called with ctx for every
+ * completed buffer. The writer does not own fd.
+ * Returns 0 on success, -1 on allocation failure or invalid args (errno is
+ * set). Failing to set up io_uring is not an error.
+ */
+int strbuf_aio_init(strbuf_aio_t* w, int fd, off_t offset, unsigned depth, unsigned flags,
+                    strbuf_aio_done_fn done, void* ctx);
+
+/* Wait for all writes, then release the writer; safe to call multiple
+ * times.
+ */
+void strbuf_aio_free(strbuf_aio_t* w);
+
+/* Register the storage of bufs[0..count) with the kernel (io_uring fixed
+ * buffers), which saves pinning and unpinning the pages on every write.
+ * Intended for a fixed pool of buffers that is cleared and refilled.
+ * Registrations belong to the strbuf_t they were made from: only that
+ * buffer, with the same data and capacity, takes the fast path; any other
+ * buffer, or one that grew or moved since, is written without it.
+ * The kernel keeps the registered pages pinned, so a registered buffer
+ * must not be freed while registered: freeing it and then reallocating
+ * the same storage could write the old pages. Re-register (or register
+ * nothing) after changing the pool. Replaces any earlier registration;
+ * only allowed while nothing is in flight.
+ * Returns 0 on success (a no-op for the fallback), -1 on failure (errno is
+ * set; writes keep working unregistered).
+ */
+int strbuf_aio_register(strbuf_aio_t* w, strbuf_t* const* bufs, unsigned count);
+
+/* Queue the content of sb to be written at w->offset and advance the
+ * offset by sb->size. Nothing is submitted until strbuf_aio_poll.
+ * Returns STRBUF_IO_DONE when queued, STRBUF_IO_PENDING if depth writes are
+ * in flight (poll, then retry), STRBUF_IO_ERR on invalid args.
+ */
+int strbuf_aio_write(strbuf_aio_t* w, strbuf_t* sb);
+
+/* Submit every queued write in one system call and run the callbacks of
+ * completed ones, waiting until at least min_complete writes completed
+ * (0 never waits, except that the fallback writes synchronously).
+ * Returns the number of callbacks run, or -1 on a submission error (errno
+ * is set).
+ */
+int strbuf_aio_poll(strbuf_aio_t* w, unsigned min_complete);
+
+/* Submit and wait for all queued and in-flight writes.
+ * Returns 0 on success, -1 on a submission error (errno is set).
+ */
+int strbuf_aio_flush(strbuf_aio_t* w);
+
+#endif
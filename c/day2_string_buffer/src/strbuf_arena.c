@@ -0,0 +1,147 @@
+#include "strbuf_arena.h"
+#include "strbuf_priv.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+#define OK  (0)
+#define ERR (-1)
+
+#define ARENA_BLOCK_DEFAULT (64 * 1024)
+
+struct strbuf_arena_block {
+    strbuf_arena_block_t* next;
+    size_t                size;
+    char                  data[];
+};
+
+static void use_block(strbuf_arena_t* arena, strbuf_arena_block_t* block)
+{
+    arena->current = block;
+    arena->cur = block->data;
+    arena->end = block->data + block->size;
+}
+
+char* strbuf_arena_take(strbuf_arena_t* arena, size_t n)
+{
+    if ((size_t)(arena->end - arena->cur) < n) {
+        /* the next block is reusable after a reset if it is large enough */
+        strbuf_arena_block_t* next = arena->current ? arena->current->next : arena->first;
+
+        if (next == NULL || next->size < n) {
+            size_t size = n > arena->block_size ? n : arena->block_size;
+            if (size > SIZE_MAX - sizeof(*next)) {
+                return NULL;
+            }
+            strbuf_arena_block_t* block = malloc(sizeof(*block) + size);
+            if (block == NULL) {
+                return NULL;
+            }
+            block->size = size;
+            if (arena->current && n > arena->block_size) {
+                /* used up by this request alone: file it with the blocks
+                 * already in use and keep carving from the current one */
+                block->next = arena->first;
+                arena->first = block;
+                return block->data;
+            }
+            block->next = next;
+            if (arena->current) {
+                arena->current->next = block;
+            } else {
+                arena->first = block;
+            }
+            next = block;
+        }
+        use_block(arena, next);
+    }
+
+    char* p = arena->cur;
+    arena->cur += n;
+    return p;
+}
+
+int strbuf_arena_extend(strbuf_t* sb, size_t new_capacity)
+{
+    strbuf_arena_t* arena = sb->arena;
+    size_t delta = new_capacity - sb->capacity;
+
+    if (sb->data + sb->capacity != arena->cur || (size_t)(arena->end - arena->cur) < delta) {
+        return ERR;
+    }
+
+    arena->cur += delta;
+    sb->capacity = new_capacity;
+    return OK;
+}
+
+void strbuf_arena_release(strbuf_t* sb)
+{
+    strbuf_arena_t* arena = sb->arena;
+
+    if (sb->data && sb->data + sb->capacity == arena->cur) {
+        arena->cur = sb->data;
+    }
+}
+
+int strbuf_arena_init(strbuf_arena_t* arena, size_t block_size)
+{
+    if (arena == NULL) {
+        return ERR;
+    }
+
+    arena->first = NULL;
+    arena->current = NULL;
+    arena->cur = NULL;
+    arena->end = NULL;
+    arena->block_size = block_size ? block_size : ARENA_BLOCK_DEFAULT;
+    return OK;
+}
+
+void strbuf_arena_free(strbuf_arena_t* arena)
+{
+    if (arena == NULL) {
+        return;
+    }
+
+    strbuf_arena_block_t* block = arena->first;
+    while (block) {
+        strbuf_arena_block_t* next = block->next;
+        free(block);
+        block = next;
+    }
+
+    arena->first = NULL;
+    arena->current = NULL;
+    arena->cur = NULL;
+    arena->end = NULL;
+}
+
+void strbuf_arena_reset(strbuf_arena_t* arena)
+{
+    if (arena == NULL || arena->first == NULL) {
+        return;
+    }
+
+    use_block(arena, arena->first);
+}
+
+int strbuf_init_arena(strbuf_t* sb, strbuf_arena_t* arena, size_t initial_capacity)
+{
+    if (sb == NULL || arena == NULL) {
+        return ERR;
+    }
+
+    if (strbuf_init(sb, 0) != OK) {
+        return ERR;
+    }
+    sb->flags = STRBUF_F_ARENA;
+    sb->arena = arena;
+
+    /* reserve counts the '\0' itself */
+    if (initial_capacity > 0 && strbuf_reserve(sb, initial_capacity - 1) != OK) {
+        strbuf_free(sb);
+        return ERR;
+    }
+
+    return OK;
+}
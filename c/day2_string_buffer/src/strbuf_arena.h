@@ -0,0 +1,53 @@
+#ifndef STRBUF_ARENA_H
+#define STRBUF_ARENA_H
+
+#include <stddef.h>
+
+#include "strbuf.h"
+
+/* Bump arena for short-lived strings, e.g. everything built while serving
+ * one request. Buffers initialized with strbuf_init_arena take their
+ * storage from the arena; strbuf_free on them returns nothing to malloc, and
+ * strbuf_arena_reset releases all of them at once in O(1) while keeping the
+ * blocks for the next round.
+ * A buffer that is the most recent allocation grows in place; otherwise it
+ * is copied to fresh arena space, and the old copy stays unused until reset.
+ */
+
+typedef struct strbuf_arena_block strbuf_arena_block_t;
+
+typedef struct strbuf_arena {
+    strbuf_arena_block_t* first;      // all blocks, kept across resets
+    strbuf_arena_block_t* current;    // block allocations are carved from
+    char*                 cur;        // next free byte in current
+    char*                 end;        // end of current
+    size_t                block_size;
+} strbuf_arena_t;
+
+/* Initialize an empty arena allocating blocks of block_size bytes
+ * (0 picks 64 KiB); larger requests get a block of their own size, and
+ * the space left in the current block stays available.
+ * Returns 0 on success, -1 on invalid args.
+ */
+int strbuf_arena_init(strbuf_arena_t* arena, size_t block_size);
+
+/* Free every block; safe to call multiple times. All buffers carved from
+ * the arena become invalid.
+ */
+void strbuf_arena_free(strbuf_arena_t* arena);
+
+/* Make all memory of the arena available again without freeing blocks.
+ * All buffers carved from the arena become invalid and must not be used or
+ * freed afterwards (re-initialize them instead).
+ */
+void strbuf_arena_reset(strbuf_arena_t* arena);
+
+/* Initialize sb as an arena-backed buffer, empty with room for
+ * initial_capacity bytes (including the '\0'); 0 allocates lazily.
+ * Unlike strbuf_init, short strings do not use the inline buffer: the arena
+ * pointer shares its storage, and arena allocations are cheap anyway.
+ * Returns 0 on success, -1 on allocation failure or invalid args.
+ */
+int strbuf_init_arena(strbuf_t* sb, strbuf_arena_t* arena, size_t initial_capacity);
+
+#endif
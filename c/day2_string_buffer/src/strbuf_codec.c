@@ -0,0 +1,389 @@
+#include "strbuf.h"
+#include "strbuf_priv.h"
+#include <string.h>
+
+#define OK  (0)
+#define ERR (-1)
+
+#define B64_INVALID (0xFF)
+
+static const char kBase64[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static const char kHexDigits[] = "0123456789abcdef";
+
+/* Value of a base64 character, or B64_INVALID ('=' included); valid
+ * values fit in 6 bits, so OR-ing several and testing 0xC0 checks them all. */
+static unsigned char b64_value(unsigned char c)
+{
+    if (c >= 'A' && c <= 'Z') {
+        return (unsigned char)(c - 'A');
+    }
+    if (c >= 'a' && c <= 'z') {
+        return (unsigned char)(c - 'a' + 26);
+    }
+    if (c >= '0' && c <= '9') {
+        return (unsigned char)(c - '0' + 52);
+    }
+    if (c == '+') {
+        return 62;
+    }
+    if (c == '/') {
+        return 63;
+    }
+    return B64_INVALID;
+}
+
+/* Value of a hex digit (either case), or 0xFF. */
+static unsigned char hex_value(unsigned char c)
+{
+    if (c >= '0' && c <= '9') {
+        return (unsigned char)(c - '0');
+    }
+    c |= 0x20;
+    if (c >= 'a' && c <= 'f') {
+        return (unsigned char)(c - 'a' + 10);
+    }
+    return 0xFF;
+}
+
+#ifdef STRBUF_X86
+/*
+ * AVX2 base64 after Muła and Lemire, "Faster Base64 Encoding and Decoding
+ * Using AVX2 Instructions" (the formulation used by aklomp/base64).
+ * Encoding turns 24 input bytes into 32 characters per step: a shuffle
+ * spreads each 3-byte group over 4 bytes, multiplies shift the 6-bit fields
+ * into place and a 16-entry offset table maps 0..63 to the alphabet.
+ * Decoding classifies each character by its nibbles to validate 32 at a
+ * time, adds a per-class offset and packs the 6-bit values with two
+ * multiply-adds.
+ */
+__attribute__((target("avx2")))
+static size_t b64_encode_avx2(const unsigned char* in, size_t n, char* out)
+{
+    const __m256i spread = _mm256_setr_epi8(
+        1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+        1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+    const __m256i offsets = _mm256_setr_epi8(
+        65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0,
+        65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0);
+    size_t i = 0;
+    size_t o = 0;
+
+    /* each lane takes 12 bytes; the loads read 16, so stop 4 early */
+    for (; i + 28 <= n; i += 24, o += 32) {
+        __m256i v = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)&in[i])),
+            _mm_loadu_si128((const __m128i*)&in[i + 12]), 1);
+        v = _mm256_shuffle_epi8(v, spread);
+
+        __m256i t0 = _mm256_and_si256(v, _mm256_set1_epi32(0x0FC0FC00));
+        __m256i t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+        __m256i t2 = _mm256_and_si256(v, _mm256_set1_epi32(0x003F03F0));
+        __m256i t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+        __m256i idx = _mm256_or_si256(t1, t3);
+
+        /* table slot: 0 for 0..25, 1 for 26..51, 2..11 digits, 12 '+', 13 '/' */
+        __m256i slot = _mm256_subs_epu8(idx, _mm256_set1_epi8(51));
+        slot = _mm256_sub_epi8(slot, _mm256_cmpgt_epi8(idx, _mm256_set1_epi8(25)));
+        __m256i chars = _mm256_add_epi8(idx, _mm256_shuffle_epi8(offsets, slot));
+
+        _mm256_storeu_si256((__m256i*)&out[o], chars);
+    }
+    return i;
+}
+
+/* Decode 32 characters per step from in[0..n) into out.
+ * Returns the number of characters consumed; stops early at the first block
+ * holding a character outside the alphabet (left for the scalar loop). */
+__attribute__((target("avx2")))
+static size_t b64_decode_avx2(const unsigned char* in, size_t n, unsigned char* out)
+{
+    const __m256i lut_lo = _mm256_setr_epi8(
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+        0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+        0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m256i lut_hi = _mm256_setr_epi8(
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m256i lut_roll = _mm256_setr_epi8(
+        0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i pack = _mm256_setr_epi8(
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    const __m256i mask_2f = _mm256_set1_epi8(0x2F);
+    const __m256i store_24 = _mm256_setr_epi32(-1, -1, -1, -1, -1, -1, 0, 0);
+    size_t i = 0;
+    size_t o = 0;
+
+    for (; i + 32 <= n; i += 32, o += 24) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)&in[i]);
+        __m256i hi_nibbles = _mm256_and_si256(_mm256_srli_epi32(v, 4), mask_2f);
+        __m256i lo_nibbles = _mm256_and_si256(v, mask_2f);
+        __m256i hi = _mm256_shuffle_epi8(lut_hi, hi_nibbles);
+        __m256i lo = _mm256_shuffle_epi8(lut_lo, lo_nibbles);
+
+        if (!_mm256_testz_si256(lo, hi)) {
+            break;
+        }
+
+        __m256i eq_2f = _mm256_cmpeq_epi8(v, mask_2f);
+        __m256i roll = _mm256_shuffle_epi8(lut_roll, _mm256_add_epi8(eq_2f, hi_nibbles));
+        v = _mm256_add_epi8(v, roll);
+
+        /* 4 x 6 bits -> 3 bytes per dword, then 12 bytes per lane */
+        __m256i ab_bc = _mm256_maddubs_epi16(v, _mm256_set1_epi32(0x01400140));
+        __m256i abc = _mm256_madd_epi16(ab_bc, _mm256_set1_epi32(0x00011000));
+        abc = _mm256_shuffle_epi8(abc, pack);
+        abc = _mm256_permutevar8x32_epi32(abc, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 0, 0));
+
+        _mm256_maskstore_epi32((int*)&out[o], store_24, abc);
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t hex_encode_avx2(const unsigned char* in, size_t n, char* out)
+{
+    const __m256i digits = _mm256_setr_epi8(
+        '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f',
+        '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f');
+    const __m256i low4 = _mm256_set1_epi8(0x0F);
+    size_t i = 0;
+
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)&in[i]);
+        __m256i hi = _mm256_shuffle_epi8(digits, _mm256_and_si256(_mm256_srli_epi16(v, 4), low4));
+        __m256i lo = _mm256_shuffle_epi8(digits, _mm256_and_si256(v, low4));
+        /* interleave works per lane: fix the lane order afterwards */
+        __m256i a = _mm256_unpacklo_epi8(hi, lo);
+        __m256i b = _mm256_unpackhi_epi8(hi, lo);
+        _mm256_storeu_si256((__m256i*)&out[2 * i], _mm256_permute2x128_si256(a, b, 0x20));
+        _mm256_storeu_si256((__m256i*)&out[2 * i + 32], _mm256_permute2x128_si256(a, b, 0x31));
+    }
+    return i;
+}
+
+/* Decode 32 hex digits per step; stops at the first block holding a
+ * non-digit. Returns the number of characters consumed. */
+__attribute__((target("avx2")))
+static size_t hex_decode_avx2(const unsigned char* in, size_t n, unsigned char* out)
+{
+    size_t i = 0;
+
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)&in[i]);
+        __m256i digit = _mm256_sub_epi8(v, _mm256_set1_epi8('0'));
+        __m256i alpha = _mm256_sub_epi8(_mm256_or_si256(v, _mm256_set1_epi8(0x20)),
+                                        _mm256_set1_epi8('a'));
+        /* x <= k unsigned  <=>  min(x, k) == x */
+        __m256i is_digit = _mm256_cmpeq_epi8(_mm256_min_epu8(digit, _mm256_set1_epi8(9)), digit);
+        __m256i is_alpha = _mm256_cmpeq_epi8(_mm256_min_epu8(alpha, _mm256_set1_epi8(5)), alpha);
+
+        if ((unsigned)_mm256_movemask_epi8(_mm256_or_si256(is_digit, is_alpha)) != 0xFFFFFFFFu) {
+            break;
+        }
+
+        __m256i val = _mm256_blendv_epi8(_mm256_add_epi8(alpha, _mm256_set1_epi8(10)), digit, is_digit);
+        /* hi * 16 + lo per byte pair, then narrow to bytes */
+        __m256i pairs = _mm256_maddubs_epi16(val, _mm256_set1_epi16(0x0110));
+        __m256i packed = _mm256_packus_epi16(pairs, pairs);
+        packed = _mm256_permute4x64_epi64(packed, 0x08);
+        _mm_storeu_si128((__m128i*)&out[i / 2], _mm256_castsi256_si128(packed));
+    }
+    return i;
+}
+#endif
+
+int strbuf_append_base64(strbuf_t* sb, const void* data, size_t n)
+{
+    if (sb == NULL || (data == NULL && n > 0)) {
+        return ERR;
+    }
+    if (n / 3 >= SIZE_MAX / 4 - 1) {
+        return ERR;
+    }
+    if (n == 0) {
+        return OK;
+    }
+
+    size_t out_len = (n + 2) / 3 * 4;
+    if (strbuf_reserve(sb, out_len) != OK) {
+        return ERR;
+    }
+
+    const unsigned char* in = data;
+    char* out = &sb->data[sb->size];
+    size_t i = 0;
+
+#ifdef STRBUF_X86
+    if (strbuf_have_avx2()) {
+        i = b64_encode_avx2(in, n, out);
+    }
+#endif
+
+    char* o = &out[i / 3 * 4];
+    for (; i + 3 <= n; i += 3) {
+        uint32_t w = (uint32_t)in[i] << 16 | (uint32_t)in[i + 1] << 8 | in[i + 2];
+        *o++ = kBase64[w >> 18];
+        *o++ = kBase64[(w >> 12) & 63];
+        *o++ = kBase64[(w >> 6) & 63];
+        *o++ = kBase64[w & 63];
+    }
+    if (i < n) {
+        uint32_t w = (uint32_t)in[i] << 16 | (i + 1 < n ? (uint32_t)in[i + 1] << 8 : 0);
+        *o++ = kBase64[w >> 18];
+        *o++ = kBase64[(w >> 12) & 63];
+        *o++ = i + 1 < n ? kBase64[(w >> 6) & 63] : '=';
+        *o++ = '=';
+    }
+
+    sb->size += out_len;
+    sb->data[sb->size] = '\0';
+    strbuf_appended(sb);
+    return OK;
+}
+
+int strbuf_decode_base64(strbuf_t* sb, const char* s, size_t n)
+{
+    if (sb == NULL || (s == NULL && n > 0) || n % 4 != 0) {
+        return ERR;
+    }
+    if (n == 0) {
+        return OK;
+    }
+
+    const unsigned char* in = (const unsigned char*)s;
+    size_t pad = 0;
+    if (n > 0 && in[n - 1] == '=') {
+        pad = in[n - 2] == '=' ? 2 : 1;
+    }
+
+    size_t out_len = n / 4 * 3 - pad;
+    if (strbuf_reserve(sb, out_len) != OK) {
+        return ERR;
+    }
+
+    unsigned char* out = (unsigned char*)&sb->data[sb->size];
+    size_t body = n - (pad ? 4 : 0); // quanta without padding
+    size_t i = 0;
+
+#ifdef STRBUF_X86
+    if (strbuf_have_avx2()) {
+        i = b64_decode_avx2(in, body, out);
+    }
+#endif
+
+    unsigned char* o = &out[i / 4 * 3];
+    for (; i < body; i += 4) {
+        unsigned char a = b64_value(in[i]);
+        unsigned char b = b64_value(in[i + 1]);
+        unsigned char c = b64_value(in[i + 2]);
+        unsigned char d = b64_value(in[i + 3]);
+        if ((a | b | c | d) & 0xC0) {
+            sb->data[sb->size] = '\0';
+            return ERR;
+        }
+        uint32_t w = (uint32_t)a << 18 | (uint32_t)b << 12 | (uint32_t)c << 6 | d;
+        *o++ = (unsigned char)(w >> 16);
+        *o++ = (unsigned char)(w >> 8);
+        *o++ = (unsigned char)w;
+    }
+
+    if (pad) {
+        unsigned char a = b64_value(in[i]);
+        unsigned char b = b64_value(in[i + 1]);
+        unsigned char c = pad == 1 ? b64_value(in[i + 2]) : 0;
+        if (((a | b | c) & 0xC0) != 0) {
+            sb->data[sb->size] = '\0';
+            return ERR;
+        }
+        uint32_t w = (uint32_t)a << 18 | (uint32_t)b << 12 | (uint32_t)c << 6;
+        *o++ = (unsigned char)(w >> 16);
+        if (pad == 1) {
+            *o++ = (unsigned char)(w >> 8);
+        }
+    }
+
+    sb->size += out_len;
+    sb->data[sb->size] = '\0';
+    strbuf_appended(sb);
+    return OK;
+}
+
+int strbuf_append_hex_bytes(strbuf_t* sb, const void* data, size_t n)
+{
+    if (sb == NULL || (data == NULL && n > 0) || n > SIZE_MAX / 2 - 1) {
+        return ERR;
+    }
+    if (n == 0) {
+        return OK;
+    }
+
+    if (strbuf_reserve(sb, 2 * n) != OK) {
+        return ERR;
+    }
+
+    const unsigned char* in = data;
+    char* out = &sb->data[sb->size];
+    size_t i = 0;
+
+#ifdef STRBUF_X86
+    if (strbuf_have_avx2()) {
+        i = hex_encode_avx2(in, n, out);
+    }
+#endif
+
+    for (; i < n; i++) {
+        out[2 * i] = kHexDigits[in[i] >> 4];
+        out[2 * i + 1] = kHexDigits[in[i] & 0xF];
+    }
+
+    sb->size += 2 * n;
+    sb->data[sb->size] = '\0';
+    strbuf_appended(sb);
+    return OK;
+}
+
+int strbuf_decode_hex(strbuf_t* sb, const char* s, size_t n)
+{
+    if (sb == NULL || (s == NULL && n > 0) || n % 2 != 0) {
+        return ERR;
+    }
+    if (n == 0) {
+        return OK;
+    }
+
+    if (strbuf_reserve(sb, n / 2) != OK) {
+        return ERR;
+    }
+
+    const unsigned char* in = (const unsigned char*)s;
+    unsigned char* out = (unsigned char*)&sb->data[sb->size];
+    size_t i = 0;
+
+#ifdef STRBUF_X86
+    if (strbuf_have_avx2()) {
+        i = hex_decode_avx2(in, n, out);
+    }
+#endif
+
+    for (; i < n; i += 2) {
+        unsigned char hi = hex_value(in[i]);
+        unsigned char lo = hex_value(in[i + 1]);
+        if ((hi | lo) == 0xFF) {
+            sb->data[sb->size] = '\0';
+            return ERR;
+        }
+        out[i / 2] = (unsigned char)(hi << 4 | lo);
+    }
+
+    sb->size += n / 2;
+    sb->data[sb->size] = '\0';
+    strbuf_appended(sb);
+    return OK;
+}
@@ -0,0 +1,233 @@
+#include "strbuf.h"
+#include "strbuf_priv.h"
+#include <string.h>
+
+/* CRC-32C (Castagnoli), reflected polynomial */
+#define CRC32C_POLY (0x82F63B78u)
+
+/* Bytes per stream in one round of the 3-way hardware loop. Long rounds
+ * amortize the combine step; short rounds cover what is left of mid-sized
+ * inputs.
+ */
+#define CRC_LONG  (8192)
+#define CRC_SHORT (256)
+
+/* Slicing-by-8 tables for the portable path: kTable[k][b] is the CRC of
+ * byte b followed by k zero bytes.
+ */
+static uint32_t kTable[8][256];
+
+/* a * b mod P, polynomials in reflected bit order (x^0 is bit 31) */
+static uint32_t multmodp(uint32_t a, uint32_t b)
+{
+    uint32_t m = (uint32_t)1 << 31;
+    uint32_t p = 0;
+
+    for (;;) {
+        if (a & m) {
+            p ^= b;
+            if ((a & (m - 1)) == 0) {
+                break;
+            }
+        }
+        m >>= 1;
+        b = (b & 1) ? (b >> 1) ^ CRC32C_POLY : b >> 1;
+    }
+    return p;
+}
+
+/* x^n mod P */
+static uint32_t xpow(uint64_t n)
+{
+    uint32_t p = (uint32_t)1 << 31;
+    uint32_t base = (uint32_t)1 << 30;
+
+    while (n) {
+        if (n & 1) {
+            p = multmodp(base, p);
+        }
+        base = multmodp(base, base);
+        n >>= 1;
+    }
+    return p;
+}
+
+/* Constants to shift a CRC register over 1 and 2 stream lengths:
+ * shift[i] = x^(8 * len * (i + 1)) for the multmodp combine, and
+ * clmul[i] = the same power divided by x^33, because a carry-less product
+ * fed through the crc32 instruction picks up a factor x^33.
+ */
+typedef struct {
+    uint32_t shift[2];
+    uint32_t clmul[2];
+} shift_consts_t;
+
+static shift_consts_t kLong;
+static shift_consts_t kShort;
+
+static void make_consts(shift_consts_t* c, uint64_t len)
+{
+    for (int i = 0; i < 2; i++) {
+        c->shift[i] = xpow(8 * len * (uint64_t)(i + 1));
+        c->clmul[i] = xpow(8 * len * (uint64_t)(i + 1) - 33);
+    }
+}
+
+__attribute__((constructor))
+static void crc32c_init_tables(void)
+{
+    for (uint32_t b = 0; b < 256; b++) {
+        uint32_t c = b;
+        for (int k = 0; k < 8; k++) {
+            c = (c & 1) ? (c >> 1) ^ CRC32C_POLY : c >> 1;
+        }
+        kTable[0][b] = c;
+    }
+    for (uint32_t b = 0; b < 256; b++) {
+        for (int k = 1; k < 8; k++) {
+            uint32_t prev = kTable[k - 1][b];
+            kTable[k][b] = (prev >> 8) ^ kTable[0][prev & 0xFF];
+        }
+    }
+
+    make_consts(&kLong, CRC_LONG);
+    make_consts(&kShort, CRC_SHORT);
+}
+
+/* Table-driven update of the raw register (no pre/post inversion). */
+static uint32_t crc32c_sw(uint32_t crc, const unsigned char* p, size_t n)
+{
+    while (n >= 8) {
+        uint64_t w;
+        memcpy(&w, p, sizeof(w));
+        w ^= crc;
+        crc = kTable[7][w & 0xFF] ^ kTable[6][(w >> 8) & 0xFF] ^
+              kTable[5][(w >> 16) & 0xFF] ^ kTable[4][(w >> 24) & 0xFF] ^
+              kTable[3][(w >> 32) & 0xFF] ^ kTable[2][(w >> 40) & 0xFF] ^
+              kTable[1][(w >> 48) & 0xFF] ^ kTable[0][w >> 56];
+        p += 8;
+        n -= 8;
+    }
+    while (n--) {
+        crc = (crc >> 8) ^ kTable[0][(crc ^ *p++) & 0xFF];
+    }
+    return crc;
+}
+
+#if defined(STRBUF_X86) && defined(__x86_64__)
+typedef uint32_t (*combine_fn)(uint32_t c0, uint32_t c1, uint32_t c2, const shift_consts_t* k);
+
+/* c0 * x^(16 len) + c1 * x^(8 len) + c2 with the portable multiply */
+static uint32_t combine_soft(uint32_t c0, uint32_t c1, uint32_t c2, const shift_consts_t* k)
+{
+    return multmodp(k->shift[1], c0) ^ multmodp(k->shift[0], c1) ^ c2;
+}
+
+/* The same with two carry-less multiplies and one crc32 reduction. */
+__attribute__((target("sse4.2,pclmul")))
+static uint32_t combine_clmul(uint32_t c0, uint32_t c1, uint32_t c2, const shift_consts_t* k)
+{
+    __m128i a = _mm_clmulepi64_si128(_mm_cvtsi32_si128((int)c0),
+                                     _mm_cvtsi32_si128((int)k->clmul[1]), 0x00);
+    __m128i b = _mm_clmulepi64_si128(_mm_cvtsi32_si128((int)c1),
+                                     _mm_cvtsi32_si128((int)k->clmul[0]), 0x00);
+    uint64_t t = (uint64_t)_mm_cvtsi128_si64(_mm_xor_si128(a, b));
+    return (uint32_t)_mm_crc32_u64(0, t) ^ c2;
+}
+
+/* Three independent crc32 chains over adjacent len-byte streams hide the
+ * instruction's 3-cycle latency; the partial CRCs are then shifted into
+ * place and added.
+ */
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_3way(uint32_t crc, const unsigned char* p, size_t len,
+                            const shift_consts_t* k, combine_fn combine)
+{
+    uint64_t c0 = crc, c1 = 0, c2 = 0;
+
+    for (size_t i = 0; i < len; i += 8) {
+        uint64_t w0, w1, w2;
+        memcpy(&w0, &p[i], 8);
+        memcpy(&w1, &p[len + i], 8);
+        memcpy(&w2, &p[2 * len + i], 8);
+        c0 = _mm_crc32_u64(c0, w0);
+        c1 = _mm_crc32_u64(c1, w1);
+        c2 = _mm_crc32_u64(c2, w2);
+    }
+    return combine((uint32_t)c0, (uint32_t)c1, (uint32_t)c2, k);
+}
+
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_hw(uint32_t crc, const unsigned char* p, size_t n, combine_fn combine)
+{
+    while (n >= 3 * CRC_LONG) {
+        crc = crc32c_3way(crc, p, CRC_LONG, &kLong, combine);
+        p += 3 * CRC_LONG;
+        n -= 3 * CRC_LONG;
+    }
+    while (n >= 3 * CRC_SHORT) {
+        crc = crc32c_3way(crc, p, CRC_SHORT, &kShort, combine);
+        p += 3 * CRC_SHORT;
+        n -= 3 * CRC_SHORT;
+    }
+
+    uint64_t c = crc;
+    while (n >= 8) {
+        uint64_t w;
+        memcpy(&w, p, 8);
+        c = _mm_crc32_u64(c, w);
+        p += 8;
+        n -= 8;
+    }
+    crc = (uint32_t)c;
+    while (n--) {
+        crc = _mm_crc32_u8(crc, *p++);
+    }
+    return crc;
+}
+#endif
+
+uint32_t strbuf_crc32c_update(uint32_t crc, const void* data, size_t n)
+{
+    const unsigned char* p = data;
+
+    if (p == NULL) {
+        return crc;
+    }
+
+    crc = ~crc;
+#if defined(STRBUF_X86) && defined(__x86_64__)
+    if (strbuf_have_sse42()) {
+        return ~crc32c_hw(crc, p, n, strbuf_have_pclmul() ? combine_clmul : combine_soft);
+    }
+#endif
+    return ~crc32c_sw(crc, p, n);
+}
+
+uint32_t strbuf_crc32c(const strbuf_t* sb)
+{
+    if (sb == NULL || sb->data == NULL) {
+        return 0;
+    }
+
+    if ((sb->flags & (STRBUF_F_CRC | STRBUF_F_INLINE)) == STRBUF_F_CRC && sb->crc_len <= sb->size) {
+        /* only bytes appended since the last update are left */
+        return strbuf_crc32c_update(sb->crc, &sb->data[sb->crc_len], sb->size - sb->crc_len);
+    }
+    return strbuf_crc32c_update(0, sb->data, sb->size);
+}
+
+int strbuf_crc32c_track(strbuf_t* sb)
+{
+    if (sb == NULL) {
+        return -1;
+    }
+
+    sb->crc = strbuf_crc32c_update(0, sb->data, sb->data ? sb->size : 0);
+    if (!(sb->flags & STRBUF_F_INLINE)) {
+        /* inline content is checksummed again on demand until it spills */
+        sb->crc_len = sb->data ? sb->size : 0;
+    }
+    sb->flags |= STRBUF_F_CRC;
+    return 0;
+}
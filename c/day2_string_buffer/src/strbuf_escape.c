@@ -0,0 +1,255 @@
+#include "strbuf.h"
+#include "strbuf_priv.h"
+#include <string.h>
+
+#define OK  (0)
+#define ERR (-1)
+
+static const char kHexDigits[] = "0123456789abcdef";
+
+static int json_special(unsigned char c)
+{
+    return c < 0x20 || c == '"' || c == '\\';
+}
+
+static int csv_special(unsigned char c, unsigned char delim)
+{
+    return c == delim || c == '"' || c == '\n' || c == '\r';
+}
+
+#ifdef STRBUF_X86
+__attribute__((target("avx2")))
+static size_t json_scan_avx2(const unsigned char* p, size_t i, size_t n)
+{
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i ctrl_max = _mm256_set1_epi8(0x1F);
+
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)&p[i]);
+        /* min(v, 0x1F) == v  <=>  v <= 0x1F unsigned */
+        __m256i hit = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, backslash)),
+            _mm256_cmpeq_epi8(_mm256_min_epu8(v, ctrl_max), v));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(hit);
+        if (mask) {
+            return i + (size_t)__builtin_ctz(mask);
+        }
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t csv_scan_avx2(const unsigned char* p, size_t i, size_t n, unsigned char delim)
+{
+    const __m256i d = _mm256_set1_epi8((char)delim);
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i lf = _mm256_set1_epi8('\n');
+    const __m256i cr = _mm256_set1_epi8('\r');
+
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)&p[i]);
+        __m256i hit = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, d), _mm256_cmpeq_epi8(v, quote)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, lf), _mm256_cmpeq_epi8(v, cr)));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(hit);
+        if (mask) {
+            return i + (size_t)__builtin_ctz(mask);
+        }
+    }
+    return i;
+}
+#endif
+
+/* Offset of the first byte in p[i..n) that JSON must escape, or n. */
+static size_t json_scan(const unsigned char* p, size_t i, size_t n)
+{
+#ifdef STRBUF_X86
+    if (strbuf_have_avx2()) {
+        i = json_scan_avx2(p, i, n);
+    }
+#endif
+
+#if defined(__SSE2__)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i ctrl_max = _mm_set1_epi8(0x1F);
+
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)&p[i]);
+        __m128i hit = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)),
+            _mm_cmpeq_epi8(_mm_min_epu8(v, ctrl_max), v));
+        unsigned mask = (unsigned)_mm_movemask_epi8(hit);
+        if (mask) {
+            return i + (size_t)__builtin_ctz(mask);
+        }
+    }
+#endif
+
+    for (; i < n; i++) {
+        if (json_special(p[i])) {
+            return i;
+        }
+    }
+    return n;
+}
+
+/* Offset of the first byte in p[i..n) that forces CSV quoting, or n. */
+static size_t csv_scan(const unsigned char* p, size_t i, size_t n, unsigned char delim)
+{
+#ifdef STRBUF_X86
+    if (strbuf_have_avx2()) {
+        i = csv_scan_avx2(p, i, n, delim);
+    }
+#endif
+
+#if defined(__SSE2__)
+    const __m128i d = _mm_set1_epi8((char)delim);
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i lf = _mm_set1_epi8('\n');
+    const __m128i cr = _mm_set1_epi8('\r');
+
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)&p[i]);
+        __m128i hit = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, d), _mm_cmpeq_epi8(v, quote)),
+            _mm_or_si128(_mm_cmpeq_epi8(v, lf), _mm_cmpeq_epi8(v, cr)));
+        unsigned mask = (unsigned)_mm_movemask_epi8(hit);
+        if (mask) {
+            return i + (size_t)__builtin_ctz(mask);
+        }
+    }
+#endif
+
+    for (; i < n; i++) {
+        if (csv_special(p[i], delim)) {
+            return i;
+        }
+    }
+    return n;
+}
+
+/* Offset of s into sb's content, or SIZE_MAX when it points elsewhere.
+ * Growing sb may move or free that content, so an escape reading from
+ * it re-derives s through source() after every append. */
+static size_t self_offset(const strbuf_t* sb, const char* s)
+{
+    if (sb->data && s >= sb->data && s < sb->data + sb->size) {
+        return (size_t)(s - sb->data);
+    }
+    return SIZE_MAX;
+}
+
+static const char* source(const strbuf_t* sb, const char* s, size_t off)
+{
+    return off == SIZE_MAX ? s : sb->data + off;
+}
+
+/* Undo a partial append after a failed growth. */
+static int rollback(strbuf_t* sb, size_t old_size)
+{
+    strbuf_truncate(sb, old_size);
+    return ERR;
+}
+
+int strbuf_append_json_escaped(strbuf_t* sb, const char* s, size_t n)
+{
+    if (sb == NULL || (s == NULL && n > 0)) {
+        return ERR;
+    }
+
+    if (n == 0) {
+        return OK;
+    }
+
+    size_t off = self_offset(sb, s);
+    size_t old_size = sb->size;
+    size_t i = 0;
+
+    /* room for the common case of little or nothing to escape */
+    if (strbuf_reserve(sb, n) != OK) {
+        return ERR;
+    }
+
+    while (i < n) {
+        s = source(sb, s, off);
+        const unsigned char* p = (const unsigned char*)s;
+        size_t j = json_scan(p, i, n);
+        unsigned char c = j < n ? p[j] : 0;
+
+        if (strbuf_append_n(sb, &s[i], j - i) != OK) {
+            return rollback(sb, old_size);
+        }
+        if (j == n) {
+            break;
+        }
+
+        char esc[6] = {'\\', 0, 0, 0, 0, 0};
+        size_t esc_len = 2;
+        switch (c) {
+        case '"':  esc[1] = '"';  break;
+        case '\\': esc[1] = '\\'; break;
+        case '\b': esc[1] = 'b';  break;
+        case '\f': esc[1] = 'f';  break;
+        case '\n': esc[1] = 'n';  break;
+        case '\r': esc[1] = 'r';  break;
+        case '\t': esc[1] = 't';  break;
+        default:
+            memcpy(esc, "\\u00", 4);
+            esc[4] = kHexDigits[c >> 4];
+            esc[5] = kHexDigits[c & 0xF];
+            esc_len = 6;
+            break;
+        }
+        if (strbuf_append_n(sb, esc, esc_len) != OK) {
+            return rollback(sb, old_size);
+        }
+        i = j + 1;
+    }
+
+    return OK;
+}
+
+int strbuf_append_csv_escaped(strbuf_t* sb, const char* s, size_t n, char delim)
+{
+    if (sb == NULL || (s == NULL && n > 0)) {
+        return ERR;
+    }
+
+    const unsigned char* p = (const unsigned char*)s;
+    size_t first = csv_scan(p, 0, n, (unsigned char)delim);
+
+    if (first == n) {
+        /* nothing to quote: one bulk copy */
+        return strbuf_append_n(sb, s, n);
+    }
+
+    size_t off = self_offset(sb, s);
+    size_t old_size = sb->size;
+
+    if (strbuf_reserve(sb, n + 2) != OK || strbuf_append_n(sb, "\"", 1) != OK) {
+        return ERR;
+    }
+
+    /* inside quotes only '"' needs attention: it is doubled */
+    size_t i = 0;
+    while (i < n) {
+        s = source(sb, s, off);
+        const char* q = memchr(&s[i], '"', n - i);
+        size_t j = q ? (size_t)(q - s) + 1 : n;
+
+        if (strbuf_append_n(sb, &s[i], j - i) != OK) {
+            return rollback(sb, old_size);
+        }
+        if (q && strbuf_append_n(sb, "\"", 1) != OK) {
+            return rollback(sb, old_size);
+        }
+        i = j;
+    }
+
+    if (strbuf_append_n(sb, "\"", 1) != OK) {
+        return rollback(sb, old_size);
+    }
+    return OK;
+}
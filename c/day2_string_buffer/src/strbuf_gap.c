@@ -0,0 +1,216 @@
+#include "strbuf_gap.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define OK  (0)
+#define ERR (-1)
+
+#define MIN_GAP_CAPACITY (64)
+
+static size_t gap_len(const strbuf_gap_t* gb)
+{
+    return gb->gap_end - gb->gap_start;
+}
+
+/* Move the gap so that it starts at content offset pos. */
+static void move_gap(strbuf_gap_t* gb, size_t pos)
+{
+    if (pos < gb->gap_start) {
+        /* bytes [pos, gap_start) go behind the gap */
+        size_t n = gb->gap_start - pos;
+        memmove(&gb->data[gb->gap_end - n], &gb->data[pos], n);
+        gb->gap_start -= n;
+        gb->gap_end -= n;
+    } else if (pos > gb->gap_start) {
+        /* bytes after the gap up to pos come in front of it */
+        size_t n = pos - gb->gap_start;
+        memmove(&gb->data[gb->gap_start], &gb->data[gb->gap_end], n);
+        gb->gap_start += n;
+        gb->gap_end += n;
+    }
+}
+
+/* Make the gap at least `need` bytes long. */
+static int ensure_gap(strbuf_gap_t* gb, size_t need)
+{
+    if (gap_len(gb) >= need) {
+        return OK;
+    }
+
+    size_t size = gb->capacity - gap_len(gb);
+    if (need > SIZE_MAX - size) {
+        return ERR;
+    }
+    size_t new_capacity = gb->capacity <= SIZE_MAX / 2 ? gb->capacity * 2 : SIZE_MAX;
+    if (new_capacity < MIN_GAP_CAPACITY) {
+        new_capacity = MIN_GAP_CAPACITY;
+    }
+    if (new_capacity < size + need) {
+        new_capacity = size + need;
+    }
+
+    char* mem = realloc(gb->data, new_capacity);
+    if (mem == NULL) {
+        return ERR;
+    }
+
+    /* the tail moves to the end of the larger block */
+    size_t tail = gb->capacity - gb->gap_end;
+    memmove(&mem[new_capacity - tail], &mem[gb->gap_end], tail);
+    gb->data = mem;
+    gb->gap_end = new_capacity - tail;
+    gb->capacity = new_capacity;
+    return OK;
+}
+
+int strbuf_gap_init(strbuf_gap_t* gb, size_t initial_capacity)
+{
+    if (gb == NULL) {
+        return ERR;
+    }
+
+    gb->data = NULL;
+    gb->capacity = 0;
+    gb->gap_start = 0;
+    gb->gap_end = 0;
+    gb->cursor = 0;
+
+    if (initial_capacity > 0) {
+        gb->data = malloc(initial_capacity);
+        if (gb->data == NULL) {
+            return ERR;
+        }
+        gb->capacity = initial_capacity;
+        gb->gap_end = initial_capacity;
+    }
+    return OK;
+}
+
+void strbuf_gap_free(strbuf_gap_t* gb)
+{
+    if (gb == NULL) {
+        return;
+    }
+
+    free(gb->data);
+    gb->data = NULL;
+    gb->capacity = 0;
+    gb->gap_start = 0;
+    gb->gap_end = 0;
+    gb->cursor = 0;
+}
+
+size_t strbuf_gap_size(const strbuf_gap_t* gb)
+{
+    return gb ? gb->capacity - gap_len(gb) : 0;
+}
+
+int strbuf_gap_move_cursor(strbuf_gap_t* gb, size_t pos)
+{
+    if (gb == NULL || pos > strbuf_gap_size(gb)) {
+        return ERR;
+    }
+
+    gb->cursor = pos;
+    return OK;
+}
+
+int strbuf_gap_insert(strbuf_gap_t* gb, const char* s, size_t n)
+{
+    if (gb == NULL || (s == NULL && n > 0)) {
+        return ERR;
+    }
+
+    if (n == 0) {
+        return OK;
+    }
+
+    /* grow first: realloc + tail move is cheaper before the gap moves */
+    if (ensure_gap(gb, n) != OK) {
+        return ERR;
+    }
+    move_gap(gb, gb->cursor);
+
+    memcpy(&gb->data[gb->gap_start], s, n);
+    gb->gap_start += n;
+    gb->cursor += n;
+    return OK;
+}
+
+int strbuf_gap_insert_at(strbuf_gap_t* gb, size_t pos, const char* s, size_t n)
+{
+    if (gb == NULL || pos > strbuf_gap_size(gb)) {
+        return ERR;
+    }
+
+    size_t old_cursor = gb->cursor;
+    gb->cursor = pos;
+    if (strbuf_gap_insert(gb, s, n) != OK) {
+        gb->cursor = old_cursor;
+        return ERR;
+    }
+    return OK;
+}
+
+int strbuf_gap_erase_range(strbuf_gap_t* gb, size_t pos, size_t n)
+{
+    if (gb == NULL) {
+        return ERR;
+    }
+
+    size_t size = strbuf_gap_size(gb);
+    if (pos > size || n > size - pos) {
+        return ERR;
+    }
+
+    if (n > 0) {
+        if (pos + n == gb->gap_start) {
+            /* backspace: the erased bytes join the gap from the front */
+            gb->gap_start = pos;
+        } else {
+            move_gap(gb, pos);
+            gb->gap_end += n;
+        }
+    }
+    gb->cursor = pos;
+    return OK;
+}
+
+const char* strbuf_gap_c_str(strbuf_gap_t* gb)
+{
+    if (gb == NULL) {
+        return "";
+    }
+
+    size_t size = strbuf_gap_size(gb);
+    if (size == 0) {
+        return "";
+    }
+
+    move_gap(gb, size);
+    if (ensure_gap(gb, 1) != OK) {
+        /* "" would be indistinguishable from an empty buffer */
+        return NULL;
+    }
+
+    gb->data[size] = '\0';
+    return gb->data;
+}
+
+int strbuf_gap_append_to(strbuf_t* sb, const strbuf_gap_t* gb)
+{
+    if (sb == NULL || gb == NULL) {
+        return ERR;
+    }
+
+    size_t head = gb->gap_start;
+    size_t tail = gb->capacity - gb->gap_end;
+
+    if (strbuf_reserve(sb, head + tail) != OK) {
+        return ERR;
+    }
+    if (strbuf_append_n(sb, gb->data, head) != OK) {
+        return ERR;
+    }
+    return strbuf_append_n(sb, gb->data ? &gb->data[gb->gap_end] : NULL, tail);
+}
@@ -0,0 +1,70 @@
+#ifndef STRBUF_GAP_H
+#define STRBUF_GAP_H
+
+#include <stddef.h>
+
+#include "strbuf.h"
+
+/* Gap buffer for editing text in the middle: the content is kept as
+ * data[0..gap_start) followed by data[gap_end..capacity), with the unused
+ * bytes (the gap) in between. Inserting at the gap copies only the new
+ * bytes and erasing next to it copies nothing, so a run of edits near one
+ * place costs O(edit size) each.
+ * The cursor is where strbuf_gap_insert puts text. Moving it is O(1); the
+ * gap follows on the next edit, moving the bytes in between once.
+ * A contiguous NUL-terminated copy is only assembled by strbuf_gap_c_str,
+ * by moving the gap to the end.
+ */
+typedef struct {
+    char*  data;
+    size_t capacity;  // allocated bytes in data
+    size_t gap_start; // content before the gap ends here
+    size_t gap_end;   // content after the gap starts here
+    size_t cursor;    // insertion point, 0 <= cursor <= size
+} strbuf_gap_t;
+
+/* Initialize empty with room for initial_capacity bytes (0 allocates
+ * lazily).
+ * Returns 0 on success, -1 on allocation failure or invalid args.
+ */
+int strbuf_gap_init(strbuf_gap_t* gb, size_t initial_capacity);
+
+/* Free resources; safe to call multiple times. */
+void strbuf_gap_free(strbuf_gap_t* gb);
+
+/* Number of content bytes. */
+size_t strbuf_gap_size(const strbuf_gap_t* gb);
+
+/* Set the cursor to pos (0..size).
+ * Returns 0 on success, -1 if pos is past the end or on invalid args.
+ */
+int strbuf_gap_move_cursor(strbuf_gap_t* gb, size_t pos);
+
+/* Insert n bytes from s at the cursor and advance the cursor past them.
+ * strbuf_gap_insert_at first moves the cursor to pos.
+ * Returns 0 on success, -1 on allocation failure, pos past the end or
+ * invalid args (content and cursor are then unchanged).
+ */
+int strbuf_gap_insert(strbuf_gap_t* gb, const char* s, size_t n);
+int strbuf_gap_insert_at(strbuf_gap_t* gb, size_t pos, const char* s, size_t n);
+
+/* Remove the n bytes starting at pos; the cursor moves to pos.
+ * Returns 0 on success, -1 if the range is not inside the content or on
+ * invalid args.
+ */
+int strbuf_gap_erase_range(strbuf_gap_t* gb, size_t pos, size_t n);
+
+/* Return the content as a NUL-terminated string, moving the gap to the end
+ * first (O(bytes after the gap)); the cursor is unchanged. Valid until the
+ * next modification. "" when empty or on invalid args; NULL if the
+ * terminator needed more room and the allocation failed (the content is
+ * unchanged, only the gap has moved).
+ */
+const char* strbuf_gap_c_str(strbuf_gap_t* gb);
+
+/* Append the content to sb (two copies around the gap, no reshuffle).
+ * Returns 0 on success, -1 on allocation failure or invalid args.
+ */
+int strbuf_gap_append_to(strbuf_t* sb, const strbuf_gap_t* gb);
+
+#endif
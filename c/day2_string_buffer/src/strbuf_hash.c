@@ -0,0 +1,128 @@
+#include "strbuf.h"
+#include <string.h>
+
+/*
+ * wyhash (final version 4, Wang Yi, public domain): 64x64->128 bit
+ * multiply-folds over 16-48 byte strides, so short keys cost a couple of
+ * multiplies and long ones run at memory speed without SIMD.
+ */
+static const uint64_t kSecret[4] = {
+    0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL,
+    0x4b33a62ed433d4a3ULL, 0x4d5a2da51de1aa47ULL,
+};
+
+/* Full 128-bit product of *a and *b: low half to *a, high half to *b. */
+static void mum(uint64_t* a, uint64_t* b)
+{
+#if defined(__SIZEOF_INT128__)
+    __uint128_t r = (__uint128_t)*a * *b;
+    *a = (uint64_t)r;
+    *b = (uint64_t)(r >> 64);
+#else
+    uint64_t ha = *a >> 32, hb = *b >> 32, la = (uint32_t)*a, lb = (uint32_t)*b;
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64_t t = rl + (rm0 << 32);
+    uint64_t c = t < rl;
+    uint64_t lo = t + (rm1 << 32);
+    c += lo < t;
+    *a = lo;
+    *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+static uint64_t mix(uint64_t a, uint64_t b)
+{
+    mum(&a, &b);
+    return a ^ b;
+}
+
+static uint64_t read8(const unsigned char* p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static uint64_t read4(const unsigned char* p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/* 1..3 bytes: first, middle and last byte */
+static uint64_t read3(const unsigned char* p, size_t k)
+{
+    return ((uint64_t)p[0] << 16) | ((uint64_t)p[k >> 1] << 8) | p[k - 1];
+}
+
+uint64_t strbuf_hash_bytes(const void* data, size_t n, uint64_t seed)
+{
+    const unsigned char* p = data;
+    uint64_t a, b;
+
+    seed ^= mix(seed ^ kSecret[0], kSecret[1]);
+
+    if (n <= 16) {
+        if (n >= 4) {
+            /* two possibly overlapping 4-byte reads from each end */
+            size_t mid = (n >> 3) << 2;
+            a = (read4(p) << 32) | read4(p + mid);
+            b = (read4(p + n - 4) << 32) | read4(p + n - 4 - mid);
+        } else if (n > 0) {
+            a = read3(p, n);
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        size_t i = n;
+        if (i > 48) {
+            /* three independent lanes hide the multiply latency */
+            uint64_t see1 = seed, see2 = seed;
+            do {
+                seed = mix(read8(p) ^ kSecret[1], read8(p + 8) ^ seed);
+                see1 = mix(read8(p + 16) ^ kSecret[2], read8(p + 24) ^ see1);
+                see2 = mix(read8(p + 32) ^ kSecret[3], read8(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= see1 ^ see2;
+        }
+        while (i > 16) {
+            seed = mix(read8(p) ^ kSecret[1], read8(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        /* the last 16 bytes, overlapping what was already mixed */
+        a = read8(p + i - 16);
+        b = read8(p + i - 8);
+    }
+
+    a ^= kSecret[1];
+    b ^= seed;
+    mum(&a, &b);
+    return mix(a ^ kSecret[0] ^ n, b ^ kSecret[1]);
+}
+
+uint64_t strbuf_view_hash(strbuf_view_t v)
+{
+    return strbuf_hash_bytes(v.data ? v.data : "", v.data ? v.size : 0, 0);
+}
+
+uint64_t strbuf_hash(strbuf_t* sb)
+{
+    if (sb == NULL) {
+        return strbuf_hash_bytes("", 0, 0);
+    }
+
+    if (sb->flags & STRBUF_F_INLINE) {
+        /* hash shares its bytes with inline_buf; short strings hash fast */
+        return strbuf_hash_bytes(sb->data, sb->size, 0);
+    }
+    if (!(sb->flags & STRBUF_F_HASHED)) {
+        sb->hash = strbuf_hash_bytes(sb->data ? sb->data : "", sb->data ? sb->size : 0, 0);
+        sb->flags |= STRBUF_F_HASHED;
+    }
+    return sb->hash;
+}
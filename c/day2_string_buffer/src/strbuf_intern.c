@@ -0,0 +1,183 @@
+#include "strbuf_intern.h"
+#include "strbuf_priv.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define OK  (0)
+#define ERR (-1)
+
+#define MIN_SLOTS         (64)
+#define MIN_STRINGS       (64)
+
+/* 32-bit hash of a byte string; never 0 so a slot of 0 means empty.
+ * Uses the high half of strbuf_hash_bytes with seed 0.
+ */
+static uint32_t hash_bytes(const char* s, size_t n)
+{
+    uint32_t h32 = (uint32_t)(strbuf_hash_bytes(s, n, 0) >> 32);
+    return h32 ? h32 : 1;
+}
+
+/* Copy s into the arena with a terminator; returns its stable address. */
+static char* arena_store(strbuf_intern_t* pool, const char* s, size_t n)
+{
+    if (n + 1 == 0) {
+        return NULL;
+    }
+
+    char* dst = strbuf_arena_take(&pool->arena, n + 1);
+    if (dst == NULL) {
+        return NULL;
+    }
+    memcpy(dst, s, n);
+    dst[n] = '\0';
+    return dst;
+}
+
+static int rehash(strbuf_intern_t* pool, size_t nslots)
+{
+    uint64_t* slots = calloc(nslots, sizeof(*slots));
+
+    if (slots == NULL) {
+        return ERR;
+    }
+
+    for (size_t i = 0; i < pool->nslots; i++) {
+        uint64_t e = pool->slots[i];
+        if (e == 0) {
+            continue;
+        }
+        size_t j = (size_t)(e >> 32) & (nslots - 1);
+        while (slots[j] != 0) {
+            j = (j + 1) & (nslots - 1);
+        }
+        slots[j] = e;
+    }
+
+    free(pool->slots);
+    pool->slots = slots;
+    pool->nslots = nslots;
+    return OK;
+}
+
+/* Slot holding s, or the empty slot where it would go. */
+static size_t probe(const strbuf_intern_t* pool, const char* s, size_t n, uint32_t h)
+{
+    size_t mask = pool->nslots - 1;
+    size_t i = h & mask;
+
+    for (;; i = (i + 1) & mask) {
+        uint64_t e = pool->slots[i];
+        if (e == 0) {
+            return i;
+        }
+        if ((uint32_t)(e >> 32) == h) {
+            const strbuf_view_t* v = &pool->strings[(uint32_t)e - 1];
+            if (v->size == n && memcmp(v->data, s, n) == 0) {
+                return i;
+            }
+        }
+    }
+}
+
+int strbuf_intern_init(strbuf_intern_t* pool)
+{
+    if (pool == NULL) {
+        return ERR;
+    }
+
+    memset(pool, 0, sizeof(*pool));
+    return strbuf_arena_init(&pool->arena, 0);
+}
+
+void strbuf_intern_free(strbuf_intern_t* pool)
+{
+    if (pool == NULL) {
+        return;
+    }
+
+    strbuf_arena_free(&pool->arena);
+    free(pool->strings);
+    free(pool->slots);
+    strbuf_intern_init(pool);
+}
+
+strbuf_atom_t strbuf_intern_find(const strbuf_intern_t* pool, const char* s, size_t n)
+{
+    if (pool == NULL || (s == NULL && n > 0) || pool->nslots == 0) {
+        return 0;
+    }
+
+    size_t i = probe(pool, s ? s : "", n, hash_bytes(s ? s : "", n));
+    return (strbuf_atom_t)pool->slots[i];
+}
+
+strbuf_atom_t strbuf_intern(strbuf_intern_t* pool, const char* s, size_t n)
+{
+    if (pool == NULL || (s == NULL && n > 0)) {
+        return 0;
+    }
+    if (s == NULL) {
+        s = "";
+    }
+
+    /* keep the load factor at or below 1/2 */
+    if (2 * (pool->count + 1) > pool->nslots) {
+        size_t nslots = pool->nslots ? pool->nslots * 2 : MIN_SLOTS;
+        if (rehash(pool, nslots) != OK) {
+            return 0;
+        }
+    }
+
+    uint32_t h = hash_bytes(s, n);
+    size_t i = probe(pool, s, n, h);
+
+    if (pool->slots[i] != 0) {
+        return (strbuf_atom_t)pool->slots[i];
+    }
+
+    if (pool->count == UINT32_MAX) {
+        return 0;
+    }
+    if (pool->count == pool->strings_cap) {
+        size_t cap = pool->strings_cap ? pool->strings_cap * 2 : MIN_STRINGS;
+        strbuf_view_t* strings = realloc(pool->strings, cap * sizeof(*strings));
+        if (strings == NULL) {
+            return 0;
+        }
+        pool->strings = strings;
+        pool->strings_cap = cap;
+    }
+
+    char* stored = arena_store(pool, s, n);
+    if (stored == NULL) {
+        return 0;
+    }
+
+    pool->strings[pool->count].data = stored;
+    pool->strings[pool->count].size = n;
+    pool->count++;
+
+    strbuf_atom_t atom = (strbuf_atom_t)pool->count;
+    pool->slots[i] = (uint64_t)h << 32 | atom;
+    return atom;
+}
+
+strbuf_atom_t strbuf_intern_sb(strbuf_intern_t* pool, const strbuf_t* sb)
+{
+    if (sb == NULL) {
+        return 0;
+    }
+
+    return strbuf_intern(pool, sb->data, sb->data ? sb->size : 0);
+}
+
+strbuf_view_t strbuf_intern_get(const strbuf_intern_t* pool, strbuf_atom_t atom)
+{
+    strbuf_view_t v = {NULL, 0};
+
+    if (pool != NULL && atom != 0 && atom <= pool->count) {
+        v = pool->strings[atom - 1];
+    }
+    return v;
+}
@@ -0,0 +1,50 @@
+#ifndef STRBUF_INTERN_H
+#define STRBUF_INTERN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "strbuf.h"
+#include "strbuf_arena.h"
+
+/* String interning pool.
+ * Every distinct byte string is stored once, NUL-terminated, in a
+ * strbuf_arena_t and identified by a small integer handle. Interning the same bytes
+ * again returns the same handle, so two interned strings are equal exactly
+ * when their handles are, and their stored bytes are at the same address.
+ * Stored strings never move and live until the pool is freed.
+ */
+
+/* Handle of an interned string; 0 is never a valid handle. */
+typedef uint32_t strbuf_atom_t;
+
+typedef struct {
+    strbuf_arena_t arena;       // storage of the strings, never reset
+    strbuf_view_t* strings;     // strings[atom - 1]
+    size_t         count;       // number of interned strings
+    size_t         strings_cap;
+    uint64_t*      slots;       // hash table: hash << 32 | atom, 0 = empty
+    size_t         nslots;      // power of two
+} strbuf_intern_t;
+
+/* Initialize an empty pool. Returns 0 on success, -1 on invalid args. */
+int strbuf_intern_init(strbuf_intern_t* pool);
+
+/* Free the pool and every string in it; safe to call multiple times. */
+void strbuf_intern_free(strbuf_intern_t* pool);
+
+/* Intern the n bytes at s (may include '\0') or the content of sb.
+ * Returns the handle, or 0 on allocation failure or invalid args.
+ */
+strbuf_atom_t strbuf_intern(strbuf_intern_t* pool, const char* s, size_t n);
+strbuf_atom_t strbuf_intern_sb(strbuf_intern_t* pool, const strbuf_t* sb);
+
+/* Handle of the n bytes at s if they are interned, else 0; never inserts. */
+strbuf_atom_t strbuf_intern_find(const strbuf_intern_t* pool, const char* s, size_t n);
+
+/* The string behind atom; data is NUL-terminated and stays valid until
+ * the pool is freed. An invalid atom gives {NULL, 0}.
+ */
+strbuf_view_t strbuf_intern_get(const strbuf_intern_t* pool, strbuf_atom_t atom);
+
+#endif
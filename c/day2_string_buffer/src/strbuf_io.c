@@ -0,0 +1,341 @@
+#define _GNU_SOURCE
+#include "strbuf_io.h"
+#include "strbuf_priv.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#ifndef IOV_MAX
+#define IOV_MAX (1024)
+#endif
+
+#define IOV_BATCH (IOV_MAX < 1024 ? IOV_MAX : 1024)
+
+#define LINE_BLOCK_DEFAULT (1u << 20)
+
+/* Length and address of piece i of a gather source. */
+typedef size_t (*piece_fn)(const void* src, size_t i, const char** data);
+
+static size_t strbuf_piece(const void* src, size_t i, const char** data)
+{
+    const strbuf_t* sb = ((const strbuf_t* const*)src)[i];
+    *data = sb ? sb->data : NULL;
+    return (sb && sb->data) ? sb->size : 0;
+}
+
+static size_t rope_piece(const void* src, size_t i, const char** data)
+{
+    return strbuf_rope_chunk(src, i, data);
+}
+
+static size_t piece_size(const void* src, piece_fn piece, size_t i)
+{
+    const char* data;
+    return piece(src, i, &data);
+}
+
+static int gather_write(int fd, const void* src, piece_fn piece, size_t count,
+                        int positional, off_t offset, size_t* consumed)
+{
+    if (fd < 0 || (src == NULL && count > 0) || consumed == NULL) {
+        errno = EINVAL;
+        return STRBUF_IO_ERR;
+    }
+
+    struct iovec iov[IOV_BATCH];
+    size_t idx = 0;
+    size_t skip = *consumed;
+
+    /* find the buffer and offset where the previous call stopped */
+    while (idx < count && skip >= piece_size(src, piece, idx)) {
+        skip -= piece_size(src, piece, idx);
+        idx++;
+    }
+
+    while (idx < count) {
+        int iovcnt = 0;
+        size_t batch_idx = idx;
+        size_t batch_skip = skip;
+
+        while (batch_idx < count && iovcnt < IOV_BATCH) {
+            const char* data;
+            size_t len = piece(src, batch_idx, &data);
+            if (len > batch_skip) {
+                iov[iovcnt].iov_base = (char*)&data[batch_skip];
+                iov[iovcnt].iov_len = len - batch_skip;
+                iovcnt++;
+            }
+            batch_skip = 0;
+            batch_idx++;
+        }
+
+        if (iovcnt == 0) {
+            break;
+        }
+
+        ssize_t n;
+        if (positional) {
+            n = pwritev(fd, iov, iovcnt, offset + (off_t)*consumed);
+        } else {
+            n = writev(fd, iov, iovcnt);
+        }
+
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return STRBUF_IO_PENDING;
+            }
+            return STRBUF_IO_ERR;
+        }
+        if (n == 0) {
+            /* no progress possible; do not spin */
+            errno = EIO;
+            return STRBUF_IO_ERR;
+        }
+
+        /* advance past what was written; a short write resumes mid-buffer */
+        size_t written = (size_t)n;
+        *consumed += written;
+        skip += written;
+        while (idx < count && skip >= piece_size(src, piece, idx)) {
+            skip -= piece_size(src, piece, idx);
+            idx++;
+        }
+    }
+
+    return STRBUF_IO_DONE;
+}
+
+int strbuf_writev_fd(int fd, const strbuf_t* const* bufs, size_t count, size_t* consumed)
+{
+    return gather_write(fd, bufs, strbuf_piece, count, 0, 0, consumed);
+}
+
+int strbuf_pwritev_fd(int fd, const strbuf_t* const* bufs, size_t count, off_t offset,
+                      size_t* consumed)
+{
+    if (offset < 0) {
+        errno = EINVAL;
+        return STRBUF_IO_ERR;
+    }
+
+    return gather_write(fd, bufs, strbuf_piece, count, 1, offset, consumed);
+}
+
+int strbuf_rope_writev_fd(int fd, const strbuf_rope_t* rope, size_t* consumed)
+{
+    if (rope == NULL) {
+        errno = EINVAL;
+        return STRBUF_IO_ERR;
+    }
+
+    return gather_write(fd, rope, rope_piece, rope->nchunks, 0, 0, consumed);
+}
+
+/* Length of the reservation behind a mapping of capacity bytes. */
+static size_t map_length(size_t capacity)
+{
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    return (capacity + page - 1) & ~(page - 1);
+}
+
+void strbuf_unmap(strbuf_t* sb)
+{
+    munmap(sb->data, map_length(sb->capacity));
+}
+
+/* close() that preserves the errno of an earlier failure */
+static int fail_close(int fd)
+{
+    int saved = errno;
+    close(fd);
+    errno = saved;
+    return STRBUF_IO_ERR;
+}
+
+int strbuf_map_file(strbuf_t* sb, const char* path)
+{
+    if (sb == NULL || path == NULL) {
+        errno = EINVAL;
+        return STRBUF_IO_ERR;
+    }
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return STRBUF_IO_ERR;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        return fail_close(fd);
+    }
+    if (!S_ISREG(st.st_mode)) {
+        errno = EINVAL;
+        return fail_close(fd);
+    }
+    if ((uintmax_t)st.st_size >= SIZE_MAX) {
+        errno = EFBIG;
+        return fail_close(fd);
+    }
+
+    size_t size = (size_t)st.st_size;
+
+    if (size == 0) {
+        close(fd);
+        sb->data = NULL;
+        sb->size = 0;
+        sb->capacity = 0;
+        sb->flags = 0;
+        sb->arena = NULL;
+        return STRBUF_IO_DONE;
+    }
+
+    /* Reserve one byte more than the file, rounded to pages, as zero-filled
+     * anonymous memory and map the file over its start. The terminator then
+     * comes for free: either from the zeroed tail of the file's last page or,
+     * when the size is a page multiple, from the anonymous page after it. */
+    size_t len = map_length(size + 1);
+    char* base = mmap(NULL, len, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        return fail_close(fd);
+    }
+    if (mmap(base, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        int saved = errno;
+        munmap(base, len);
+        errno = saved;
+        return fail_close(fd);
+    }
+    close(fd);
+
+    /* advisory only; a failure does not affect correctness */
+    (void)madvise(base, size, MADV_SEQUENTIAL);
+
+    sb->data = base;
+    sb->size = size;
+    sb->capacity = size + 1;
+    sb->flags = STRBUF_F_MAPPED;
+    sb->arena = NULL;
+
+    return STRBUF_IO_DONE;
+}
+
+int strbuf_line_reader_init(strbuf_line_reader_t* lr, int fd, size_t block_size)
+{
+    if (lr == NULL || fd < 0) {
+        errno = EINVAL;
+        return STRBUF_IO_ERR;
+    }
+
+    if (block_size == 0) {
+        block_size = LINE_BLOCK_DEFAULT;
+    }
+
+    lr->pos = 0;
+    lr->scan = 0;
+    lr->fd = fd;
+    lr->eof = 0;
+
+    /* one extra byte keeps the block NUL-terminated after a full read */
+    if (block_size == SIZE_MAX || strbuf_init(&lr->block, block_size + 1) != 0) {
+        errno = ENOMEM;
+        return STRBUF_IO_ERR;
+    }
+
+    return STRBUF_IO_DONE;
+}
+
+void strbuf_line_reader_free(strbuf_line_reader_t* lr)
+{
+    if (lr == NULL) {
+        return;
+    }
+
+    strbuf_free(&lr->block);
+    lr->pos = 0;
+    lr->scan = 0;
+    lr->fd = -1;
+    lr->eof = 1;
+}
+
+/* Move the partial line to the front of the block and read more after it. */
+static int refill(strbuf_line_reader_t* lr)
+{
+    strbuf_t* b = &lr->block;
+
+    if (lr->pos > 0) {
+        memmove(b->data, &b->data[lr->pos], b->size - lr->pos);
+        b->size -= lr->pos;
+        lr->scan -= lr->pos;
+        lr->pos = 0;
+    }
+
+    /* the block is full of a single line: double it */
+    if (b->size + 1 == b->capacity && strbuf_reserve(b, b->size) != 0) {
+        errno = ENOMEM;
+        return STRBUF_IO_ERR;
+    }
+
+    ssize_t n;
+    do {
+        n = read(lr->fd, &b->data[b->size], b->capacity - 1 - b->size);
+    } while (n < 0 && errno == EINTR);
+
+    if (n < 0) {
+        return STRBUF_IO_ERR;
+    }
+    if (n == 0) {
+        lr->eof = 1;
+    }
+
+    b->size += (size_t)n;
+    b->data[b->size] = '\0';
+    return STRBUF_IO_DONE;
+}
+
+int strbuf_read_line(strbuf_line_reader_t* lr, const char** line, size_t* len)
+{
+    if (lr == NULL || line == NULL || len == NULL || lr->block.data == NULL) {
+        errno = EINVAL;
+        return STRBUF_IO_ERR;
+    }
+
+    strbuf_t* b = &lr->block;
+
+    for (;;) {
+        size_t nl = strbuf_find_byte(b, lr->scan, '\n');
+
+        if (nl != STRBUF_NPOS) {
+            /* terminate the view in place of its newline */
+            b->data[nl] = '\0';
+            *line = &b->data[lr->pos];
+            *len = nl - lr->pos;
+            lr->pos = nl + 1;
+            lr->scan = lr->pos;
+            return 1;
+        }
+        lr->scan = b->size;
+
+        if (lr->eof) {
+            if (lr->pos == b->size) {
+                return 0;
+            }
+            /* last line without '\n'; data[size] is already '\0' */
+            *line = &b->data[lr->pos];
+            *len = b->size - lr->pos;
+            lr->pos = b->size;
+            return 1;
+        }
+
+        if (refill(lr) != 0) {
+            return STRBUF_IO_ERR;
+        }
+    }
+}
@@ -0,0 +1,81 @@
+#ifndef STRBUF_IO_H
+#define STRBUF_IO_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#include "strbuf.h"
+#include "strbuf_rope.h"
+
+/* POSIX I/O helpers for strbuf_t. */
+
+/* Return values of the gather writers */
+#define STRBUF_IO_DONE    (0)  // everything written
+#define STRBUF_IO_PENDING (1)  // fd would block; call again when writable
+#define STRBUF_IO_ERR     (-1) // write error, errno is set
+
+/* Write the concatenation of bufs[0..count) to fd without copying it into
+ * a staging buffer: the contents are handed to writev directly, as many
+ * buffers per call as IOV_MAX allows.
+ * *consumed is the number of bytes of the concatenation already written;
+ * writing resumes there and *consumed is advanced by every byte written,
+ * including on STRBUF_IO_PENDING and STRBUF_IO_ERR. Start with 0.
+ * Partial writes are continued and EINTR is retried. NULL entries are
+ * treated as empty buffers.
+ */
+int strbuf_writev_fd(int fd, const strbuf_t* const* bufs, size_t count, size_t* consumed);
+
+/* Same as strbuf_writev_fd, but positional: byte i of the concatenation
+ * goes to file offset offset + i (pwritev; the file position is unchanged).
+ */
+int strbuf_pwritev_fd(int fd, const strbuf_t* const* bufs, size_t count, off_t offset,
+                      size_t* consumed);
+
+/* Write the content of a rope to fd, one iovec per chunk, with the same
+ * *consumed protocol and return values as strbuf_writev_fd.
+ */
+int strbuf_rope_writev_fd(int fd, const strbuf_rope_t* rope, size_t* consumed);
+
+/* Load the file at path into sb without reading it: the file is mapped
+ * read-only (MAP_PRIVATE, MADV_SEQUENTIAL) and sb becomes a view of it with
+ * STRBUF_F_MAPPED set. data[size] is a readable '\0', so strbuf_c_str and
+ * the search functions work unchanged. The first modifying call copies the
+ * content into an owned heap buffer; the file itself is never written.
+ * Changes to the file while it is mapped are undefined for the view.
+ * An empty file gives an empty buffer. sb must not hold a buffer yet.
+ * Returns 0 on success, -1 on failure (errno is set).
+ */
+int strbuf_map_file(strbuf_t* sb, const char* path);
+
+/* Buffered line reader over a blocking fd.
+ * Input is read in large blocks straight into block; lines are returned as
+ * views into it, so the only copy made is of the partial line left at the
+ * end of a block, which is moved to the front before the next read.
+ * Like the strbuf_t it embeds, a reader must not be copied while in use.
+ */
+typedef struct {
+    strbuf_t block; // data read but not yet returned starts at pos
+    size_t   pos;   // start of the next line in block
+    size_t   scan;  // block[pos..scan) is known to hold no '\n'
+    int      fd;
+    int      eof;
+} strbuf_line_reader_t;
+
+/* Read from fd in blocks of block_size bytes (0 picks a default of 1 MiB).
+ * A line longer than a block grows the block to fit it.
+ * The reader does not own fd. Returns 0 on success, -1 on failure.
+ */
+int strbuf_line_reader_init(strbuf_line_reader_t* lr, int fd, size_t block_size);
+
+/* Free resources; safe to call multiple times. */
+void strbuf_line_reader_free(strbuf_line_reader_t* lr);
+
+/* Return the next line in *line and *len, without its '\n'.
+ * The view is NUL-terminated (line[len] == '\0') and stays valid until the
+ * next call. A last line without a trailing '\n' is returned as well.
+ * Returns 1 if a line was returned, 0 at end of input, -1 on a read error
+ * (errno is set).
+ */
+int strbuf_read_line(strbuf_line_reader_t* lr, const char** line, size_t* len);
+
+#endif
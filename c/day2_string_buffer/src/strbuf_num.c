@@ -0,0 +1,425 @@
+#include "strbuf.h"
+#include <math.h>
+#include <string.h>
+
+#define OK  (0)
+#define ERR (-1)
+
+/* Longest outputs: 20 digits + sign for integers; for doubles 17 digits,
+ * sign, "0." and up to 5 leading zeros, or mantissa point and "e-308". */
+#define INT_BUF_LEN    (24)
+#define DOUBLE_BUF_LEN (32)
+
+static const char kDigitPairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static const uint64_t kPow10[20] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL,
+    10000000ULL, 100000000ULL, 1000000000ULL, 10000000000ULL,
+    100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+    100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+    100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL,
+};
+
+/* Number of decimal digits of v (1 for 0) without a loop: estimate from
+ * the bit length (log10(2) ~ 1233/4096), then correct by one compare. */
+static inline unsigned count_digits(uint64_t v)
+{
+    unsigned bits = 64 - (unsigned)__builtin_clzll(v | 1);
+    unsigned t = (bits * 1233) >> 12;
+    return t + (v >= kPow10[t]) + (v == 0);
+}
+
+/* Write the digits of v ending at end[-1], two at a time. */
+static inline void write_digits(char* end, uint64_t v)
+{
+    while (v >= 100) {
+        unsigned pair = (unsigned)(v % 100) * 2;
+        v /= 100;
+        *--end = kDigitPairs[pair + 1];
+        *--end = kDigitPairs[pair];
+    }
+    if (v >= 10) {
+        unsigned pair = (unsigned)v * 2;
+        *--end = kDigitPairs[pair + 1];
+        *--end = kDigitPairs[pair];
+    } else {
+        *--end = (char)('0' + v);
+    }
+}
+
+static size_t format_uint64(char* out, uint64_t v)
+{
+    unsigned len = count_digits(v);
+    write_digits(out + len, v);
+    return len;
+}
+
+int strbuf_append_uint64(strbuf_t* sb, uint64_t value)
+{
+    char buf[INT_BUF_LEN];
+
+    return strbuf_append_n(sb, buf, format_uint64(buf, value));
+}
+
+int strbuf_append_int(strbuf_t* sb, int64_t value)
+{
+    char buf[INT_BUF_LEN];
+    size_t len = 0;
+    /* negate in unsigned space so INT64_MIN does not overflow */
+    uint64_t magnitude = (uint64_t)value;
+
+    if (value < 0) {
+        buf[len++] = '-';
+        magnitude = 0 - magnitude;
+    }
+    len += format_uint64(&buf[len], magnitude);
+
+    return strbuf_append_n(sb, buf, len);
+}
+
+int strbuf_append_hex(strbuf_t* sb, uint64_t value)
+{
+    static const char kHexDigits[] = "0123456789abcdef";
+    char buf[INT_BUF_LEN];
+    /* one hex digit per started nibble, at least one */
+    size_t len = (64 - (size_t)__builtin_clzll(value | 1) + 3) / 4;
+
+    for (size_t i = len; i > 0; i--) {
+        buf[i - 1] = kHexDigits[value & 0xf];
+        value >>= 4;
+    }
+
+    return strbuf_append_n(sb, buf, len);
+}
+
+/*
+ * Shortest round-trip double formatting: Grisu2 (Loitsch, "Printing
+ * Floating-Point Numbers Quickly and Accurately with Integers", 2010).
+ * The result always parses back to the same double and is the shortest
+ * such digit string for the vast majority of inputs.
+ */
+
+typedef struct {
+    uint64_t f;
+    int      e;
+} diy_fp_t;
+
+#define DP_SIGNIFICAND_MASK (0x000FFFFFFFFFFFFFULL)
+#define DP_EXPONENT_MASK    (0x7FF0000000000000ULL)
+#define DP_HIDDEN_BIT       (0x0010000000000000ULL)
+#define DP_EXPONENT_BIAS    (0x3FF + 52)
+#define DP_MIN_EXPONENT     (-DP_EXPONENT_BIAS + 1)
+
+/* Normalized 64-bit significands and binary exponents of 10^k for
+ * k = -348, -340, ..., 340 (rounded to nearest). */
+static const uint64_t kCachedPowersF[] = {
+    0xfa8fd5a0081c0288ULL, 0xbaaee17fa23ebf76ULL, 0x8b16fb203055ac76ULL, 0xcf42894a5dce35eaULL,
+    0x9a6bb0aa55653b2dULL, 0xe61acf033d1a45dfULL, 0xab70fe17c79ac6caULL, 0xff77b1fcbebcdc4fULL,
+    0xbe5691ef416bd60cULL, 0x8dd01fad907ffc3cULL, 0xd3515c2831559a83ULL, 0x9d71ac8fada6c9b5ULL,
+    0xea9c227723ee8bcbULL, 0xaecc49914078536dULL, 0x823c12795db6ce57ULL, 0xc21094364dfb5637ULL,
+    0x9096ea6f3848984fULL, 0xd77485cb25823ac7ULL, 0xa086cfcd97bf97f4ULL, 0xef340a98172aace5ULL,
+    0xb23867fb2a35b28eULL, 0x84c8d4dfd2c63f3bULL, 0xc5dd44271ad3cdbaULL, 0x936b9fcebb25c996ULL,
+    0xdbac6c247d62a584ULL, 0xa3ab66580d5fdaf6ULL, 0xf3e2f893dec3f126ULL, 0xb5b5ada8aaff80b8ULL,
+    0x87625f056c7c4a8bULL, 0xc9bcff6034c13053ULL, 0x964e858c91ba2655ULL, 0xdff9772470297ebdULL,
+    0xa6dfbd9fb8e5b88fULL, 0xf8a95fcf88747d94ULL, 0xb94470938fa89bcfULL, 0x8a08f0f8bf0f156bULL,
+    0xcdb02555653131b6ULL, 0x993fe2c6d07b7facULL, 0xe45c10c42a2b3b06ULL, 0xaa242499697392d3ULL,
+    0xfd87b5f28300ca0eULL, 0xbce5086492111aebULL, 0x8cbccc096f5088ccULL, 0xd1b71758e219652cULL,
+    0x9c40000000000000ULL, 0xe8d4a51000000000ULL, 0xad78ebc5ac620000ULL, 0x813f3978f8940984ULL,
+    0xc097ce7bc90715b3ULL, 0x8f7e32ce7bea5c70ULL, 0xd5d238a4abe98068ULL, 0x9f4f2726179a2245ULL,
+    0xed63a231d4c4fb27ULL, 0xb0de65388cc8ada8ULL, 0x83c7088e1aab65dbULL, 0xc45d1df942711d9aULL,
+    0x924d692ca61be758ULL, 0xda01ee641a708deaULL, 0xa26da3999aef774aULL, 0xf209787bb47d6b85ULL,
+    0xb454e4a179dd1877ULL, 0x865b86925b9bc5c2ULL, 0xc83553c5c8965d3dULL, 0x952ab45cfa97a0b3ULL,
+    0xde469fbd99a05fe3ULL, 0xa59bc234db398c25ULL, 0xf6c69a72a3989f5cULL, 0xb7dcbf5354e9beceULL,
+    0x88fcf317f22241e2ULL, 0xcc20ce9bd35c78a5ULL, 0x98165af37b2153dfULL, 0xe2a0b5dc971f303aULL,
+    0xa8d9d1535ce3b396ULL, 0xfb9b7cd9a4a7443cULL, 0xbb764c4ca7a44410ULL, 0x8bab8eefb6409c1aULL,
+    0xd01fef10a657842cULL, 0x9b10a4e5e9913129ULL, 0xe7109bfba19c0c9dULL, 0xac2820d9623bf429ULL,
+    0x80444b5e7aa7cf85ULL, 0xbf21e44003acdd2dULL, 0x8e679c2f5e44ff8fULL, 0xd433179d9c8cb841ULL,
+    0x9e19db92b4e31ba9ULL, 0xeb96bf6ebadf77d9ULL, 0xaf87023b9bf0ee6bULL,
+};
+
+static const int16_t kCachedPowersE[] = {
+    -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980,
+    -954, -927, -901, -874, -847, -821, -794, -768, -741, -715,
+    -688, -661, -635, -608, -582, -555, -529, -502, -475, -449,
+    -422, -396, -369, -343, -316, -289, -263, -236, -210, -183,
+    -157, -130, -103, -77, -50, -24, 3, 30, 56, 83,
+    109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+    375, 402, 428, 455, 481, 508, 534, 561, 588, 614,
+    641, 667, 694, 720, 747, 774, 800, 827, 853, 880,
+    907, 933, 960, 986, 1013, 1039, 1066,
+};
+
+/* Upper 64 bits of a.f * b.f, rounded on the bit below them. */
+static diy_fp_t diy_fp_multiply(diy_fp_t a, diy_fp_t b)
+{
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 p = (unsigned __int128)a.f * b.f;
+    uint64_t h = (uint64_t)(p >> 64);
+    uint64_t l = (uint64_t)p;
+
+    /* round */
+    if (l & (1ULL << 63)) {
+        h++;
+    }
+#else
+    /* schoolbook on 32-bit halves; bit 31 of mid is bit 63 of the product */
+    const uint64_t m32 = 0xFFFFFFFFu;
+    uint64_t ah = a.f >> 32, al = a.f & m32;
+    uint64_t bh = b.f >> 32, bl = b.f & m32;
+    uint64_t hh = ah * bh, hl = ah * bl, lh = al * bh, ll = al * bl;
+    uint64_t mid = (ll >> 32) + (hl & m32) + (lh & m32);
+
+    /* round */
+    mid += 1ULL << 31;
+    uint64_t h = hh + (hl >> 32) + (lh >> 32) + (mid >> 32);
+#endif
+
+    diy_fp_t r = {h, a.e + b.e + 64};
+    return r;
+}
+
+static diy_fp_t diy_fp_normalize(diy_fp_t v)
+{
+    int s = __builtin_clzll(v.f);
+    diy_fp_t r = {v.f << s, v.e - s};
+    return r;
+}
+
+static diy_fp_t diy_fp_from_double(double d)
+{
+    uint64_t bits;
+    memcpy(&bits, &d, sizeof(bits));
+
+    int biased_e = (int)((bits & DP_EXPONENT_MASK) >> 52);
+    uint64_t significand = bits & DP_SIGNIFICAND_MASK;
+    diy_fp_t v;
+
+    if (biased_e != 0) {
+        v.f = significand + DP_HIDDEN_BIT;
+        v.e = biased_e - DP_EXPONENT_BIAS;
+    } else {
+        v.f = significand;
+        v.e = DP_MIN_EXPONENT;
+    }
+    return v;
+}
+
+/* Boundaries m- and m+ of the rounding interval of v, both with the
+ * exponent of the normalized m+. */
+static void normalized_boundaries(diy_fp_t v, diy_fp_t* minus, diy_fp_t* plus)
+{
+    diy_fp_t pl = {(v.f << 1) + 1, v.e - 1};
+    while (!(pl.f & (DP_HIDDEN_BIT << 1))) {
+        pl.f <<= 1;
+        pl.e--;
+    }
+    pl.f <<= 64 - 52 - 2;
+    pl.e -= 64 - 52 - 2;
+
+    diy_fp_t mi;
+    if (v.f == DP_HIDDEN_BIT) {
+        /* lower boundary is closer at a power of two */
+        mi.f = (v.f << 2) - 1;
+        mi.e = v.e - 2;
+    } else {
+        mi.f = (v.f << 1) - 1;
+        mi.e = v.e - 1;
+    }
+    mi.f <<= mi.e - pl.e;
+    mi.e = pl.e;
+
+    *plus = pl;
+    *minus = mi;
+}
+
+/* Cached power c = 10^-K such that the product with a number of binary
+ * exponent e lands in the exponent window Grisu needs. */
+static diy_fp_t cached_power(int e, int* K)
+{
+    double dk = (-61 - e) * 0.30102999566398114 + 347;
+    int k = (int)dk;
+    if (dk - k > 0.0) {
+        k++;
+    }
+
+    unsigned index = (unsigned)((k >> 3) + 1);
+    *K = -(-348 + (int)(index << 3));
+
+    diy_fp_t c = {kCachedPowersF[index], kCachedPowersE[index]};
+    return c;
+}
+
+static void grisu_round(char* buffer, int len, uint64_t delta, uint64_t rest,
+                        uint64_t ten_kappa, uint64_t wp_w)
+{
+    while (rest < wp_w && delta - rest >= ten_kappa &&
+           (rest + ten_kappa < wp_w || wp_w - rest > rest + ten_kappa - wp_w)) {
+        buffer[len - 1]--;
+        rest += ten_kappa;
+    }
+}
+
+static void digit_gen(diy_fp_t W, diy_fp_t Mp, uint64_t delta, char* buffer, int* len, int* K)
+{
+    diy_fp_t one = {1ULL << -Mp.e, Mp.e};
+    uint64_t wp_w = Mp.f - W.f;
+    uint32_t p1 = (uint32_t)(Mp.f >> -one.e);
+    uint64_t p2 = Mp.f & (one.f - 1);
+    int kappa = (int)count_digits(p1);
+
+    *len = 0;
+
+    while (kappa > 0) {
+        uint32_t d = p1 / (uint32_t)kPow10[kappa - 1];
+        p1 %= (uint32_t)kPow10[kappa - 1];
+        if (d || *len) {
+            buffer[(*len)++] = (char)('0' + d);
+        }
+        kappa--;
+
+        uint64_t tmp = ((uint64_t)p1 << -one.e) + p2;
+        if (tmp <= delta) {
+            *K += kappa;
+            grisu_round(buffer, *len, delta, tmp, kPow10[kappa] << -one.e, wp_w);
+            return;
+        }
+    }
+
+    for (;;) {
+        p2 *= 10;
+        delta *= 10;
+        char d = (char)(p2 >> -one.e);
+        if (d || *len) {
+            buffer[(*len)++] = (char)('0' + d);
+        }
+        p2 &= one.f - 1;
+        kappa--;
+
+        if (p2 < delta) {
+            *K += kappa;
+            int index = -kappa;
+            grisu_round(buffer, *len, delta, p2, one.f, wp_w * (index < 20 ? kPow10[index] : 0));
+            return;
+        }
+    }
+}
+
+/* Digits of positive finite v into buffer; v = digits * 10^K. */
+static void grisu2(double v, char* buffer, int* len, int* K)
+{
+    diy_fp_t w = diy_fp_from_double(v);
+    diy_fp_t w_m, w_p;
+
+    normalized_boundaries(w, &w_m, &w_p);
+
+    diy_fp_t c_mk = cached_power(w_p.e, K);
+    diy_fp_t W = diy_fp_multiply(diy_fp_normalize(w), c_mk);
+    diy_fp_t Wp = diy_fp_multiply(w_p, c_mk);
+    diy_fp_t Wm = diy_fp_multiply(w_m, c_mk);
+
+    /* shrink the interval by one ulp each side to stay safely inside */
+    Wm.f++;
+    Wp.f--;
+
+    digit_gen(W, Wp, Wp.f - Wm.f, buffer, len, K);
+}
+
+static char* write_exponent(char* out, int e)
+{
+    /* printf %e style: sign and at least two digits */
+    *out++ = 'e';
+    if (e < 0) {
+        *out++ = '-';
+        e = -e;
+    } else {
+        *out++ = '+';
+    }
+
+    if (e >= 100) {
+        *out++ = (char)('0' + e / 100);
+        e %= 100;
+    }
+    *out++ = kDigitPairs[e * 2];
+    *out++ = kDigitPairs[e * 2 + 1];
+    return out;
+}
+
+/* Lay out len digits with decimal exponent k (value = digits * 10^k):
+ * plain notation for 1e-5 <= |v| < 1e21, scientific otherwise.
+ * Returns the end of the written text.
+ */
+static char* prettify(char* buffer, int len, int k)
+{
+    int kk = len + k; /* 10^(kk-1) <= v < 10^kk */
+
+    if (k >= 0 && kk <= 21) {
+        /* 1234e7 -> 12340000000 */
+        memset(&buffer[len], '0', (size_t)(kk - len));
+        return &buffer[kk];
+    }
+
+    if (kk > 0 && kk <= 21) {
+        /* 1234e-2 -> 12.34 */
+        memmove(&buffer[kk + 1], &buffer[kk], (size_t)(len - kk));
+        buffer[kk] = '.';
+        return &buffer[len + 1];
+    }
+
+    if (kk > -5 && kk <= 0) {
+        /* 1234e-6 -> 0.001234 */
+        int offset = 2 - kk;
+        memmove(&buffer[offset], &buffer[0], (size_t)len);
+        buffer[0] = '0';
+        buffer[1] = '.';
+        memset(&buffer[2], '0', (size_t)(offset - 2));
+        return &buffer[len + offset];
+    }
+
+    if (len == 1) {
+        /* 1e30 */
+        return write_exponent(&buffer[1], kk - 1);
+    }
+
+    /* 1234e30 -> 1.234e+33 */
+    memmove(&buffer[2], &buffer[1], (size_t)(len - 1));
+    buffer[1] = '.';
+    return write_exponent(&buffer[len + 1], kk - 1);
+}
+
+int strbuf_append_double(strbuf_t* sb, double value)
+{
+    char buf[DOUBLE_BUF_LEN];
+    char* p = buf;
+
+    if (isnan(value)) {
+        return strbuf_append_n(sb, "nan", 3);
+    }
+
+    if (signbit(value)) {
+        *p++ = '-';
+        value = -value;
+    }
+
+    if (value == 0.0) {
+        *p++ = '0';
+    } else if (isinf(value)) {
+        memcpy(p, "inf", 3);
+        p += 3;
+    } else {
+        int len, K;
+        grisu2(value, p, &len, &K);
+        p = prettify(p, len, K);
+    }
+
+    return strbuf_append_n(sb, buf, (size_t)(p - buf));
+}
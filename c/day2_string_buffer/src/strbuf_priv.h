@@ -0,0 +1,63 @@
+#ifndef STRBUF_PRIV_H
+#define STRBUF_PRIV_H
+
+/* Internal helpers shared between the strbuf translation units.
+ * Not part of the public API.
+ */
+
+#include "strbuf.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define STRBUF_X86 (1)
+
+/* Runtime checks selecting the SIMD paths; the compiler caches the CPU
+ * feature bits, so these are cheap enough to call per operation.
+ */
+static inline int strbuf_have_avx2(void)
+{
+    return __builtin_cpu_supports("avx2");
+}
+
+static inline int strbuf_have_sse42(void)
+{
+    return __builtin_cpu_supports("sse4.2");
+}
+
+static inline int strbuf_have_pclmul(void)
+{
+    return __builtin_cpu_supports("pclmul");
+}
+#endif
+
+/* Release the file mapping behind a STRBUF_F_MAPPED buffer.
+ * Only unmaps; the caller resets the fields.
+ */
+void strbuf_unmap(strbuf_t* sb);
+
+/* Allocate n bytes of string storage from arena; NULL on failure. */
+char* strbuf_arena_take(struct strbuf_arena* arena, size_t n);
+
+/* Grow a STRBUF_F_ARENA buffer to new_capacity without moving it, which
+ * works while it is the last allocation of its arena and the block has room.
+ * Returns 0 on success, -1 if the buffer has to move.
+ */
+int strbuf_arena_extend(strbuf_t* sb, size_t new_capacity);
+
+/* Hand the storage of a STRBUF_F_ARENA buffer back if it was the last
+ * allocation; otherwise it is reclaimed by the next arena reset.
+ */
+void strbuf_arena_release(strbuf_t* sb);
+
+/* Bookkeeping after bytes were appended at the end of sb by writing into
+ * its spare capacity: drops the cached hash and advances a tracked CRC.
+ */
+void strbuf_appended(strbuf_t* sb);
+
+/* Shrink the content to size bytes (size <= sb->size), e.g. to undo a
+ * partial append. On a mapped buffer, which an append that wrote nothing
+ * leaves mapped, only the size changes.
+ */
+void strbuf_truncate(strbuf_t* sb, size_t size);
+
+#endif
@@ -0,0 +1,192 @@
+#define _GNU_SOURCE
+#include "strbuf_ring.h"
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define OK  (0)
+#define ERR (-1)
+
+/* The index owned by the other side: acquire-loaded in SPSC mode so the
+ * bytes it covers are visible before they are used.
+ */
+static size_t load_remote(const strbuf_ring_t* ring, const size_t* pos)
+{
+    if (ring->flags & STRBUF_RING_SPSC) {
+        return __atomic_load_n(pos, __ATOMIC_ACQUIRE);
+    }
+    return *pos;
+}
+
+/* Publish an index owned by this side, after the bytes it covers. */
+static void store_local(const strbuf_ring_t* ring, size_t* pos, size_t value)
+{
+    if (ring->flags & STRBUF_RING_SPSC) {
+        __atomic_store_n(pos, value, __ATOMIC_RELEASE);
+    } else {
+        *pos = value;
+    }
+}
+
+static size_t round_capacity(size_t n)
+{
+    size_t cap = (size_t)sysconf(_SC_PAGESIZE);
+
+    while (cap < n) {
+        if (cap > SIZE_MAX / 2) {
+            return 0;
+        }
+        cap *= 2;
+    }
+    return cap;
+}
+
+/* Reserve 2 * capacity bytes of address space and map the memfd into both
+ * halves. Returns the base address or NULL (errno is set).
+ */
+static char* map_mirrored(int fd, size_t capacity)
+{
+    char* base = mmap(NULL, 2 * capacity, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        return NULL;
+    }
+
+    for (int half = 0; half < 2; half++) {
+        void* p = mmap(base + half * capacity, capacity, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_FIXED, fd, 0);
+        if (p == MAP_FAILED) {
+            int saved = errno;
+            munmap(base, 2 * capacity);
+            errno = saved;
+            return NULL;
+        }
+    }
+    return base;
+}
+
+int strbuf_ring_init(strbuf_ring_t* ring, size_t min_capacity, unsigned flags)
+{
+    if (ring == NULL || (flags & ~STRBUF_RING_SPSC)) {
+        errno = EINVAL;
+        return ERR;
+    }
+
+    memset(ring, 0, sizeof(*ring));
+
+#if defined(__linux__)
+    size_t capacity = round_capacity(min_capacity);
+    if (capacity == 0 || capacity > SIZE_MAX / 2) {
+        errno = EINVAL;
+        return ERR;
+    }
+
+    int fd = memfd_create("strbuf_ring", MFD_CLOEXEC);
+    if (fd < 0) {
+        return ERR;
+    }
+    if (ftruncate(fd, (off_t)capacity) != 0) {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return ERR;
+    }
+
+    char* data = map_mirrored(fd, capacity);
+    /* the mappings keep the memory alive */
+    int saved = errno;
+    close(fd);
+    errno = saved;
+    if (data == NULL) {
+        return ERR;
+    }
+
+    ring->data = data;
+    ring->capacity = capacity;
+    ring->flags = flags;
+    return OK;
+#else
+    (void)min_capacity;
+    errno = ENOSYS;
+    return ERR;
+#endif
+}
+
+void strbuf_ring_free(strbuf_ring_t* ring)
+{
+    if (ring == NULL) {
+        return;
+    }
+
+    if (ring->data) {
+        munmap(ring->data, 2 * ring->capacity);
+    }
+    memset(ring, 0, sizeof(*ring));
+}
+
+char* strbuf_ring_write_ptr(strbuf_ring_t* ring, size_t* avail)
+{
+    size_t head = ring->head;
+
+    *avail = ring->capacity - (head - load_remote(ring, &ring->tail));
+    return &ring->data[head & (ring->capacity - 1)];
+}
+
+void strbuf_ring_commit(strbuf_ring_t* ring, size_t n)
+{
+    store_local(ring, &ring->head, ring->head + n);
+}
+
+const char* strbuf_ring_read_ptr(strbuf_ring_t* ring, size_t* avail)
+{
+    size_t tail = ring->tail;
+
+    *avail = load_remote(ring, &ring->head) - tail;
+    return &ring->data[tail & (ring->capacity - 1)];
+}
+
+void strbuf_ring_consume(strbuf_ring_t* ring, size_t n)
+{
+    store_local(ring, &ring->tail, ring->tail + n);
+}
+
+int strbuf_ring_write(strbuf_ring_t* ring, const char* s, size_t n)
+{
+    if (ring == NULL || ring->data == NULL || (s == NULL && n > 0)) {
+        return ERR;
+    }
+
+    size_t avail;
+    char* dst = strbuf_ring_write_ptr(ring, &avail);
+    if (avail < n) {
+        return ERR;
+    }
+
+    memcpy(dst, s, n);
+    strbuf_ring_commit(ring, n);
+    return OK;
+}
+
+long strbuf_ring_read_into(strbuf_ring_t* ring, strbuf_t* sb, size_t max)
+{
+    if (ring == NULL || ring->data == NULL || sb == NULL) {
+        return ERR;
+    }
+
+    size_t avail;
+    const char* src = strbuf_ring_read_ptr(ring, &avail);
+    if (avail > max) {
+        avail = max;
+    }
+    if (avail > LONG_MAX) {
+        avail = LONG_MAX;
+    }
+
+    if (strbuf_append_n(sb, src, avail) != OK) {
+        return ERR;
+    }
+    strbuf_ring_consume(ring, avail);
+    return (long)avail;
+}
@@ -0,0 +1,73 @@
+#ifndef STRBUF_RING_H
+#define STRBUF_RING_H
+
+#include <stddef.h>
+
+#include "strbuf.h"
+
+/* Byte ring buffer for streaming between a producer and a consumer.
+ * The storage is mapped twice, back to back, so the free space and the
+ * unread bytes are each always one contiguous span, also across the wrap:
+ * producers write (or read(2)) straight into strbuf_ring_write_ptr and
+ * consumers parse straight out of strbuf_ring_read_ptr, and nothing is ever
+ * moved to the front.
+ * head and tail count all bytes ever written and read; their difference is
+ * the unread amount.
+ *
+ * With STRBUF_RING_SPSC, one producer thread and one consumer thread may
+ * use the ring concurrently without locks: commits publish with release
+ * stores and the other side reads the index with acquire loads. Each side
+ * touches the other's cache line once per span rather than per byte, and
+ * head and tail sit on separate cache lines.
+ */
+
+#define STRBUF_RING_SPSC (1u << 0)
+
+#define STRBUF_RING_LINE (64)
+
+typedef struct {
+    char*    data;     // capacity bytes, mapped again at data + capacity
+    size_t   capacity; // power of two, multiple of the page size
+    unsigned flags;    // STRBUF_RING_*
+    char     pad0[STRBUF_RING_LINE];
+    size_t   head;     // bytes committed, written by the producer
+    char     pad1[STRBUF_RING_LINE];
+    size_t   tail;     // bytes consumed, written by the consumer
+    char     pad2[STRBUF_RING_LINE];
+} strbuf_ring_t;
+
+/* Create a ring holding at least min_capacity bytes (rounded up to a power
+ * of two and to whole pages). flags is 0 or STRBUF_RING_SPSC.
+ * Linux only (memfd_create); elsewhere fails with ENOSYS.
+ * Returns 0 on success, -1 on failure (errno is set).
+ */
+int strbuf_ring_init(strbuf_ring_t* ring, size_t min_capacity, unsigned flags);
+
+/* Unmap the storage; safe to call multiple times. */
+void strbuf_ring_free(strbuf_ring_t* ring);
+
+/* Producer side: the free space as one span of *avail bytes. Fill any
+ * prefix of it, then publish that many bytes with strbuf_ring_commit
+ * (n <= *avail).
+ */
+char* strbuf_ring_write_ptr(strbuf_ring_t* ring, size_t* avail);
+void strbuf_ring_commit(strbuf_ring_t* ring, size_t n);
+
+/* Consumer side: the unread bytes as one span of *avail bytes, valid until
+ * they are released with strbuf_ring_consume (n <= *avail).
+ */
+const char* strbuf_ring_read_ptr(strbuf_ring_t* ring, size_t* avail);
+void strbuf_ring_consume(strbuf_ring_t* ring, size_t n);
+
+/* Copy all n bytes in, or nothing if fewer than n bytes are free.
+ * Returns 0 on success, -1 if the ring is too full or on invalid args.
+ */
+int strbuf_ring_write(strbuf_ring_t* ring, const char* s, size_t n);
+
+/* Move up to max unread bytes to the end of sb and consume them.
+ * Returns the number of bytes moved, or -1 on allocation failure or
+ * invalid args (nothing is consumed then).
+ */
+long strbuf_ring_read_into(strbuf_ring_t* ring, strbuf_t* sb, size_t max);
+
+#endif
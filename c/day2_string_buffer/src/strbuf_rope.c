@@ -0,0 +1,196 @@
+#include "strbuf_rope.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define OK  (0)
+#define ERR (-1)
+
+#define ROPE_CHUNK_DEFAULT (1u << 20)
+#define MIN_CHUNK_SLOTS    (16)
+
+/* Unused bytes at the end of the last chunk (0 if there is none). */
+static size_t tail_vacant(const strbuf_rope_t* rope)
+{
+    if (rope->nchunks == 0) {
+        return 0;
+    }
+    const strbuf_rope_chunk_t* tail = &rope->chunks[rope->nchunks - 1];
+    return tail->capacity - tail->size;
+}
+
+/* Start a new last chunk of capacity bytes. */
+static int add_chunk(strbuf_rope_t* rope, size_t capacity)
+{
+    if (rope->nchunks == rope->chunks_cap) {
+        size_t cap = rope->chunks_cap ? rope->chunks_cap * 2 : MIN_CHUNK_SLOTS;
+        if (cap > SIZE_MAX / sizeof(*rope->chunks)) {
+            return ERR;
+        }
+        /* only the pointer array moves; chunk contents stay put */
+        strbuf_rope_chunk_t* chunks = realloc(rope->chunks, cap * sizeof(*chunks));
+        if (chunks == NULL) {
+            return ERR;
+        }
+        rope->chunks = chunks;
+        rope->chunks_cap = cap;
+    }
+
+    char* data = malloc(capacity);
+    if (data == NULL) {
+        return ERR;
+    }
+    strbuf_rope_chunk_t* chunk = &rope->chunks[rope->nchunks++];
+    chunk->data = data;
+    chunk->size = 0;
+    chunk->capacity = capacity;
+    return OK;
+}
+
+int strbuf_rope_init(strbuf_rope_t* rope, size_t chunk_size)
+{
+    if (rope == NULL) {
+        return ERR;
+    }
+
+    rope->chunks = NULL;
+    rope->nchunks = 0;
+    rope->chunks_cap = 0;
+    rope->chunk_size = chunk_size ? chunk_size : ROPE_CHUNK_DEFAULT;
+    rope->size = 0;
+    return OK;
+}
+
+void strbuf_rope_free(strbuf_rope_t* rope)
+{
+    if (rope == NULL) {
+        return;
+    }
+
+    for (size_t i = 0; i < rope->nchunks; i++) {
+        free(rope->chunks[i].data);
+    }
+    free(rope->chunks);
+
+    rope->chunks = NULL;
+    rope->nchunks = 0;
+    rope->chunks_cap = 0;
+    rope->size = 0;
+}
+
+int strbuf_rope_append(strbuf_rope_t* rope, const char* s, size_t n)
+{
+    if (rope == NULL || (s == NULL && n > 0)) {
+        return ERR;
+    }
+
+    if (n > SIZE_MAX - rope->size) {
+        return ERR;
+    }
+
+    while (n > 0) {
+        size_t len = tail_vacant(rope);
+        if (len == 0) {
+            if (add_chunk(rope, rope->chunk_size) != OK) {
+                return ERR;
+            }
+            len = rope->chunk_size;
+        }
+
+        if (len > n) {
+            len = n;
+        }
+        strbuf_rope_chunk_t* tail = &rope->chunks[rope->nchunks - 1];
+        memcpy(&tail->data[tail->size], s, len);
+        tail->size += len;
+        rope->size += len;
+        s += len;
+        n -= len;
+    }
+
+    return OK;
+}
+
+int strbuf_rope_vappendf(strbuf_rope_t* rope, const char* fmt, va_list ap)
+{
+    if (rope == NULL || fmt == NULL) {
+        return ERR;
+    }
+
+    va_list ap_retry;
+    va_copy(ap_retry, ap);
+
+    /* vsnprintf needs room for a '\0' that is not kept */
+    size_t vacant = tail_vacant(rope);
+    strbuf_rope_chunk_t* tail = vacant ? &rope->chunks[rope->nchunks - 1] : NULL;
+    char tmp[1];
+    int len = vsnprintf(tail ? &tail->data[tail->size] : tmp, tail ? vacant : sizeof(tmp), fmt, ap);
+
+    if (len > 0 && (size_t)len >= vacant) {
+        /* did not fit: format again at the start of a chunk that fits it */
+        size_t need = (size_t)len + 1;
+        if ((size_t)len > SIZE_MAX - rope->size ||
+            add_chunk(rope, need > rope->chunk_size ? need : rope->chunk_size) != OK) {
+            len = -1;
+        } else {
+            tail = &rope->chunks[rope->nchunks - 1];
+            vsnprintf(tail->data, need, fmt, ap_retry);
+        }
+    }
+    va_end(ap_retry);
+
+    if (len < 0) {
+        return ERR;
+    }
+    if (len > 0) {
+        tail->size += (size_t)len;
+        rope->size += (size_t)len;
+    }
+    return OK;
+}
+
+int strbuf_rope_appendf(strbuf_rope_t* rope, const char* fmt, ...)
+{
+    va_list ap;
+
+    va_start(ap, fmt);
+    int ret = strbuf_rope_vappendf(rope, fmt, ap);
+    va_end(ap);
+
+    return ret;
+}
+
+size_t strbuf_rope_chunk(const strbuf_rope_t* rope, size_t i, const char** data)
+{
+    if (rope == NULL || i >= rope->nchunks) {
+        *data = NULL;
+        return 0;
+    }
+
+    *data = rope->chunks[i].data;
+    return rope->chunks[i].size;
+}
+
+int strbuf_rope_flatten(strbuf_rope_t* rope, strbuf_t* sb)
+{
+    if (rope == NULL || sb == NULL) {
+        return ERR;
+    }
+
+    if (strbuf_reserve(sb, rope->size) != OK) {
+        return ERR;
+    }
+
+    for (size_t i = 0; i < rope->nchunks; i++) {
+        const char* data;
+        size_t len = strbuf_rope_chunk(rope, i, &data);
+        /* cannot fail after the reserve */
+        strbuf_append_n(sb, data, len);
+        free(rope->chunks[i].data);
+        rope->chunks[i].data = NULL;
+    }
+
+    rope->nchunks = 0;
+    rope->size = 0;
+    return OK;
+}
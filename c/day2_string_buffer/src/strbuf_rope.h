@@ -0,0 +1,65 @@
+#ifndef STRBUF_ROPE_H
+#define STRBUF_ROPE_H
+
+#include <stdarg.h>
+#include <stddef.h>
+
+#include "strbuf.h"
+
+/* Chunked builder for very large outputs. Appends fill chunks of
+ * chunk_size bytes, so written bytes never move and growing costs one
+ * malloc per chunk instead of a realloc copying everything written so far.
+ * Peak memory stays near the output size: formatted output that does not
+ * fit the rest of the last chunk starts a new one (larger than chunk_size
+ * if it has to be), leaving that rest unused.
+ * Finish by writing the chunks with strbuf_rope_writev_fd (strbuf_io.h) or
+ * by copying them once into a strbuf_t with strbuf_rope_flatten.
+ */
+typedef struct {
+    char*  data;     // not NUL-terminated
+    size_t size;     // bytes written
+    size_t capacity; // chunk_size, or more for one long appendf
+} strbuf_rope_chunk_t;
+
+typedef struct {
+    strbuf_rope_chunk_t* chunks;
+    size_t               nchunks;
+    size_t               chunks_cap; // slots in chunks
+    size_t               chunk_size;
+    size_t               size;       // total bytes appended
+} strbuf_rope_t;
+
+/* Initialize empty with chunks of chunk_size bytes (0 picks 1 MiB).
+ * Nothing is allocated until the first append.
+ * Returns 0 on success, -1 on invalid args.
+ */
+int strbuf_rope_init(strbuf_rope_t* rope, size_t chunk_size);
+
+/* Free all chunks; safe to call multiple times. */
+void strbuf_rope_free(strbuf_rope_t* rope);
+
+/* Append n bytes from s, spilling into new chunks as needed.
+ * Returns 0 on success, -1 on allocation failure or invalid args (bytes
+ * that did fit before the failure stay appended).
+ */
+int strbuf_rope_append(strbuf_rope_t* rope, const char* s, size_t n);
+
+/* printf-style append, formatted straight into chunk memory: into the
+ * current chunk if it fits, else into a new chunk of at least its length.
+ * Returns 0 on success, -1 on formatting/allocation failure or invalid args.
+ */
+int strbuf_rope_appendf(strbuf_rope_t* rope, const char* fmt, ...) STRBUF_PRINTF(2, 3);
+int strbuf_rope_vappendf(strbuf_rope_t* rope, const char* fmt, va_list ap) STRBUF_PRINTF(2, 0);
+
+/* Length and address of chunk i (i < nchunks). */
+size_t strbuf_rope_chunk(const strbuf_rope_t* rope, size_t i, const char** data);
+
+/* Append the whole content to sb and empty the rope. sb grows once to the
+ * final size and each chunk is freed right after it is copied, so pages of
+ * the target are only touched as the source pages are released.
+ * Returns 0 on success, -1 on allocation failure or invalid args (the rope
+ * is then unchanged).
+ */
+int strbuf_rope_flatten(strbuf_rope_t* rope, strbuf_t* sb);
+
+#endif
@@ -0,0 +1,372 @@
+#include "strbuf.h"
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+
+/* Candidate verification budget of the SIMD filter: once the bytes spent in
+ * memcmp exceed VERIFY_FACTOR * scanned + VERIFY_SLACK the search switches
+ * to Two-Way, which keeps the worst case linear. */
+#define VERIFY_FACTOR (4)
+#define VERIFY_SLACK  (1024)
+
+#define BITOP(a, b, op) \
+    ((a)[(size_t)(b) / (8 * sizeof *(a))] op (size_t)1 << ((size_t)(b) % (8 * sizeof *(a))))
+
+/* Byte i of a string read forwards or, if rev, from the end backwards. */
+#define AT(s, len, i, rev) ((rev) ? (s)[(len) - 1 - (i)] : (s)[(i)])
+
+/*
+ * Crochemore-Perrin Two-Way string matching (structure follows musl's
+ * memmem). With rev != 0 both haystack and needle are read back to front,
+ * which finds the last occurrence. Returns the match offset in that reading
+ * direction, or STRBUF_NPOS.
+ */
+static size_t twoway(const unsigned char* h, size_t hl, const unsigned char* n, size_t l, int rev)
+{
+    size_t i, ip, jp, k, p, ms, p0, mem, mem0;
+    size_t byteset[32 / sizeof(size_t)] = {0};
+    size_t shift[256];
+    size_t pos = 0;
+
+    for (i = 0; i < l; i++) {
+        BITOP(byteset, AT(n, l, i, rev), |=);
+        shift[AT(n, l, i, rev)] = i + 1;
+    }
+
+    /* maximal suffix */
+    ip = (size_t)-1;
+    jp = 0;
+    k = p = 1;
+    while (jp + k < l) {
+        unsigned char a = AT(n, l, ip + k, rev);
+        unsigned char b = AT(n, l, jp + k, rev);
+        if (a == b) {
+            if (k == p) {
+                jp += p;
+                k = 1;
+            } else {
+                k++;
+            }
+        } else if (a > b) {
+            jp += k;
+            k = 1;
+            p = jp - ip;
+        } else {
+            ip = jp++;
+            k = p = 1;
+        }
+    }
+    ms = ip;
+    p0 = p;
+
+    /* and with the opposite comparison */
+    ip = (size_t)-1;
+    jp = 0;
+    k = p = 1;
+    while (jp + k < l) {
+        unsigned char a = AT(n, l, ip + k, rev);
+        unsigned char b = AT(n, l, jp + k, rev);
+        if (a == b) {
+            if (k == p) {
+                jp += p;
+                k = 1;
+            } else {
+                k++;
+            }
+        } else if (a < b) {
+            jp += k;
+            k = 1;
+            p = jp - ip;
+        } else {
+            ip = jp++;
+            k = p = 1;
+        }
+    }
+    if (ip + 1 > ms + 1) {
+        ms = ip;
+    } else {
+        p = p0;
+    }
+
+    /* periodic needle? */
+    int periodic = 1;
+    for (i = 0; i < ms + 1; i++) {
+        if (AT(n, l, i, rev) != AT(n, l, i + p, rev)) {
+            periodic = 0;
+            break;
+        }
+    }
+    if (!periodic) {
+        mem0 = 0;
+        p = MAX(ms, l - ms - 1) + 1;
+    } else {
+        mem0 = l - p;
+    }
+    mem = 0;
+
+    for (;;) {
+        if (hl - pos < l) {
+            return STRBUF_NPOS;
+        }
+
+        /* check last byte first; advance by shift on mismatch */
+        unsigned char last = AT(h, hl, pos + l - 1, rev);
+        if (BITOP(byteset, last, &)) {
+            k = l - shift[last];
+            if (k) {
+                if (k < mem) {
+                    k = mem;
+                }
+                pos += k;
+                mem = 0;
+                continue;
+            }
+        } else {
+            pos += l;
+            mem = 0;
+            continue;
+        }
+
+        /* compare right half */
+        for (k = MAX(ms + 1, mem); k < l && AT(n, l, k, rev) == AT(h, hl, pos + k, rev); k++);
+        if (k < l) {
+            pos += k - ms;
+            mem = 0;
+            continue;
+        }
+
+        /* compare left half */
+        for (k = ms + 1; k > mem && AT(n, l, k - 1, rev) == AT(h, hl, pos + k - 1, rev); k--);
+        if (k <= mem) {
+            return pos;
+        }
+        pos += p;
+        mem = mem0;
+    }
+}
+
+static size_t find_forward(const unsigned char* h, size_t hl, const unsigned char* n, size_t l)
+{
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    /* Compare the first and last needle byte against 16 candidate start
+     * positions at once; only positions where both match are verified. */
+    const __m128i first = _mm_set1_epi8((char)n[0]);
+    const __m128i last = _mm_set1_epi8((char)n[l - 1]);
+    size_t work = 0;
+
+    for (; i + l - 1 + 16 <= hl; i += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i*)&h[i]);
+        __m128i b = _mm_loadu_si128((const __m128i*)&h[i + l - 1]);
+        unsigned mask = (unsigned)_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last)));
+
+        while (mask) {
+            size_t cand = i + (size_t)__builtin_ctz(mask);
+            if (l <= 2 || memcmp(&h[cand + 1], &n[1], l - 2) == 0) {
+                return cand;
+            }
+            work += l;
+            mask &= mask - 1;
+        }
+
+        if (work > VERIFY_FACTOR * i + VERIFY_SLACK) {
+            break;
+        }
+    }
+#endif
+
+    size_t pos = twoway(&h[i], hl - i, n, l, 0);
+    return pos == STRBUF_NPOS ? STRBUF_NPOS : i + pos;
+}
+
+static size_t find_backward(const unsigned char* h, size_t hl, const unsigned char* n, size_t l)
+{
+    /* candidate starts still to search are [0, end) */
+    size_t end = hl - l + 1;
+
+#if defined(__SSE2__)
+    const __m128i first = _mm_set1_epi8((char)n[0]);
+    const __m128i last = _mm_set1_epi8((char)n[l - 1]);
+    size_t work = 0;
+
+    while (end >= 16) {
+        size_t j = end - 16;
+        __m128i a = _mm_loadu_si128((const __m128i*)&h[j]);
+        __m128i b = _mm_loadu_si128((const __m128i*)&h[j + l - 1]);
+        unsigned mask = (unsigned)_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last)));
+
+        while (mask) {
+            unsigned bit = 31 - (unsigned)__builtin_clz(mask);
+            size_t cand = j + bit;
+            if (l <= 2 || memcmp(&h[cand + 1], &n[1], l - 2) == 0) {
+                return cand;
+            }
+            work += l;
+            mask &= ~(1u << bit);
+        }
+        end = j;
+
+        if (work > VERIFY_FACTOR * (hl - end) + VERIFY_SLACK) {
+            break;
+        }
+    }
+#endif
+
+    /* reversed Two-Way over the prefix that can still hold a match */
+    size_t span = end + l - 1;
+    size_t pos = twoway(h, span, n, l, 1);
+    return pos == STRBUF_NPOS ? STRBUF_NPOS : span - pos - l;
+}
+
+size_t strbuf_find_byte(const strbuf_t* sb, size_t start, char c)
+{
+    if (sb == NULL || sb->data == NULL || start >= sb->size) {
+        return STRBUF_NPOS;
+    }
+
+    /* libc memchr is already vectorized */
+    const char* hit = memchr(&sb->data[start], c, sb->size - start);
+    return hit ? (size_t)(hit - sb->data) : STRBUF_NPOS;
+}
+
+size_t strbuf_find(const strbuf_t* sb, size_t start, const char* needle, size_t needle_len)
+{
+    if (sb == NULL || (needle == NULL && needle_len > 0) || start > sb->size) {
+        return STRBUF_NPOS;
+    }
+
+    size_t hl = sb->size - start;
+
+    if (needle_len == 0) {
+        return start;
+    }
+    if (needle_len > hl) {
+        return STRBUF_NPOS;
+    }
+    if (needle_len == 1) {
+        return strbuf_find_byte(sb, start, needle[0]);
+    }
+
+    size_t pos = find_forward((const unsigned char*)&sb->data[start], hl,
+                              (const unsigned char*)needle, needle_len);
+    return pos == STRBUF_NPOS ? STRBUF_NPOS : start + pos;
+}
+
+size_t strbuf_rfind(const strbuf_t* sb, const char* needle, size_t needle_len)
+{
+    if (sb == NULL || (needle == NULL && needle_len > 0)) {
+        return STRBUF_NPOS;
+    }
+
+    if (needle_len == 0) {
+        return sb->size;
+    }
+    if (needle_len > sb->size) {
+        return STRBUF_NPOS;
+    }
+
+    return find_backward((const unsigned char*)sb->data, sb->size,
+                         (const unsigned char*)needle, needle_len);
+}
+
+/* Bitmap of the delimiters in data[start..start + len), len <= 64. */
+static uint64_t delim_mask(const strbuf_split_t* it, size_t start, size_t len)
+{
+    const unsigned char* p = (const unsigned char*)&it->data[start];
+    uint64_t mask = 0;
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    if (it->ndelims > 0) {
+        for (; i + 16 <= len; i += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i*)&p[i]);
+            __m128i hit = _mm_cmpeq_epi8(v, _mm_set1_epi8((char)it->delims[0]));
+            for (unsigned d = 1; d < it->ndelims; d++) {
+                hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, _mm_set1_epi8((char)it->delims[d])));
+            }
+            mask |= (uint64_t)(unsigned)_mm_movemask_epi8(hit) << i;
+        }
+    }
+#endif
+
+    for (; i < len; i++) {
+        mask |= (uint64_t)((it->table[p[i] >> 6] >> (p[i] & 63)) & 1) << i;
+    }
+    return mask;
+}
+
+int strbuf_split_init_any(strbuf_split_t* it, const strbuf_t* sb, const char* delims, size_t n)
+{
+    if (it == NULL || sb == NULL || (delims == NULL && n > 0)) {
+        return -1;
+    }
+
+    memset(it, 0, sizeof(*it));
+    it->data = sb->data;
+    it->size = sb->data ? sb->size : 0;
+
+    for (size_t i = 0; i < n; i++) {
+        unsigned char c = (unsigned char)delims[i];
+        it->table[c >> 6] |= (uint64_t)1 << (c & 63);
+    }
+
+    /* small sets are also kept as a list for the SIMD compare */
+    unsigned count = 0;
+    for (unsigned c = 0; c < 256; c++) {
+        if ((it->table[c >> 6] >> (c & 63)) & 1) {
+            if (count < sizeof(it->delims)) {
+                it->delims[count] = (unsigned char)c;
+            }
+            count++;
+        }
+    }
+    it->ndelims = count <= sizeof(it->delims) ? count : 0;
+
+    return 0;
+}
+
+int strbuf_split_init(strbuf_split_t* it, const strbuf_t* sb, char delim)
+{
+    return strbuf_split_init_any(it, sb, &delim, 1);
+}
+
+int strbuf_split_next(strbuf_split_t* it, strbuf_view_t* field)
+{
+    if (it == NULL || field == NULL) {
+        return -1;
+    }
+
+    while (it->bits == 0) {
+        if (it->scan >= it->size) {
+            if (it->done) {
+                return 0;
+            }
+            /* the field after the last delimiter */
+            field->data = it->data ? &it->data[it->pos] : "";
+            field->size = it->size - it->pos;
+            it->pos = it->size;
+            it->done = 1;
+            return 1;
+        }
+        size_t len = it->size - it->scan < 64 ? it->size - it->scan : 64;
+        it->bits = delim_mask(it, it->scan, len);
+        it->base = it->scan;
+        it->scan += len;
+    }
+
+    size_t end = it->base + (size_t)__builtin_ctzll(it->bits);
+    it->bits &= it->bits - 1;
+
+    field->data = &it->data[it->pos];
+    field->size = end - it->pos;
+    it->pos = end + 1;
+    return 1;
+}
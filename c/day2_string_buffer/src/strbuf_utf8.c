@@ -0,0 +1,338 @@
+#include "strbuf.h"
+#include "strbuf_priv.h"
+#include <string.h>
+
+#define OK  (0)
+#define ERR (-1)
+
+#define ASCII_MASK (0x8080808080808080ULL)
+
+/* Sequence length of lead byte c and the allowed range of the byte after
+ * it (narrower than 80..BF where overlongs, surrogates or code points past
+ * U+10FFFF must be excluded). Returns 0 if c cannot start a sequence. */
+static size_t lead_rule(unsigned char c, unsigned char* lo, unsigned char* hi)
+{
+    *lo = 0x80;
+    *hi = 0xBF;
+
+    if (c < 0x80) {
+        return 1;
+    }
+    if (c >= 0xC2 && c <= 0xDF) {
+        return 2;
+    }
+    if (c >= 0xE0 && c <= 0xEF) {
+        if (c == 0xE0) {
+            *lo = 0xA0;
+        } else if (c == 0xED) {
+            *hi = 0x9F;
+        }
+        return 3;
+    }
+    if (c >= 0xF0 && c <= 0xF4) {
+        if (c == 0xF0) {
+            *lo = 0x90;
+        } else if (c == 0xF4) {
+            *hi = 0x8F;
+        }
+        return 4;
+    }
+    return 0;
+}
+
+/* Check p[0..n) against the sequence rules; if partial, the last sequence
+ * may be cut short. Returns 1 if valid, else 0. */
+static int validate_scalar(const unsigned char* p, size_t n, int partial)
+{
+    size_t i = 0;
+
+    while (i < n) {
+        if (i + 8 <= n) {
+            uint64_t word;
+            memcpy(&word, &p[i], sizeof(word));
+            if ((word & ASCII_MASK) == 0) {
+                i += 8;
+                continue;
+            }
+        }
+
+        unsigned char lo, hi;
+        size_t len = lead_rule(p[i], &lo, &hi);
+
+        if (len == 0) {
+            return 0;
+        }
+        if (len > n - i && !partial) {
+            return 0;
+        }
+        if (len > 1 && i + 1 < n && (p[i + 1] < lo || p[i + 1] > hi)) {
+            return 0;
+        }
+        for (size_t k = 2; k < len && i + k < n; k++) {
+            if ((p[i + k] & 0xC0) != 0x80) {
+                return 0;
+            }
+        }
+        i += len;
+    }
+    return 1;
+}
+
+/* Number of trailing bytes of p[0..n) that belong to a sequence whose lead
+ * byte promises more bytes than are present, or 0. */
+static size_t incomplete_tail(const unsigned char* p, size_t n)
+{
+    for (size_t k = 1; k <= 3 && k <= n; k++) {
+        unsigned char c = p[n - k];
+        if ((c & 0xC0) == 0x80) {
+            continue;
+        }
+        unsigned char lo, hi;
+        size_t len = lead_rule(c, &lo, &hi);
+        return len > k ? k : 0;
+    }
+    return 0;
+}
+
+#ifdef STRBUF_X86
+/*
+ * Lookup-table validation after Keiser & Lemire, "Validating UTF-8 In Less
+ * Than One Instruction Per Byte" (the simdjson algorithm). Three 16-entry
+ * tables indexed by the high nibble of the previous byte, its low nibble and
+ * the high nibble of the current byte each give the set of errors that
+ * nibble is compatible with; a byte pair is invalid where all three agree.
+ * Third and fourth bytes of longer sequences are checked separately.
+ */
+#define TOO_SHORT      (1 << 0)
+#define TOO_LONG       (1 << 1)
+#define OVERLONG_3     (1 << 2)
+#define TOO_LARGE      (1 << 3)
+#define SURROGATE      (1 << 4)
+#define OVERLONG_2     (1 << 5)
+#define TOO_LARGE_1000 (1 << 6)
+#define OVERLONG_4     (1 << 6)
+#define TWO_CONTS      (-128) // bit 7, as the signed char the tables hold
+#define CARRY          (TOO_SHORT | TOO_LONG | TWO_CONTS)
+
+#define TABLE16(...) _mm256_setr_epi8(__VA_ARGS__, __VA_ARGS__)
+
+__attribute__((target("avx2")))
+static inline __m256i prev_bytes(__m256i cur, __m256i prev, int n)
+{
+    /* cur shifted up by n bytes, filled from the end of prev */
+    __m256i joined = _mm256_permute2x128_si256(prev, cur, 0x21);
+    switch (n) {
+    case 1:
+        return _mm256_alignr_epi8(cur, joined, 15);
+    case 2:
+        return _mm256_alignr_epi8(cur, joined, 14);
+    default:
+        return _mm256_alignr_epi8(cur, joined, 13);
+    }
+}
+
+__attribute__((target("avx2")))
+static inline __m256i high_nibbles(__m256i v)
+{
+    return _mm256_and_si256(_mm256_srli_epi16(v, 4), _mm256_set1_epi8(0x0F));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i block_errors(__m256i cur, __m256i prev)
+{
+    const __m256i byte_1_high = TABLE16(
+        TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+        TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+        TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+        TOO_SHORT | OVERLONG_2,
+        TOO_SHORT,
+        TOO_SHORT | OVERLONG_3 | SURROGATE,
+        TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4);
+    const __m256i byte_1_low = TABLE16(
+        CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4,
+        CARRY | OVERLONG_2,
+        CARRY,
+        CARRY,
+        CARRY | TOO_LARGE,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000);
+    const __m256i byte_2_high = TABLE16(
+        TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+        TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+        TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT);
+
+    __m256i prev1 = prev_bytes(cur, prev, 1);
+    __m256i special = _mm256_and_si256(
+        _mm256_and_si256(_mm256_shuffle_epi8(byte_1_high, high_nibbles(prev1)),
+                         _mm256_shuffle_epi8(byte_1_low, _mm256_and_si256(prev1, _mm256_set1_epi8(0x0F)))),
+        _mm256_shuffle_epi8(byte_2_high, high_nibbles(cur)));
+
+    /* bytes 2 and 3 after a 3- or 4-byte lead must be continuations;
+     * only 111xxxxx two back and 1111xxxx three back reach 0x80 here */
+    __m256i third = _mm256_subs_epu8(prev_bytes(cur, prev, 2), _mm256_set1_epi8((char)(0xE0 - 0x80)));
+    __m256i fourth = _mm256_subs_epu8(prev_bytes(cur, prev, 3), _mm256_set1_epi8((char)(0xF0 - 0x80)));
+    __m256i must23_80 = _mm256_and_si256(_mm256_or_si256(third, fourth), _mm256_set1_epi8((char)0x80));
+
+    return _mm256_xor_si256(must23_80, special);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i incomplete_at_end(__m256i cur)
+{
+    /* nonzero where a lead byte in the last three positions needs more */
+    const __m256i max_value = _mm256_setr_epi8(
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        (char)(0xF0 - 1), (char)(0xE0 - 1), (char)(0xC0 - 1));
+    return _mm256_subs_epu8(cur, max_value);
+}
+
+__attribute__((target("avx2")))
+static int validate_avx2(const unsigned char* p, size_t n)
+{
+    __m256i error = _mm256_setzero_si256();
+    __m256i prev = _mm256_setzero_si256();
+    __m256i prev_incomplete = _mm256_setzero_si256();
+    size_t i = 0;
+
+    for (; i + 32 <= n; i += 32) {
+        __m256i cur = _mm256_loadu_si256((const __m256i*)&p[i]);
+        if (_mm256_movemask_epi8(cur) == 0) {
+            /* ASCII block: only a sequence left open before it can fail */
+            error = _mm256_or_si256(error, prev_incomplete);
+        } else {
+            error = _mm256_or_si256(error, block_errors(cur, prev));
+            prev_incomplete = incomplete_at_end(cur);
+        }
+        prev = cur;
+    }
+
+    if (i < n) {
+        /* zero padding makes a cut-off sequence show up as TOO_SHORT */
+        unsigned char tail[32] = {0};
+        memcpy(tail, &p[i], n - i);
+        __m256i cur = _mm256_loadu_si256((const __m256i*)tail);
+        error = _mm256_or_si256(error, block_errors(cur, prev));
+        prev_incomplete = _mm256_setzero_si256();
+    }
+    error = _mm256_or_si256(error, prev_incomplete);
+
+    return _mm256_testz_si256(error, error);
+}
+
+__attribute__((target("avx2")))
+static size_t count_leads_avx2(const unsigned char* p, size_t n, size_t* done)
+{
+    size_t count = 0;
+    size_t i = 0;
+
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)&p[i]);
+        /* continuation bytes 0x80..0xBF are the signed values below -64 */
+        __m256i cont = _mm256_cmpgt_epi8(_mm256_set1_epi8(-64), v);
+        count += 32 - (size_t)__builtin_popcount((unsigned)_mm256_movemask_epi8(cont));
+    }
+    *done = i;
+    return count;
+}
+#endif
+
+static int validate(const unsigned char* p, size_t n)
+{
+#ifdef STRBUF_X86
+    if (strbuf_have_avx2()) {
+        return validate_avx2(p, n);
+    }
+#endif
+    return validate_scalar(p, n, 0);
+}
+
+/* Valid UTF-8 except that the last sequence may be incomplete. */
+static int validate_prefix(const unsigned char* p, size_t n)
+{
+    size_t tail = incomplete_tail(p, n);
+    return validate(p, n - tail) && validate_scalar(&p[n - tail], tail, 1);
+}
+
+int strbuf_validate_utf8(const strbuf_t* sb)
+{
+    if (sb == NULL) {
+        return ERR;
+    }
+
+    if (sb->data == NULL) {
+        return 1;
+    }
+    return validate((const unsigned char*)sb->data, sb->size);
+}
+
+size_t strbuf_utf8_length(const strbuf_t* sb)
+{
+    if (sb == NULL || sb->data == NULL) {
+        return 0;
+    }
+
+    const unsigned char* p = (const unsigned char*)sb->data;
+    size_t count = 0;
+    size_t i = 0;
+
+#ifdef STRBUF_X86
+    if (strbuf_have_avx2()) {
+        count = count_leads_avx2(p, sb->size, &i);
+    }
+#endif
+
+    for (; i < sb->size; i++) {
+        count += (p[i] & 0xC0) != 0x80;
+    }
+    return count;
+}
+
+int strbuf_append_utf8(strbuf_t* sb, const char* s, size_t n)
+{
+    if (sb == NULL || (s == NULL && n > 0)) {
+        return ERR;
+    }
+
+    if (n == 0) {
+        return OK;
+    }
+
+    const unsigned char* in = (const unsigned char*)s;
+    size_t done = 0;
+
+    if (sb->data) {
+        /* an incomplete sequence at the end is completed by the new bytes:
+         * check it joined with them before anything is appended */
+        const unsigned char* end = (const unsigned char*)&sb->data[sb->size];
+        size_t tail = incomplete_tail((const unsigned char*)sb->data, sb->size);
+        if (tail > 0) {
+            unsigned char joint[4], lo, hi;
+            size_t len = lead_rule(*(end - tail), &lo, &hi);
+            done = len - tail < n ? len - tail : n;
+            memcpy(joint, end - tail, tail);
+            memcpy(&joint[tail], in, done);
+            if (!validate_prefix(joint, tail + done)) {
+                return ERR;
+            }
+        }
+    }
+
+    if (!validate_prefix(&in[done], n - done)) {
+        return ERR;
+    }
+    return strbuf_append_n(sb, s, n);
+}
@@ -0,0 +1,243 @@
+#include <gtest/gtest.h>
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+extern "C" {
+#include "strbuf_aio.h"
+}
+
+struct TempFd {
+    int fd;
+    std::string path;
+
+    TempFd() {
+        char name[] = "/tmp/strbuf_aio_XXXXXX";
+        fd = mkstemp(name);
+        EXPECT_GE(fd, 0);
+        path = name;
+    }
+    ~TempFd() {
+        close(fd);
+        unlink(path.c_str());
+    }
+    std::string content() const {
+        std::string out;
+        char buf[65536];
+        ssize_t n;
+        off_t off = 0;
+        while ((n = pread(fd, buf, sizeof(buf), off)) > 0) {
+            out.append(buf, (size_t)n);
+            off += n;
+        }
+        return out;
+    }
+};
+
+// A fixed pool of buffers that completions hand back for reuse.
+struct Pool {
+    std::vector<strbuf_t> bufs;
+    std::vector<strbuf_t*> free_list;
+    size_t completions = 0;
+    int last_err = 0;
+
+    explicit Pool(size_t n, size_t capacity) : bufs(n) {
+        for (auto& sb : bufs) {
+            strbuf_init(&sb, capacity);
+            free_list.push_back(&sb);
+        }
+    }
+    ~Pool() {
+        for (auto& sb : bufs) strbuf_free(&sb);
+    }
+    static void done(strbuf_t* sb, int err, void* ctx) {
+        Pool* pool = static_cast<Pool*>(ctx);
+        pool->completions++;
+        if (err) pool->last_err = err;
+        strbuf_clear(sb);
+        pool->free_list.push_back(sb);
+    }
+};
+
+// Producer loop: fill recycled buffers and queue them, polling without
+// waiting; only block when every buffer is in flight.
+static std::string produce(strbuf_aio_t* w, Pool* pool, int records) {
+    std::string expect;
+    for (int i = 0; i < records; ++i) {
+        while (pool->free_list.empty()) {
+            EXPECT_GE(strbuf_aio_poll(w, 1), 0);
+        }
+        strbuf_t* sb = pool->free_list.back();
+        pool->free_list.pop_back();
+        EXPECT_EQ(strbuf_appendf(sb, "record %06d %s\n", i, std::string(i % 300, 'x').c_str()), 0);
+        expect.append(sb->data, sb->size);
+
+        int rc;
+        while ((rc = strbuf_aio_write(w, sb)) == STRBUF_IO_PENDING) {
+            EXPECT_GE(strbuf_aio_poll(w, 1), 0);
+        }
+        EXPECT_EQ(rc, STRBUF_IO_DONE);
+        if (i % 8 == 7) {
+            EXPECT_GE(strbuf_aio_poll(w, 0), 0);  // submit the batch
+        }
+    }
+    EXPECT_EQ(strbuf_aio_flush(w), 0);
+    return expect;
+}
+
+static void run_writer(unsigned flags, bool registered) {
+    TempFd tf;
+    ASSERT_EQ(write(tf.fd, "HDR:", 4), 4);
+
+    Pool pool(16, 512);
+    strbuf_aio_t w;
+    ASSERT_EQ(strbuf_aio_init(&w, tf.fd, 4, 8, flags, Pool::done, &pool), 0);
+    if (flags & STRBUF_AIO_NO_URING) {
+        EXPECT_EQ(w.ring, nullptr);
+    }
+    if (registered) {
+        std::vector<strbuf_t*> ptrs;
+        for (auto& sb : pool.bufs) ptrs.push_back(&sb);
+        EXPECT_EQ(strbuf_aio_register(&w, ptrs.data(), (unsigned)ptrs.size()), 0);
+    }
+
+    std::string expect = produce(&w, &pool, 2000);
+    EXPECT_EQ(pool.completions, 2000u);
+    EXPECT_EQ(pool.last_err, 0);
+    EXPECT_EQ(pool.free_list.size(), pool.bufs.size());
+    EXPECT_EQ(w.offset, (off_t)(4 + expect.size()));
+    EXPECT_EQ(tf.content(), "HDR:" + expect);
+
+    strbuf_aio_free(&w);
+    strbuf_aio_free(&w);
+}
+
+TEST(StrBufAioTest, WritesInOrderOfOffsets) {
+    run_writer(0, false);
+}
+
+TEST(StrBufAioTest, RegisteredBuffers) {
+    run_writer(0, true);
+}
+
+TEST(StrBufAioTest, PwritevFallback) {
+    run_writer(STRBUF_AIO_NO_URING, false);
+}
+
+TEST(StrBufAioTest, GrownBufferIsStillWritten) {
+    TempFd tf;
+    Pool pool(1, 64);
+    strbuf_aio_t w;
+    ASSERT_EQ(strbuf_aio_init(&w, tf.fd, 0, 0, 0, Pool::done, &pool), 0);
+    EXPECT_EQ(w.depth, 64u);
+    strbuf_t* sb = &pool.bufs[0];
+    ASSERT_EQ(strbuf_aio_register(&w, &sb, 1), 0);
+
+    // outgrows (and moves away from) the registered storage
+    std::string big(100000, 'g');
+    ASSERT_EQ(strbuf_append_n(sb, big.data(), big.size()), 0);
+    ASSERT_EQ(strbuf_aio_write(&w, sb), STRBUF_IO_DONE);
+    strbuf_t empty;
+    ASSERT_EQ(strbuf_init(&empty, 0), 0);
+    ASSERT_EQ(strbuf_aio_write(&w, &empty), STRBUF_IO_DONE);
+    ASSERT_EQ(strbuf_aio_flush(&w), 0);
+
+    EXPECT_EQ(pool.completions, 2u);
+    EXPECT_EQ(pool.last_err, 0);
+    EXPECT_EQ(tf.content(), big);
+    strbuf_aio_free(&w);
+}
+
+TEST(StrBufAioTest, RegistrationIsTiedToItsBuffer) {
+    TempFd tf;
+    Pool pool(2, 4096);
+    strbuf_aio_t w;
+    ASSERT_EQ(strbuf_aio_init(&w, tf.fd, 0, 4, 0, Pool::done, &pool), 0);
+    strbuf_t* regs[] = {&pool.bufs[0], &pool.bufs[1]};
+    ASSERT_EQ(strbuf_aio_register(&w, regs, 2), 0);
+
+    // another strbuf_t now owns the registered storage of bufs[0]
+    strbuf_t moved;
+    strbuf_move(&moved, &pool.bufs[0]);
+    ASSERT_EQ(strbuf_append_cstr(&moved, "moved;"), 0);
+    ASSERT_EQ(strbuf_aio_write(&w, &moved), STRBUF_IO_DONE);
+    ASSERT_EQ(strbuf_aio_flush(&w), 0);
+
+    // same strbuf_t, but a different capacity than was registered
+    std::string grown(6000, 'r');
+    ASSERT_EQ(strbuf_append_n(&pool.bufs[1], grown.data(), grown.size()), 0);
+    ASSERT_EQ(strbuf_aio_write(&w, &pool.bufs[1]), STRBUF_IO_DONE);
+    ASSERT_EQ(strbuf_aio_flush(&w), 0);
+
+    EXPECT_EQ(pool.completions, 2u);
+    EXPECT_EQ(pool.last_err, 0);
+    EXPECT_EQ(tf.content(), "moved;" + grown);
+
+    strbuf_aio_free(&w);
+    strbuf_free(&moved);
+}
+
+TEST(StrBufAioTest, WriteErrorsReachTheCallback) {
+    for (unsigned flags : {0u, (unsigned)STRBUF_AIO_NO_URING}) {
+        TempFd tf;
+        int ro = open(tf.path.c_str(), O_RDONLY);
+        ASSERT_GE(ro, 0);
+        Pool pool(1, 64);
+        strbuf_aio_t w;
+        // writes to a read-only descriptor fail with EBADF
+        ASSERT_EQ(strbuf_aio_init(&w, ro, 0, 4, flags, Pool::done, &pool), 0);
+        ASSERT_EQ(strbuf_append_cstr(&pool.bufs[0], "data"), 0);
+        ASSERT_EQ(strbuf_aio_write(&w, &pool.bufs[0]), STRBUF_IO_DONE);
+        ASSERT_EQ(strbuf_aio_flush(&w), 0);
+        EXPECT_EQ(pool.completions, 1u);
+        EXPECT_EQ(pool.last_err, EBADF);
+        strbuf_aio_free(&w);
+        close(ro);
+    }
+}
+
+TEST(StrBufAioTest, FullWriterReportsPending) {
+    TempFd tf;
+    Pool pool(3, 64);
+    strbuf_aio_t w;
+    ASSERT_EQ(strbuf_aio_init(&w, tf.fd, 0, 2, STRBUF_AIO_NO_URING, Pool::done, &pool), 0);
+    for (auto& sb : pool.bufs) ASSERT_EQ(strbuf_append_cstr(&sb, "abc"), 0);
+
+    EXPECT_EQ(strbuf_aio_write(&w, &pool.bufs[0]), STRBUF_IO_DONE);
+    EXPECT_EQ(strbuf_aio_write(&w, &pool.bufs[1]), STRBUF_IO_DONE);
+    EXPECT_EQ(strbuf_aio_write(&w, &pool.bufs[2]), STRBUF_IO_PENDING);
+    EXPECT_EQ(strbuf_aio_poll(&w, 0), 2);
+    EXPECT_EQ(strbuf_aio_write(&w, &pool.bufs[2]), STRBUF_IO_DONE);
+    strbuf_aio_free(&w);  // waits for the last write
+    EXPECT_EQ(pool.completions, 3u);
+    EXPECT_EQ(tf.content(), "abcabcabc");
+}
+
+TEST(StrBufAioTest, InvalidArgs) {
+    strbuf_aio_t w;
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_init(&sb, 0), 0);
+    EXPECT_EQ(strbuf_aio_init(nullptr, 1, 0, 0, 0, nullptr, nullptr), -1);
+    EXPECT_EQ(strbuf_aio_init(&w, -1, 0, 0, 0, nullptr, nullptr), -1);
+    EXPECT_EQ(strbuf_aio_init(&w, 1, -5, 0, 0, nullptr, nullptr), -1);
+    EXPECT_EQ(strbuf_aio_init(&w, 1, 0, 0, 0x80, nullptr, nullptr), -1);
+    EXPECT_EQ(errno, EINVAL);
+
+    TempFd tf;
+    ASSERT_EQ(strbuf_aio_init(&w, tf.fd, 0, 4, 0, nullptr, nullptr), 0);
+    EXPECT_EQ(strbuf_aio_write(&w, nullptr), STRBUF_IO_ERR);
+    EXPECT_EQ(strbuf_aio_write(nullptr, &sb), STRBUF_IO_ERR);
+    EXPECT_EQ(strbuf_aio_poll(nullptr, 0), -1);
+    EXPECT_EQ(strbuf_aio_flush(nullptr), -1);
+    EXPECT_EQ(strbuf_aio_register(&w, nullptr, 1), -1);
+    if (w.ring) {
+        // lazy storage has no stable address to register
+        strbuf_t* lazy = &sb;
+        EXPECT_EQ(strbuf_aio_register(&w, &lazy, 1), -1);
+    }
+    strbuf_aio_free(&w);
+    strbuf_free(&sb);
+}
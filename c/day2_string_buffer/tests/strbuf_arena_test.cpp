@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include "strbuf_arena.h"
+}
+
+static bool in_arena(const strbuf_arena_t& a, const char* p) {
+    // inside the block allocations are currently carved from
+    return p >= a.end - a.block_size && p < a.end;
+}
+
+TEST(StrBufArenaTest, LastAllocationGrowsInPlace) {
+    strbuf_arena_t arena;
+    ASSERT_EQ(strbuf_arena_init(&arena, 4096), 0);
+
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_init_arena(&sb, &arena, 64), 0);
+    EXPECT_TRUE(sb.flags & STRBUF_F_ARENA);
+    EXPECT_EQ(sb.capacity, 64u);
+    ASSERT_NE(sb.data, nullptr);
+    EXPECT_TRUE(in_arena(arena, sb.data));
+    EXPECT_EQ(sb.data + sb.capacity, arena.cur);
+
+    const char* start = sb.data;
+    std::string expected;
+    for (int i = 0; i < 100; ++i) {
+        ASSERT_EQ(strbuf_append_cstr(&sb, "0123456789"), 0);
+        expected += "0123456789";
+    }
+    EXPECT_EQ(sb.data, start);
+    EXPECT_EQ(strbuf_c_str(&sb), expected);
+    EXPECT_EQ(sb.data + sb.capacity, arena.cur);
+
+    // freeing the last allocation hands its space back
+    strbuf_free(&sb);
+    EXPECT_EQ(arena.cur, start);
+
+    strbuf_arena_free(&arena);
+}
+
+TEST(StrBufArenaTest, InterleavedBuffersMoveAndStayCorrect) {
+    strbuf_arena_t arena;
+    ASSERT_EQ(strbuf_arena_init(&arena, 1024), 0);
+
+    strbuf_t a, b;
+    ASSERT_EQ(strbuf_init_arena(&a, &arena, 0), 0);
+    ASSERT_EQ(strbuf_init_arena(&b, &arena, 0), 0);
+
+    // even short content lives in the arena: inline_buf overlays the arena pointer
+    ASSERT_EQ(strbuf_append_cstr(&a, "a"), 0);
+    EXPECT_FALSE(a.flags & STRBUF_F_INLINE);
+    EXPECT_EQ(a.arena, &arena);
+
+    std::string ea = "a", eb;
+    for (int i = 0; i < 500; ++i) {
+        ASSERT_EQ(strbuf_appendf(&a, "[%d]", i), 0);
+        ASSERT_EQ(strbuf_append_int(&b, i), 0);
+        ea += "[" + std::to_string(i) + "]";
+        eb += std::to_string(i);
+    }
+    EXPECT_EQ(strbuf_c_str(&a), ea);
+    EXPECT_EQ(strbuf_c_str(&b), eb);
+    EXPECT_TRUE(a.flags & STRBUF_F_ARENA);
+    EXPECT_FALSE(a.flags & STRBUF_F_INLINE);
+    EXPECT_NE(arena.first, arena.current);
+
+    strbuf_free(&a);
+    strbuf_free(&b);
+    strbuf_arena_free(&arena);
+}
+
+TEST(StrBufArenaTest, OversizedRequestKeepsCurrentBlock) {
+    strbuf_arena_t arena;
+    ASSERT_EQ(strbuf_arena_init(&arena, 1024), 0);
+
+    strbuf_t small, big, next;
+    ASSERT_EQ(strbuf_init_arena(&small, &arena, 100), 0);
+    const strbuf_arena_block_t* current = arena.current;
+    ASSERT_EQ(strbuf_init_arena(&big, &arena, 5000), 0);
+    EXPECT_EQ(arena.current, current);
+    EXPECT_FALSE(in_arena(arena, big.data));
+
+    // later small requests still fill the rest of the current block
+    ASSERT_EQ(strbuf_init_arena(&next, &arena, 100), 0);
+    EXPECT_EQ(next.data, small.data + 100);
+    ASSERT_EQ(strbuf_append_n(&big, std::string(4999, 'b').data(), 4999), 0);
+    ASSERT_EQ(strbuf_append_cstr(&next, "after"), 0);
+    EXPECT_EQ(std::string(big.data, big.size), std::string(4999, 'b'));
+    EXPECT_STREQ(strbuf_c_str(&next), "after");
+
+    // after a reset the oversized block is reused like any other
+    strbuf_arena_reset(&arena);
+    std::vector<strbuf_t> bufs(80);
+    for (auto& sb : bufs) {
+        ASSERT_EQ(strbuf_init_arena(&sb, &arena, 64), 0);
+        ASSERT_EQ(strbuf_append_cstr(&sb, "reused"), 0);
+    }
+    for (auto& sb : bufs) {
+        EXPECT_STREQ(strbuf_c_str(&sb), "reused");
+    }
+
+    strbuf_arena_free(&arena);
+}
+
+TEST(StrBufArenaTest, ResetReusesBlocks) {
+    strbuf_arena_t arena;
+    ASSERT_EQ(strbuf_arena_init(&arena, 256), 0);
+
+    std::vector<strbuf_t> bufs(50);
+    for (int round = 0; round < 3; ++round) {
+        for (auto& sb : bufs) {
+            ASSERT_EQ(strbuf_init_arena(&sb, &arena, 100), 0);
+            ASSERT_EQ(strbuf_appendf(&sb, "round %d", round), 0);
+        }
+        for (auto& sb : bufs) {
+            EXPECT_EQ(strbuf_c_str(&sb), "round " + std::to_string(round));
+        }
+        const strbuf_arena_t before = arena;
+        strbuf_arena_reset(&arena);
+        EXPECT_EQ(arena.current, arena.first);
+        EXPECT_EQ(arena.first, before.first);
+    }
+
+    // a request larger than the block size gets its own block
+    strbuf_t big;
+    ASSERT_EQ(strbuf_init_arena(&big, &arena, 10000), 0);
+    EXPECT_EQ(big.capacity, 10000u);
+    ASSERT_EQ(strbuf_append_n(&big, std::string(9999, 'x').data(), 9999), 0);
+    EXPECT_EQ(big.size, 9999u);
+
+    strbuf_arena_free(&arena);
+    strbuf_arena_free(&arena);
+}
+
+TEST(StrBufArenaTest, InvalidArgs) {
+    strbuf_arena_t arena;
+    strbuf_t sb;
+    EXPECT_EQ(strbuf_arena_init(nullptr, 0), -1);
+    ASSERT_EQ(strbuf_arena_init(&arena, 0), 0);
+    EXPECT_EQ(strbuf_init_arena(nullptr, &arena, 0), -1);
+    EXPECT_EQ(strbuf_init_arena(&sb, nullptr, 0), -1);
+    strbuf_arena_reset(&arena);
+    strbuf_arena_free(&arena);
+}
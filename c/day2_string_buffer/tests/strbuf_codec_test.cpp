@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+
+extern "C" {
+#include "strbuf.h"
+}
+
+static std::string ref_base64(const std::string& in) {
+    static const char* tbl = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    size_t i = 0;
+    for (; i + 3 <= in.size(); i += 3) {
+        uint32_t w = (uint8_t)in[i] << 16 | (uint8_t)in[i + 1] << 8 | (uint8_t)in[i + 2];
+        for (int s = 18; s >= 0; s -= 6) out += tbl[(w >> s) & 63];
+    }
+    if (i + 1 == in.size()) {
+        uint32_t w = (uint8_t)in[i] << 16;
+        out += tbl[w >> 18];
+        out += tbl[(w >> 12) & 63];
+        out += "==";
+    } else if (i + 2 == in.size()) {
+        uint32_t w = (uint8_t)in[i] << 16 | (uint8_t)in[i + 1] << 8;
+        out += tbl[w >> 18];
+        out += tbl[(w >> 12) & 63];
+        out += tbl[(w >> 6) & 63];
+        out += '=';
+    }
+    return out;
+}
+
+static std::string encode(int (*fn)(strbuf_t*, const void*, size_t), const std::string& in) {
+    strbuf_t sb;
+    strbuf_init(&sb, 0);
+    EXPECT_EQ(fn(&sb, in.data(), in.size()), 0);
+    std::string out(strbuf_c_str(&sb), sb.size);
+    strbuf_free(&sb);
+    return out;
+}
+
+// Decode into a buffer that already holds "x"; returns the decoded part.
+static bool decode(int (*fn)(strbuf_t*, const char*, size_t), const std::string& in, std::string* out) {
+    strbuf_t sb;
+    strbuf_init(&sb, 0);
+    strbuf_append_cstr(&sb, "x");
+    int rc = fn(&sb, in.data(), in.size());
+    EXPECT_EQ(sb.data[sb.size], '\0');
+    if (rc != 0) {
+        EXPECT_EQ(sb.size, 1u);  // unchanged on failure
+    }
+    *out = std::string(sb.data + 1, sb.size - 1);
+    strbuf_free(&sb);
+    return rc == 0;
+}
+
+static std::string random_bytes(std::mt19937& rng, size_t n) {
+    std::string s(n, '\0');
+    for (auto& c : s) c = (char)(rng() & 0xFF);
+    return s;
+}
+
+TEST(StrBufCodecTest, Base64KnownVectors) {
+    // RFC 4648 section 10
+    const char* plain[] = {"", "f", "fo", "foo", "foob", "fooba", "foobar"};
+    const char* coded[] = {"", "Zg==", "Zm8=", "Zm9v", "Zm9vYg==", "Zm9vYmE=", "Zm9vYmFy"};
+    for (int i = 0; i < 7; ++i) {
+        EXPECT_EQ(encode(strbuf_append_base64, plain[i]), coded[i]);
+        std::string out;
+        ASSERT_TRUE(decode(strbuf_decode_base64, coded[i], &out));
+        EXPECT_EQ(out, plain[i]);
+    }
+}
+
+TEST(StrBufCodecTest, Base64RoundTripsAllLengths) {
+    std::mt19937 rng(21);
+    for (size_t n = 0; n < 300; ++n) {
+        std::string in = random_bytes(rng, n);
+        std::string enc = encode(strbuf_append_base64, in);
+        ASSERT_EQ(enc, ref_base64(in)) << n;
+        std::string out;
+        ASSERT_TRUE(decode(strbuf_decode_base64, enc, &out)) << n;
+        ASSERT_EQ(out, in) << n;
+    }
+}
+
+TEST(StrBufCodecTest, Base64RejectsMalformedInput) {
+    std::string out;
+    EXPECT_FALSE(decode(strbuf_decode_base64, "Zm9", &out));      // length
+    EXPECT_FALSE(decode(strbuf_decode_base64, "Zm9v!A==", &out)); // alphabet
+    EXPECT_FALSE(decode(strbuf_decode_base64, "Zg=v", &out));     // '=' inside
+    EXPECT_FALSE(decode(strbuf_decode_base64, "====", &out));
+    EXPECT_FALSE(decode(strbuf_decode_base64, "Zm 9v", &out));
+
+    // a bad character anywhere in a long input, vector part included
+    std::mt19937 rng(4);
+    std::string good = ref_base64(random_bytes(rng, 300));
+    for (size_t pos = 0; pos < good.size() - 4; pos += 7) {
+        std::string bad = good;
+        bad[pos] = (pos % 2) ? '-' : '\x80';
+        EXPECT_FALSE(decode(strbuf_decode_base64, bad, &out)) << pos;
+    }
+}
+
+TEST(StrBufCodecTest, HexRoundTripAndValidation) {
+    EXPECT_EQ(encode(strbuf_append_hex_bytes, std::string("\x00\x01\xab\xff", 4)), "0001abff");
+
+    std::mt19937 rng(8);
+    for (size_t n = 0; n < 200; ++n) {
+        std::string in = random_bytes(rng, n);
+        std::string enc = encode(strbuf_append_hex_bytes, in);
+        ASSERT_EQ(enc.size(), 2 * n);
+        std::string out;
+        ASSERT_TRUE(decode(strbuf_decode_hex, enc, &out));
+        ASSERT_EQ(out, in);
+
+        // uppercase decodes to the same bytes
+        for (auto& c : enc) c = (char)toupper((unsigned char)c);
+        ASSERT_TRUE(decode(strbuf_decode_hex, enc, &out));
+        ASSERT_EQ(out, in);
+
+        if (n > 0) {
+            std::string bad = enc;
+            bad[rng() % bad.size()] = "gG/:@`"[rng() % 6];
+            EXPECT_FALSE(decode(strbuf_decode_hex, bad, &out));
+        }
+    }
+
+    std::string out;
+    EXPECT_FALSE(decode(strbuf_decode_hex, "abc", &out));
+}
+
+TEST(StrBufCodecTest, InvalidArgs) {
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_init(&sb, 0), 0);
+    EXPECT_EQ(strbuf_append_base64(nullptr, "a", 1), -1);
+    EXPECT_EQ(strbuf_append_base64(&sb, nullptr, 1), -1);
+    EXPECT_EQ(strbuf_decode_base64(&sb, nullptr, 4), -1);
+    EXPECT_EQ(strbuf_append_hex_bytes(&sb, nullptr, 1), -1);
+    EXPECT_EQ(strbuf_decode_hex(nullptr, "00", 2), -1);
+    strbuf_free(&sb);
+}
@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include "strbuf.h"
+}
+
+// bit-at-a-time reference
+static uint32_t ref_crc32c(const std::string& s) {
+    uint32_t crc = 0xFFFFFFFFu;
+    for (unsigned char c : s) {
+        crc ^= c;
+        for (int k = 0; k < 8; ++k) crc = (crc & 1) ? (crc >> 1) ^ 0x82F63B78u : crc >> 1;
+    }
+    return ~crc;
+}
+
+static std::string random_bytes(std::mt19937& rng, size_t n) {
+    std::string s(n, '\0');
+    for (auto& c : s) c = (char)(rng() & 0xFF);
+    return s;
+}
+
+TEST(StrBufCrcTest, KnownVectors) {
+    EXPECT_EQ(strbuf_crc32c_update(0, "123456789", 9), 0xE3069283u);
+    EXPECT_EQ(strbuf_crc32c_update(0, "", 0), 0u);
+    // RFC 3720 B.4
+    std::string zeros(32, '\0'), ones(32, '\xff');
+    EXPECT_EQ(strbuf_crc32c_update(0, zeros.data(), 32), 0x8A9136AAu);
+    EXPECT_EQ(strbuf_crc32c_update(0, ones.data(), 32), 0x62A8AB43u);
+}
+
+TEST(StrBufCrcTest, MatchesReferenceAcrossAllBlockSizes) {
+    std::mt19937 rng(49);
+    // every tail length, and inputs long enough for the 3-way rounds
+    std::vector<size_t> lengths;
+    for (size_t n = 0; n < 1024; ++n) lengths.push_back(n);
+    for (size_t n : {767u, 768u, 769u, 3 * 8192u - 1, 3 * 8192u, 3 * 8192u + 777, 100000u}) {
+        lengths.push_back(n);
+    }
+    for (size_t n : lengths) {
+        std::string s = random_bytes(rng, n);
+        ASSERT_EQ(strbuf_crc32c_update(0, s.data(), n), ref_crc32c(s)) << n;
+    }
+}
+
+TEST(StrBufCrcTest, IncrementalUpdatesCompose) {
+    std::mt19937 rng(7);
+    std::string s = random_bytes(rng, 70000);
+    uint32_t whole = strbuf_crc32c_update(0, s.data(), s.size());
+    for (size_t cut : {0u, 1u, 9u, 768u, 24576u, 50001u, 70000u}) {
+        uint32_t crc = strbuf_crc32c_update(0, s.data(), cut);
+        crc = strbuf_crc32c_update(crc, s.data() + cut, s.size() - cut);
+        EXPECT_EQ(crc, whole) << cut;
+    }
+}
+
+TEST(StrBufCrcTest, TrackedBufferFollowsAppends) {
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_init(&sb, 0), 0);
+    ASSERT_EQ(strbuf_append_cstr(&sb, "content already there before tracking;"), 0);
+    ASSERT_EQ(strbuf_crc32c_track(&sb), 0);
+
+    auto check = [&](const char* what) {
+        std::string content(sb.data ? sb.data : "", sb.size);
+        if (!(sb.flags & STRBUF_F_INLINE)) {
+            EXPECT_EQ(sb.crc_len, sb.size) << what;
+            EXPECT_EQ(sb.crc, ref_crc32c(content)) << what;
+        }
+        EXPECT_EQ(strbuf_crc32c(&sb), ref_crc32c(content)) << what;
+    };
+    check("track");
+    ASSERT_EQ(strbuf_append_n(&sb, "abc", 3), 0);
+    check("append_n");
+    ASSERT_EQ(strbuf_appendf(&sb, "%0200d", 5), 0);
+    check("appendf");
+    ASSERT_EQ(strbuf_append_uint64(&sb, 12345), 0);
+    check("append_uint64");
+    strbuf_view_t parts[] = {{"x", 1}, {"yz", 2}};
+    ASSERT_EQ(strbuf_join(&sb, parts, 2, "-"), 0);
+    check("join");
+    ASSERT_EQ(strbuf_append_hex_bytes(&sb, "\x01\x02", 2), 0);
+    check("hex");
+
+    // a rejected append leaves the content and its CRC untouched
+    EXPECT_EQ(strbuf_append_utf8(&sb, "ok\xff", 3), -1);
+    EXPECT_EQ(strbuf_crc32c(&sb), ref_crc32c(std::string(sb.data, sb.size)));
+    ASSERT_EQ(strbuf_append_cstr(&sb, "!"), 0);
+    check("after rollback");
+
+    strbuf_clear(&sb);
+    check("clear");
+    ASSERT_EQ(strbuf_append_cstr(&sb, "fresh"), 0);
+    check("after clear");
+
+    strbuf_t dst;
+    strbuf_move(&dst, &sb);
+    EXPECT_EQ(strbuf_crc32c(&dst), ref_crc32c("fresh"));
+    EXPECT_EQ(strbuf_crc32c(&sb), 0u);
+
+    strbuf_free(&dst);
+    strbuf_free(&sb);
+}
+
+TEST(StrBufCrcTest, TrackedInlineBufferSpillsToHeap) {
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_init(&sb, 0), 0);
+    ASSERT_EQ(strbuf_append_cstr(&sb, "short"), 0);
+    ASSERT_EQ(strbuf_crc32c_track(&sb), 0);
+    ASSERT_TRUE(sb.flags & STRBUF_F_INLINE);
+    EXPECT_EQ(strbuf_crc32c(&sb), ref_crc32c("short"));
+    ASSERT_EQ(strbuf_append_cstr(&sb, "+x"), 0);
+    EXPECT_EQ(strbuf_crc32c(&sb), ref_crc32c("short+x"));
+    EXPECT_STREQ(strbuf_c_str(&sb), "short+x");
+
+    // spilling picks up incremental tracking from the inline content
+    std::string expect = "short+x" + std::string(40, 'y');
+    ASSERT_EQ(strbuf_append_n(&sb, expect.data() + 7, 40), 0);
+    ASSERT_FALSE(sb.flags & STRBUF_F_INLINE);
+    EXPECT_EQ(sb.crc_len, sb.size);
+    EXPECT_EQ(sb.crc, ref_crc32c(expect));
+    EXPECT_EQ(strbuf_crc32c(&sb), ref_crc32c(expect));
+
+    strbuf_free(&sb);
+}
+
+TEST(StrBufCrcTest, UntrackedBufferAndInvalidArgs) {
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_init(&sb, 0), 0);
+    EXPECT_EQ(strbuf_crc32c(&sb), 0u);
+    ASSERT_EQ(strbuf_append_cstr(&sb, "123456789"), 0);
+    EXPECT_EQ(strbuf_crc32c(&sb), 0xE3069283u);
+    EXPECT_FALSE(sb.flags & STRBUF_F_CRC);
+
+    EXPECT_EQ(strbuf_crc32c(nullptr), 0u);
+    EXPECT_EQ(strbuf_crc32c_track(nullptr), -1);
+    EXPECT_EQ(strbuf_crc32c_update(0x1234, nullptr, 5), 0x1234u);
+    strbuf_free(&sb);
+}
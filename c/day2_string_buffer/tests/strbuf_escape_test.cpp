@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+
+extern "C" {
+#include "strbuf.h"
+}
+
+static std::string ref_json(const std::string& s) {
+    std::string out;
+    char tmp[8];
+    for (unsigned char c : s) {
+        switch (c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\b': out += "\\b"; break;
+        case '\f': out += "\\f"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (c < 0x20) {
+                snprintf(tmp, sizeof(tmp), "\\u%04x", c);
+                out += tmp;
+            } else {
+                out += (char)c;
+            }
+        }
+    }
+    return out;
+}
+
+static std::string ref_csv(const std::string& s, char delim) {
+    if (s.find_first_of(std::string(1, delim) + "\"\n\r") == std::string::npos) return s;
+    std::string out = "\"";
+    for (char c : s) {
+        if (c == '"') out += '"';
+        out += c;
+    }
+    return out + "\"";
+}
+
+static std::string json(const std::string& s) {
+    strbuf_t sb;
+    strbuf_init(&sb, 0);
+    EXPECT_EQ(strbuf_append_cstr(&sb, "<"), 0);
+    EXPECT_EQ(strbuf_append_json_escaped(&sb, s.data(), s.size()), 0);
+    std::string out(sb.data + 1, sb.size - 1);
+    EXPECT_EQ(sb.data[sb.size], '\0');
+    strbuf_free(&sb);
+    return out;
+}
+
+static std::string csv(const std::string& s, char delim) {
+    strbuf_t sb;
+    strbuf_init(&sb, 0);
+    EXPECT_EQ(strbuf_append_cstr(&sb, "<"), 0);
+    EXPECT_EQ(strbuf_append_csv_escaped(&sb, s.data(), s.size(), delim), 0);
+    std::string out(sb.data + 1, sb.size - 1);
+    strbuf_free(&sb);
+    return out;
+}
+
+TEST(StrBufEscapeTest, JsonEscapes) {
+    EXPECT_EQ(json(""), "");
+    EXPECT_EQ(json("plain text"), "plain text");
+    EXPECT_EQ(json("say \"hi\"\n"), "say \\\"hi\\\"\\n");
+    EXPECT_EQ(json("C:\\dir\ttab"), "C:\\\\dir\\ttab");
+    EXPECT_EQ(json(std::string("\0\x01\x1f\x7f", 4)), "\\u0000\\u0001\\u001f\x7f");
+    EXPECT_EQ(json("caf\xC3\xA9"), "caf\xC3\xA9");
+}
+
+TEST(StrBufEscapeTest, CsvQuotesOnlyWhenNeeded) {
+    EXPECT_EQ(csv("", ','), "");
+    EXPECT_EQ(csv("simple", ','), "simple");
+    EXPECT_EQ(csv("a,b", ','), "\"a,b\"");
+    EXPECT_EQ(csv("a,b", '\t'), "a,b");
+    EXPECT_EQ(csv("a\tb", '\t'), "\"a\tb\"");
+    EXPECT_EQ(csv("say \"hi\"", ','), "\"say \"\"hi\"\"\"");
+    EXPECT_EQ(csv("\"", ','), "\"\"\"\"");
+    EXPECT_EQ(csv("line\r\nbreak", ','), "\"line\r\nbreak\"");
+}
+
+TEST(StrBufEscapeTest, MatchesReferenceAcrossVectorBoundaries) {
+    std::mt19937 rng(9);
+    const char alphabet[] = "abcdefghij ,\"\\\n\r\t\x01\x1f\x7f\x80\xff";
+    for (int iter = 0; iter < 3000; ++iter) {
+        std::string s(rng() % 100, 'a');
+        // sparse specials so clean runs of all lengths occur
+        for (auto& c : s) c = rng() % 8 ? (char)('a' + rng() % 26) : alphabet[rng() % (sizeof(alphabet) - 1)];
+        ASSERT_EQ(json(s), ref_json(s)) << s;
+        ASSERT_EQ(csv(s, ','), ref_csv(s, ',')) << s;
+        ASSERT_EQ(csv(s, '\t'), ref_csv(s, '\t')) << s;
+    }
+}
+
+TEST(StrBufEscapeTest, EscapesASliceOfTheSameBuffer) {
+    // every escape grows the buffer, moving the bytes still to be read
+    std::string text = "a\"b\n";
+    for (int i = 0; i < 6; ++i) text += text;
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_init(&sb, text.size() + 1), 0);
+    ASSERT_EQ(strbuf_append_n(&sb, text.data(), text.size()), 0);
+    ASSERT_EQ(strbuf_append_json_escaped(&sb, sb.data, sb.size), 0);
+    EXPECT_EQ(std::string(sb.data, sb.size), text + ref_json(text));
+    strbuf_free(&sb);
+
+    ASSERT_EQ(strbuf_init(&sb, text.size() + 1), 0);
+    ASSERT_EQ(strbuf_append_n(&sb, text.data(), text.size()), 0);
+    ASSERT_EQ(strbuf_append_csv_escaped(&sb, sb.data + 1, sb.size - 1, ','), 0);
+    EXPECT_EQ(std::string(sb.data, sb.size), text + ref_csv(text.substr(1), ','));
+    strbuf_free(&sb);
+}
+
+TEST(StrBufEscapeTest, InvalidArgs) {
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_init(&sb, 0), 0);
+    EXPECT_EQ(strbuf_append_json_escaped(nullptr, "a", 1), -1);
+    EXPECT_EQ(strbuf_append_json_escaped(&sb, nullptr, 1), -1);
+    EXPECT_EQ(strbuf_append_csv_escaped(nullptr, "a", 1, ','), -1);
+    EXPECT_EQ(strbuf_append_csv_escaped(&sb, nullptr, 1, ','), -1);
+    EXPECT_EQ(strbuf_append_json_escaped(&sb, nullptr, 0), 0);
+    EXPECT_EQ(sb.size, 0u);
+    strbuf_free(&sb);
+}
@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+
+extern "C" {
+#include "strbuf_gap.h"
+}
+
+static std::string content(strbuf_gap_t* gb) {
+    return std::string(strbuf_gap_c_str(gb), strbuf_gap_size(gb));
+}
+
+TEST(StrBufGapTest, InsertEraseAroundCursor) {
+    strbuf_gap_t gb;
+    ASSERT_EQ(strbuf_gap_init(&gb, 0), 0);
+    EXPECT_STREQ(strbuf_gap_c_str(&gb), "");
+
+    ASSERT_EQ(strbuf_gap_insert(&gb, "Hello world", 11), 0);
+    EXPECT_EQ(gb.cursor, 11u);
+    ASSERT_EQ(strbuf_gap_move_cursor(&gb, 5), 0);
+    ASSERT_EQ(strbuf_gap_insert(&gb, ",", 1), 0);
+    ASSERT_EQ(strbuf_gap_insert(&gb, " dear", 5), 0);
+    EXPECT_EQ(content(&gb), "Hello, dear world");
+    EXPECT_EQ(gb.cursor, 11u);  // c_str leaves the cursor alone
+
+    // typing continues where it left off
+    ASSERT_EQ(strbuf_gap_insert(&gb, "est", 3), 0);
+    EXPECT_EQ(content(&gb), "Hello, dearest world");
+
+    ASSERT_EQ(strbuf_gap_erase_range(&gb, 5, 9), 0);  // ", dearest"
+    EXPECT_EQ(gb.cursor, 5u);
+    EXPECT_EQ(content(&gb), "Hello world");
+
+    ASSERT_EQ(strbuf_gap_insert_at(&gb, 0, ">> ", 3), 0);
+    ASSERT_EQ(strbuf_gap_insert_at(&gb, strbuf_gap_size(&gb), "!", 1), 0);
+    EXPECT_STREQ(strbuf_gap_c_str(&gb), ">> Hello world!");
+
+    strbuf_gap_free(&gb);
+    strbuf_gap_free(&gb);
+}
+
+TEST(StrBufGapTest, EditsNearTheGapMoveNoContent) {
+    strbuf_gap_t gb;
+    ASSERT_EQ(strbuf_gap_init(&gb, 1024), 0);
+    std::string text(500, 'x');
+    ASSERT_EQ(strbuf_gap_insert(&gb, text.data(), text.size()), 0);
+    ASSERT_EQ(strbuf_gap_move_cursor(&gb, 100), 0);
+    ASSERT_EQ(strbuf_gap_insert(&gb, "ab", 2), 0);
+    EXPECT_EQ(gb.gap_start, 102u);
+
+    // inserts, backspace and forward delete at the cursor keep the gap put
+    const char* tail = &gb.data[gb.gap_end];
+    for (int i = 0; i < 100; ++i) {
+        ASSERT_EQ(strbuf_gap_insert(&gb, "cd", 2), 0);
+        ASSERT_EQ(strbuf_gap_erase_range(&gb, gb.cursor - 1, 1), 0);
+        ASSERT_EQ(strbuf_gap_erase_range(&gb, gb.cursor, 1), 0);
+    }
+    EXPECT_EQ(gb.gap_start, gb.cursor);
+    EXPECT_EQ(&gb.data[gb.gap_end], tail + 100);
+    EXPECT_EQ(strbuf_gap_size(&gb), 502u);
+
+    strbuf_gap_free(&gb);
+}
+
+TEST(StrBufGapTest, RandomEditsMatchStdString) {
+    std::mt19937 rng(45);
+    strbuf_gap_t gb;
+    ASSERT_EQ(strbuf_gap_init(&gb, 0), 0);
+    std::string model;
+
+    for (int step = 0; step < 20000; ++step) {
+        unsigned op = rng() % 10;
+        if (op < 5) {
+            std::string piece(rng() % 40, (char)('a' + rng() % 26));
+            size_t pos = rng() % (model.size() + 1);
+            if (op == 0) {
+                ASSERT_EQ(strbuf_gap_insert_at(&gb, pos, piece.data(), piece.size()), 0);
+            } else {
+                pos = gb.cursor;  // typing
+                ASSERT_EQ(strbuf_gap_insert(&gb, piece.data(), piece.size()), 0);
+            }
+            model.insert(pos, piece);
+            ASSERT_EQ(gb.cursor, pos + piece.size());
+        } else if (op < 8) {
+            size_t pos = rng() % (model.size() + 1);
+            size_t n = rng() % (model.size() - pos + 1) % 64;
+            ASSERT_EQ(strbuf_gap_erase_range(&gb, pos, n), 0);
+            model.erase(pos, n);
+        } else if (op == 8) {
+            ASSERT_EQ(strbuf_gap_move_cursor(&gb, rng() % (model.size() + 1)), 0);
+        } else if (step % 16 == 0) {
+            ASSERT_EQ(content(&gb), model);
+        }
+        ASSERT_EQ(strbuf_gap_size(&gb), model.size());
+    }
+    EXPECT_EQ(content(&gb), model);
+
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_init(&sb, 0), 0);
+    ASSERT_EQ(strbuf_append_cstr(&sb, "<"), 0);
+    ASSERT_EQ(strbuf_gap_move_cursor(&gb, model.size() / 2), 0);
+    ASSERT_EQ(strbuf_gap_insert(&gb, "|", 1), 0);
+    model.insert(model.size() / 2, "|");
+    ASSERT_EQ(strbuf_gap_append_to(&sb, &gb), 0);
+    EXPECT_EQ(std::string(sb.data, sb.size), "<" + model);
+
+    strbuf_free(&sb);
+    strbuf_gap_free(&gb);
+}
+
+TEST(StrBufGapTest, InvalidArgs) {
+    strbuf_gap_t gb;
+    ASSERT_EQ(strbuf_gap_init(&gb, 0), 0);
+    ASSERT_EQ(strbuf_gap_insert(&gb, "abc", 3), 0);
+
+    EXPECT_EQ(strbuf_gap_init(nullptr, 0), -1);
+    EXPECT_EQ(strbuf_gap_move_cursor(&gb, 4), -1);
+    EXPECT_EQ(strbuf_gap_insert_at(&gb, 4, "x", 1), -1);
+    EXPECT_EQ(strbuf_gap_insert(&gb, nullptr, 1), -1);
+    EXPECT_EQ(strbuf_gap_erase_range(&gb, 2, 2), -1);
+    EXPECT_EQ(strbuf_gap_erase_range(&gb, 4, 0), -1);
+    EXPECT_EQ(strbuf_gap_append_to(nullptr, &gb), -1);
+    EXPECT_EQ(gb.cursor, 3u);
+    EXPECT_STREQ(strbuf_gap_c_str(&gb), "abc");
+    EXPECT_STREQ(strbuf_gap_c_str(nullptr), "");
+    EXPECT_EQ(strbuf_gap_size(nullptr), 0u);
+
+    strbuf_gap_free(&gb);
+}
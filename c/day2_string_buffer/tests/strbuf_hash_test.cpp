@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <set>
+#include <string>
+
+extern "C" {
+#include "strbuf.h"
+#include "strbuf_arena.h"
+}
+
+TEST(StrBufHashTest, HashDependsOnBytesLengthAndSeed) {
+    std::set<uint64_t> seen;
+    std::string s;
+    // every length class: 0, 1..3, 4..16, 17..48, > 48
+    for (size_t n = 0; n < 200; ++n) {
+        EXPECT_TRUE(seen.insert(strbuf_hash_bytes(s.data(), s.size(), 0)).second) << n;
+        s += '\0';
+    }
+
+    std::mt19937 rng(3);
+    std::string a(100, 'a');
+    for (auto& c : a) c = (char)rng();
+    uint64_t h = strbuf_hash_bytes(a.data(), a.size(), 0);
+    EXPECT_EQ(h, strbuf_hash_bytes(a.data(), a.size(), 0));
+    EXPECT_NE(h, strbuf_hash_bytes(a.data(), a.size(), 1));
+    for (size_t i = 0; i < a.size(); ++i) {
+        std::string b = a;
+        b[i] ^= 1;
+        EXPECT_NE(h, strbuf_hash_bytes(b.data(), b.size(), 0)) << i;
+    }
+}
+
+TEST(StrBufHashTest, BufferAndViewHashesAgree) {
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_init(&sb, 0), 0);
+    strbuf_view_t empty = {nullptr, 0};
+    EXPECT_EQ(strbuf_hash(&sb), strbuf_view_hash(empty));
+    EXPECT_EQ(strbuf_hash(&sb), strbuf_hash_bytes("", 0, 0));
+
+    ASSERT_EQ(strbuf_append_cstr(&sb, "key,value"), 0);
+    strbuf_view_t key = {sb.data, 3};
+    strbuf_view_t all = {sb.data, sb.size};
+    EXPECT_EQ(strbuf_view_hash(key), strbuf_hash_bytes("key", 3, 0));
+    EXPECT_EQ(strbuf_view_hash(all), strbuf_hash(&sb));
+    strbuf_free(&sb);
+}
+
+TEST(StrBufHashTest, CacheIsDroppedByModifications) {
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_init(&sb, 0), 0);
+    const char* text = "longer than the inline buffer";
+    ASSERT_EQ(strbuf_append_cstr(&sb, text), 0);
+    ASSERT_FALSE(sb.flags & STRBUF_F_INLINE);
+
+    uint64_t h = strbuf_hash(&sb);
+    EXPECT_TRUE(sb.flags & STRBUF_F_HASHED);
+    EXPECT_EQ(sb.hash, h);
+    EXPECT_EQ(strbuf_hash(&sb), h);
+
+    // each modifying call must leave a hash matching the new content
+    auto check = [&](const char* what) {
+        EXPECT_EQ(strbuf_hash(&sb), strbuf_hash_bytes(sb.data, sb.size, 0)) << what;
+    };
+    ASSERT_EQ(strbuf_append_n(&sb, "d", 1), 0);
+    check("append_n");
+    ASSERT_EQ(strbuf_appendf(&sb, "%d", 42), 0);
+    check("appendf");
+    ASSERT_EQ(strbuf_append_int(&sb, -7), 0);
+    check("append_int");
+    ASSERT_EQ(strbuf_append_json_escaped(&sb, "\"", 1), 0);
+    check("json");
+    ASSERT_EQ(strbuf_append_base64(&sb, "xy", 2), 0);
+    check("base64");
+    ASSERT_EQ(strbuf_decode_hex(&sb, "41", 2), 0);
+    check("decode_hex");
+    ASSERT_EQ(strbuf_append_utf8(&sb, "\xc3\xa9", 2), 0);
+    check("utf8");
+    // growth keeps the content, and the cache
+    ASSERT_EQ(strbuf_reserve(&sb, 1000), 0);
+    EXPECT_TRUE(sb.flags & STRBUF_F_HASHED);
+    check("reserve");
+
+    strbuf_clear(&sb);
+    EXPECT_FALSE(sb.flags & STRBUF_F_HASHED);
+    EXPECT_EQ(strbuf_hash(&sb), strbuf_hash_bytes("", 0, 0));
+    ASSERT_EQ(strbuf_append_cstr(&sb, text), 0);
+    EXPECT_EQ(strbuf_hash(&sb), h);
+
+    // the cached value travels with strbuf_move
+    strbuf_t dst;
+    strbuf_move(&dst, &sb);
+    EXPECT_EQ(strbuf_hash(&dst), h);
+    EXPECT_EQ(strbuf_hash(&sb), strbuf_hash_bytes("", 0, 0));
+
+    strbuf_free(&dst);
+    strbuf_free(&sb);
+}
+
+TEST(StrBufHashTest, InlineBufferHashesWithoutCaching) {
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_init(&sb, 0), 0);
+    ASSERT_EQ(strbuf_append_cstr(&sb, "abc"), 0);
+    ASSERT_TRUE(sb.flags & STRBUF_F_INLINE);
+
+    // the cache slot overlays inline_buf, so the content must stay intact
+    EXPECT_EQ(strbuf_hash(&sb), strbuf_hash_bytes("abc", 3, 0));
+    EXPECT_FALSE(sb.flags & STRBUF_F_HASHED);
+    EXPECT_STREQ(strbuf_c_str(&sb), "abc");
+
+    std::string big(100, 'z');
+    ASSERT_EQ(strbuf_append_n(&sb, big.data(), big.size()), 0);
+    EXPECT_EQ(strbuf_hash(&sb), strbuf_hash_bytes(("abc" + big).data(), 103, 0));
+    EXPECT_TRUE(sb.flags & STRBUF_F_HASHED);
+
+    strbuf_free(&sb);
+}
+
+TEST(StrBufHashTest, ArenaBufferStartsUnhashed) {
+    strbuf_arena_t arena;
+    ASSERT_EQ(strbuf_arena_init(&arena, 0), 0);
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_init_arena(&sb, &arena, 0), 0);
+    ASSERT_EQ(strbuf_append_cstr(&sb, "pooled"), 0);
+    EXPECT_EQ(strbuf_hash(&sb), strbuf_hash_bytes("pooled", 6, 0));
+    strbuf_free(&sb);
+    strbuf_arena_free(&arena);
+}
@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include "strbuf_intern.h"
+}
+
+TEST(StrBufInternTest, SameBytesGiveSameHandleAndAddress) {
+    strbuf_intern_t pool;
+    ASSERT_EQ(strbuf_intern_init(&pool), 0);
+    EXPECT_EQ(strbuf_intern_find(&pool, "cpu", 3), 0u);
+
+    strbuf_atom_t a = strbuf_intern(&pool, "cpu.user", 8);
+    strbuf_atom_t b = strbuf_intern(&pool, "cpu.system", 10);
+    ASSERT_NE(a, 0u);
+    ASSERT_NE(b, 0u);
+    EXPECT_NE(a, b);
+
+    // a separately built copy of the same bytes maps to the same handle
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_init(&sb, 0), 0);
+    ASSERT_EQ(strbuf_append_cstr(&sb, "cpu."), 0);
+    ASSERT_EQ(strbuf_append_cstr(&sb, "user"), 0);
+    EXPECT_EQ(strbuf_intern_sb(&pool, &sb), a);
+    EXPECT_EQ(strbuf_intern_find(&pool, "cpu.user", 8), a);
+    EXPECT_EQ(pool.count, 2u);
+
+    strbuf_view_t v = strbuf_intern_get(&pool, a);
+    EXPECT_EQ(std::string(v.data, v.size), "cpu.user");
+    EXPECT_EQ(v.data[v.size], '\0');
+    EXPECT_NE(v.data, sb.data);
+    EXPECT_EQ(strbuf_intern_get(&pool, a).data, v.data);
+
+    strbuf_free(&sb);
+    strbuf_intern_free(&pool);
+    strbuf_intern_free(&pool);
+}
+
+TEST(StrBufInternTest, EmptyAndBinaryStrings) {
+    strbuf_intern_t pool;
+    ASSERT_EQ(strbuf_intern_init(&pool), 0);
+
+    strbuf_atom_t empty = strbuf_intern(&pool, "", 0);
+    ASSERT_NE(empty, 0u);
+    EXPECT_EQ(strbuf_intern(&pool, nullptr, 0), empty);
+
+    strbuf_atom_t x = strbuf_intern(&pool, "a\0b", 3);
+    strbuf_atom_t y = strbuf_intern(&pool, "a\0c", 3);
+    strbuf_atom_t z = strbuf_intern(&pool, "a", 1);
+    EXPECT_NE(x, y);
+    EXPECT_NE(x, z);
+    EXPECT_EQ(strbuf_intern_get(&pool, x).size, 3u);
+
+    EXPECT_EQ(strbuf_intern_get(&pool, 0).data, nullptr);
+    EXPECT_EQ(strbuf_intern_get(&pool, 99).data, nullptr);
+    EXPECT_EQ(strbuf_intern(&pool, nullptr, 1), 0u);
+    EXPECT_EQ(strbuf_intern(nullptr, "a", 1), 0u);
+
+    strbuf_intern_free(&pool);
+}
+
+TEST(StrBufInternTest, ManyStringsStayStableAcrossGrowth) {
+    strbuf_intern_t pool;
+    ASSERT_EQ(strbuf_intern_init(&pool), 0);
+
+    const int n = 100000;
+    std::vector<strbuf_atom_t> atoms(n);
+    std::vector<const char*> addrs(n);
+    for (int i = 0; i < n; ++i) {
+        std::string key = "metric." + std::to_string(i);
+        atoms[i] = strbuf_intern(&pool, key.data(), key.size());
+        ASSERT_NE(atoms[i], 0u);
+        addrs[i] = strbuf_intern_get(&pool, atoms[i]).data;
+    }
+    // an oversized string lands in a chunk of its own
+    std::string big(200000, 'q');
+    strbuf_atom_t big_atom = strbuf_intern(&pool, big.data(), big.size());
+    ASSERT_NE(big_atom, 0u);
+
+    EXPECT_EQ(pool.count, (size_t)n + 1);
+    for (int i = 0; i < n; ++i) {
+        std::string key = "metric." + std::to_string(i);
+        ASSERT_EQ(strbuf_intern(&pool, key.data(), key.size()), atoms[i]);
+        strbuf_view_t v = strbuf_intern_get(&pool, atoms[i]);
+        ASSERT_EQ(v.data, addrs[i]);
+        ASSERT_EQ(std::string(v.data, v.size), key);
+    }
+    EXPECT_EQ(strbuf_intern(&pool, big.data(), big.size()), big_atom);
+    EXPECT_EQ(pool.count, (size_t)n + 1);
+
+    strbuf_intern_free(&pool);
+}
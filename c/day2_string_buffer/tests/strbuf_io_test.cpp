@@ -0,0 +1,390 @@
+#include <gtest/gtest.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <random>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+extern "C" {
+#include "strbuf_io.h"
+}
+
+struct Bufs {
+    std::vector<strbuf_t> sbs;
+    std::vector<const strbuf_t*> ptrs;
+    std::string all;
+
+    explicit Bufs(const std::vector<std::string>& parts) : sbs(parts.size()) {
+        for (size_t i = 0; i < parts.size(); ++i) {
+            strbuf_init(&sbs[i], 0);
+            strbuf_append_n(&sbs[i], parts[i].data(), parts[i].size());
+            all += parts[i];
+        }
+        for (auto& sb : sbs) ptrs.push_back(&sb);
+    }
+    ~Bufs() {
+        for (auto& sb : sbs) strbuf_free(&sb);
+    }
+};
+
+static std::string read_all(int fd) {
+    std::string out;
+    char buf[65536];
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) > 0) out.append(buf, (size_t)n);
+    return out;
+}
+
+static std::string read_file_at(int fd, off_t off) {
+    EXPECT_EQ(lseek(fd, off, SEEK_SET), off);
+    return read_all(fd);
+}
+
+TEST(StrBufIoTest, WritevGathersAllBuffers) {
+    Bufs b({"hello", "", " ", "world", std::string("\0nul", 4), "!"});
+    FILE* f = tmpfile();
+    ASSERT_NE(f, nullptr);
+    int fd = fileno(f);
+
+    size_t consumed = 0;
+    EXPECT_EQ(strbuf_writev_fd(fd, b.ptrs.data(), b.ptrs.size(), &consumed), STRBUF_IO_DONE);
+    EXPECT_EQ(consumed, b.all.size());
+    EXPECT_EQ(read_file_at(fd, 0), b.all);
+
+    // calling again with everything consumed is a no-op
+    EXPECT_EQ(strbuf_writev_fd(fd, b.ptrs.data(), b.ptrs.size(), &consumed), STRBUF_IO_DONE);
+    EXPECT_EQ(consumed, b.all.size());
+
+    fclose(f);
+}
+
+TEST(StrBufIoTest, WritevManyBuffersBeyondIovMax) {
+    std::vector<std::string> parts;
+    for (int i = 0; i < 5000; ++i) parts.push_back(std::to_string(i) + ",");
+    Bufs b(parts);
+
+    FILE* f = tmpfile();
+    ASSERT_NE(f, nullptr);
+    size_t consumed = 0;
+    EXPECT_EQ(strbuf_writev_fd(fileno(f), b.ptrs.data(), b.ptrs.size(), &consumed), STRBUF_IO_DONE);
+    EXPECT_EQ(read_file_at(fileno(f), 0), b.all);
+    fclose(f);
+}
+
+TEST(StrBufIoTest, ResumesFromConsumedOffset) {
+    Bufs b({"abc", "defgh", "ij"});
+    FILE* f = tmpfile();
+    ASSERT_NE(f, nullptr);
+
+    size_t consumed = 4; // pretend "abcd" was already written elsewhere
+    EXPECT_EQ(strbuf_writev_fd(fileno(f), b.ptrs.data(), b.ptrs.size(), &consumed), STRBUF_IO_DONE);
+    EXPECT_EQ(consumed, 10u);
+    EXPECT_EQ(read_file_at(fileno(f), 0), "efghij");
+    fclose(f);
+}
+
+TEST(StrBufIoTest, NonBlockingPipeReportsPendingAndResumes) {
+    int p[2];
+    ASSERT_EQ(pipe(p), 0);
+    ASSERT_EQ(fcntl(p[1], F_SETFL, fcntl(p[1], F_GETFL) | O_NONBLOCK), 0);
+
+    std::vector<std::string> parts;
+    for (int i = 0; i < 64; ++i) parts.push_back(std::string(16384, (char)('a' + i % 26)));
+    Bufs b(parts); // 1 MiB, far more than the default pipe buffer
+
+    std::string got;
+    size_t consumed = 0;
+    int ret;
+    int pending = 0;
+    while ((ret = strbuf_writev_fd(p[1], b.ptrs.data(), b.ptrs.size(), &consumed)) ==
+           STRBUF_IO_PENDING) {
+        ++pending;
+        char buf[65536];
+        ssize_t n = read(p[0], buf, sizeof(buf));
+        ASSERT_GT(n, 0);
+        got.append(buf, (size_t)n);
+    }
+    ASSERT_EQ(ret, STRBUF_IO_DONE);
+    EXPECT_GT(pending, 0);
+    EXPECT_EQ(consumed, b.all.size());
+
+    close(p[1]);
+    got += read_all(p[0]);
+    close(p[0]);
+    EXPECT_EQ(got, b.all);
+}
+
+TEST(StrBufIoTest, PwritevWritesAtOffsetWithoutMovingFilePosition) {
+    Bufs b({"XY", "Z"});
+    FILE* f = tmpfile();
+    ASSERT_NE(f, nullptr);
+    int fd = fileno(f);
+    ASSERT_EQ(write(fd, "0123456789", 10), 10);
+
+    size_t consumed = 0;
+    EXPECT_EQ(strbuf_pwritev_fd(fd, b.ptrs.data(), b.ptrs.size(), 4, &consumed), STRBUF_IO_DONE);
+    EXPECT_EQ(consumed, 3u);
+    EXPECT_EQ(lseek(fd, 0, SEEK_CUR), 10);
+    EXPECT_EQ(read_file_at(fd, 0), "0123XYZ789");
+    fclose(f);
+}
+
+TEST(StrBufIoTest, ErrorsAreReported) {
+    Bufs b({"abc"});
+    size_t consumed = 0;
+
+    EXPECT_EQ(strbuf_writev_fd(-1, b.ptrs.data(), 1, &consumed), STRBUF_IO_ERR);
+    EXPECT_EQ(strbuf_writev_fd(1, b.ptrs.data(), 1, nullptr), STRBUF_IO_ERR);
+
+    int p[2];
+    ASSERT_EQ(pipe(p), 0);
+    close(p[1]);
+    // writing to a closed fd fails with EBADF
+    EXPECT_EQ(strbuf_writev_fd(p[1], b.ptrs.data(), 1, &consumed), STRBUF_IO_ERR);
+    EXPECT_EQ(errno, EBADF);
+    EXPECT_EQ(consumed, 0u);
+    close(p[0]);
+}
+
+// Temporary file holding content, removed on destruction.
+struct TempFile {
+    std::string path;
+
+    explicit TempFile(const std::string& content) {
+        char name[] = "/tmp/strbuf_map_XXXXXX";
+        int fd = mkstemp(name);
+        EXPECT_GE(fd, 0);
+        EXPECT_EQ(write(fd, content.data(), content.size()), (ssize_t)content.size());
+        close(fd);
+        path = name;
+    }
+    ~TempFile() { unlink(path.c_str()); }
+};
+
+TEST(StrBufMapTest, MapsFileAsReadOnlyView) {
+    std::string content = "line one\nline two\n";
+    TempFile tf(content);
+
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_map_file(&sb, tf.path.c_str()), 0);
+    EXPECT_TRUE(sb.flags & STRBUF_F_MAPPED);
+    EXPECT_EQ(sb.size, content.size());
+    EXPECT_STREQ(strbuf_c_str(&sb), content.c_str());
+    EXPECT_EQ(strbuf_find(&sb, 0, "two", 3), 14u);
+
+    strbuf_free(&sb);
+    EXPECT_EQ(sb.data, nullptr);
+    EXPECT_EQ(sb.flags, 0u);
+    strbuf_free(&sb);
+}
+
+TEST(StrBufMapTest, PageMultipleFileIsStillTerminated) {
+    std::string content((size_t)sysconf(_SC_PAGESIZE) * 2, 'x');
+    TempFile tf(content);
+
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_map_file(&sb, tf.path.c_str()), 0);
+    ASSERT_EQ(sb.size, content.size());
+    EXPECT_EQ(sb.data[sb.size], '\0');
+    EXPECT_EQ(strlen(strbuf_c_str(&sb)), content.size());
+    strbuf_free(&sb);
+}
+
+TEST(StrBufMapTest, EmptyFileGivesEmptyBuffer) {
+    TempFile tf("");
+
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_map_file(&sb, tf.path.c_str()), 0);
+    EXPECT_EQ(sb.size, 0u);
+    EXPECT_EQ(sb.flags, 0u);
+    EXPECT_STREQ(strbuf_c_str(&sb), "");
+    ASSERT_EQ(strbuf_append_cstr(&sb, "ok"), 0);
+    EXPECT_STREQ(strbuf_c_str(&sb), "ok");
+    strbuf_free(&sb);
+}
+
+TEST(StrBufMapTest, MutationCopiesAndLeavesFileUntouched) {
+    TempFile tf("hello");
+
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_map_file(&sb, tf.path.c_str()), 0);
+    const char* view = sb.data;
+
+    ASSERT_EQ(strbuf_appendf(&sb, ", %s", "world"), 0);
+    EXPECT_FALSE(sb.flags & STRBUF_F_MAPPED);
+    EXPECT_NE(sb.data, view);
+    EXPECT_STREQ(strbuf_c_str(&sb), "hello, world");
+    ASSERT_EQ(strbuf_append_int(&sb, 42), 0);
+    EXPECT_STREQ(strbuf_c_str(&sb), "hello, world42");
+
+    int fd = open(tf.path.c_str(), O_RDONLY);
+    ASSERT_GE(fd, 0);
+    EXPECT_EQ(read_all(fd), "hello");
+    close(fd);
+    strbuf_free(&sb);
+
+    // clear and reserve drop the view as well
+    ASSERT_EQ(strbuf_map_file(&sb, tf.path.c_str()), 0);
+    strbuf_clear(&sb);
+    EXPECT_EQ(sb.flags, 0u);
+    EXPECT_EQ(sb.size, 0u);
+    EXPECT_STREQ(strbuf_c_str(&sb), "");
+    strbuf_free(&sb);
+
+    ASSERT_EQ(strbuf_map_file(&sb, tf.path.c_str()), 0);
+    ASSERT_EQ(strbuf_reserve(&sb, 0), 0);
+    EXPECT_TRUE(sb.flags & STRBUF_F_MAPPED);
+    ASSERT_EQ(strbuf_reserve(&sb, 1), 0);
+    EXPECT_EQ(sb.flags, 0u);
+    EXPECT_STREQ(strbuf_c_str(&sb), "hello");
+    strbuf_free(&sb);
+}
+
+TEST(StrBufMapTest, EmptyAppendsKeepTheMapping) {
+    TempFile tf("hello");
+
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_map_file(&sb, tf.path.c_str()), 0);
+    const char* view = sb.data;
+
+    // each of these would fault if it wrote a terminator into the mapping
+    EXPECT_EQ(strbuf_append_n(&sb, "", 0), 0);
+    EXPECT_EQ(strbuf_appendf(&sb, "%s", ""), 0);
+    EXPECT_EQ(strbuf_append_iov(&sb, nullptr, 0), 0);
+    EXPECT_EQ(strbuf_append_json_escaped(&sb, "", 0), 0);
+    EXPECT_EQ(strbuf_append_csv_escaped(&sb, "", 0, ','), 0);
+    EXPECT_EQ(strbuf_append_base64(&sb, "", 0), 0);
+    EXPECT_EQ(strbuf_decode_base64(&sb, "", 0), 0);
+    EXPECT_EQ(strbuf_append_hex_bytes(&sb, "", 0), 0);
+    EXPECT_EQ(strbuf_decode_hex(&sb, "", 0), 0);
+    EXPECT_EQ(strbuf_append_utf8(&sb, "", 0), 0);
+
+    EXPECT_TRUE(sb.flags & STRBUF_F_MAPPED);
+    EXPECT_EQ(sb.data, view);
+    EXPECT_EQ(sb.size, 5u);
+    EXPECT_STREQ(strbuf_c_str(&sb), "hello");
+    strbuf_free(&sb);
+}
+
+TEST(StrBufMapTest, FailuresAreReported) {
+    strbuf_t sb;
+    EXPECT_EQ(strbuf_map_file(&sb, "/nonexistent/strbuf/file"), STRBUF_IO_ERR);
+    EXPECT_EQ(errno, ENOENT);
+    EXPECT_EQ(strbuf_map_file(&sb, "/tmp"), STRBUF_IO_ERR);
+    EXPECT_EQ(errno, EINVAL);
+    EXPECT_EQ(strbuf_map_file(nullptr, "/tmp"), STRBUF_IO_ERR);
+}
+
+static std::vector<std::string> read_lines(int fd, size_t block_size) {
+    strbuf_line_reader_t lr;
+    EXPECT_EQ(strbuf_line_reader_init(&lr, fd, block_size), 0);
+    std::vector<std::string> out;
+    const char* line;
+    size_t len;
+    int rc;
+    while ((rc = strbuf_read_line(&lr, &line, &len)) == 1) {
+        EXPECT_EQ(line[len], '\0');
+        out.emplace_back(line, len);
+    }
+    EXPECT_EQ(rc, 0);
+    // end of input is sticky
+    EXPECT_EQ(strbuf_read_line(&lr, &line, &len), 0);
+    strbuf_line_reader_free(&lr);
+    return out;
+}
+
+static std::vector<std::string> lines_of(const std::string& text) {
+    std::vector<std::string> out;
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t nl = text.find('\n', start);
+        if (nl == std::string::npos) nl = text.size();
+        out.push_back(text.substr(start, nl - start));
+        start = nl + 1;
+    }
+    return out;
+}
+
+TEST(StrBufLineReaderTest, SplitsLinesAcrossBlockBoundaries) {
+    std::mt19937 rng(7);
+    std::string text;
+    for (int i = 0; i < 2000; ++i) {
+        text.append(rng() % 40, (char)('a' + i % 26));
+        text += '\n';
+    }
+    text += "no trailing newline";
+    TempFile tf(text);
+
+    for (size_t block : {1u, 7u, 64u, 4096u, 0u}) {
+        int fd = open(tf.path.c_str(), O_RDONLY);
+        ASSERT_GE(fd, 0);
+        EXPECT_EQ(read_lines(fd, block), lines_of(text)) << "block " << block;
+        close(fd);
+    }
+}
+
+TEST(StrBufLineReaderTest, EmptyLinesAndEmptyInput) {
+    TempFile empty("");
+    int fd = open(empty.path.c_str(), O_RDONLY);
+    ASSERT_GE(fd, 0);
+    EXPECT_TRUE(read_lines(fd, 16).empty());
+    close(fd);
+
+    TempFile blanks("\n\nx\n\n");
+    fd = open(blanks.path.c_str(), O_RDONLY);
+    ASSERT_GE(fd, 0);
+    EXPECT_EQ(read_lines(fd, 16), (std::vector<std::string>{"", "", "x", ""}));
+    close(fd);
+}
+
+TEST(StrBufLineReaderTest, LineLongerThanBlockGrowsBlock) {
+    std::string longline(100000, 'z');
+    TempFile tf("a\n" + longline + "\nb\n");
+    int fd = open(tf.path.c_str(), O_RDONLY);
+    ASSERT_GE(fd, 0);
+    EXPECT_EQ(read_lines(fd, 256), (std::vector<std::string>{"a", longline, "b"}));
+    close(fd);
+}
+
+TEST(StrBufLineReaderTest, ReadsFromPipe) {
+    int p[2];
+    ASSERT_EQ(pipe(p), 0);
+    std::thread writer([&] {
+        for (int i = 0; i < 1000; ++i) {
+            std::string rec = "record " + std::to_string(i) + "\n";
+            ASSERT_EQ(write(p[1], rec.data(), rec.size()), (ssize_t)rec.size());
+        }
+        close(p[1]);
+    });
+    auto lines = read_lines(p[0], 100);
+    writer.join();
+    close(p[0]);
+
+    ASSERT_EQ(lines.size(), 1000u);
+    EXPECT_EQ(lines[999], "record 999");
+}
+
+TEST(StrBufLineReaderTest, ErrorsAreReported) {
+    strbuf_line_reader_t lr;
+    const char* line;
+    size_t len;
+    EXPECT_EQ(strbuf_line_reader_init(&lr, -1, 0), STRBUF_IO_ERR);
+    EXPECT_EQ(strbuf_line_reader_init(nullptr, 0, 0), STRBUF_IO_ERR);
+
+    int p[2];
+    ASSERT_EQ(pipe(p), 0);
+    ASSERT_EQ(strbuf_line_reader_init(&lr, p[1], 16), 0);
+    // reading from the write end fails with EBADF
+    EXPECT_EQ(strbuf_read_line(&lr, &line, &len), STRBUF_IO_ERR);
+    EXPECT_EQ(errno, EBADF);
+    strbuf_line_reader_free(&lr);
+    strbuf_line_reader_free(&lr);
+    EXPECT_EQ(strbuf_read_line(&lr, &line, &len), STRBUF_IO_ERR);
+    close(p[0]);
+    close(p[1]);
+}
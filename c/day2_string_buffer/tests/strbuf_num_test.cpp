@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+
+extern "C" {
+#include "strbuf.h"
+}
+
+template <typename Fn>
+static std::string fmt(Fn fn) {
+    strbuf_t sb;
+    strbuf_init(&sb, 0);
+    EXPECT_EQ(fn(&sb), 0);
+    std::string out(strbuf_c_str(&sb), sb.size);
+    strbuf_free(&sb);
+    return out;
+}
+
+static std::string int_str(int64_t v) {
+    return fmt([v](strbuf_t* sb) { return strbuf_append_int(sb, v); });
+}
+static std::string uint_str(uint64_t v) {
+    return fmt([v](strbuf_t* sb) { return strbuf_append_uint64(sb, v); });
+}
+static std::string hex_str(uint64_t v) {
+    return fmt([v](strbuf_t* sb) { return strbuf_append_hex(sb, v); });
+}
+static std::string dbl_str(double v) {
+    return fmt([v](strbuf_t* sb) { return strbuf_append_double(sb, v); });
+}
+
+TEST(StrBufNumTest, IntegersEdgeValues) {
+    EXPECT_EQ(int_str(0), "0");
+    EXPECT_EQ(int_str(-1), "-1");
+    EXPECT_EQ(int_str(9), "9");
+    EXPECT_EQ(int_str(10), "10");
+    EXPECT_EQ(int_str(INT64_MAX), "9223372036854775807");
+    EXPECT_EQ(int_str(INT64_MIN), "-9223372036854775808");
+    EXPECT_EQ(uint_str(UINT64_MAX), "18446744073709551615");
+    EXPECT_EQ(uint_str(10000000000000000000ULL), "10000000000000000000");
+    EXPECT_EQ(hex_str(0), "0");
+    EXPECT_EQ(hex_str(0xf), "f");
+    EXPECT_EQ(hex_str(0x10), "10");
+    EXPECT_EQ(hex_str(UINT64_MAX), "ffffffffffffffff");
+}
+
+TEST(StrBufNumTest, IntegersMatchSnprintf) {
+    std::mt19937_64 rng(1);
+    char ref[32];
+    for (int i = 0; i < 100000; ++i) {
+        uint64_t v = rng() >> (rng() % 64);
+        snprintf(ref, sizeof(ref), "%" PRIu64, v);
+        ASSERT_EQ(uint_str(v), ref);
+        snprintf(ref, sizeof(ref), "%" PRIx64, v);
+        ASSERT_EQ(hex_str(v), ref);
+        snprintf(ref, sizeof(ref), "%" PRId64, (int64_t)v);
+        ASSERT_EQ(int_str((int64_t)v), ref);
+    }
+}
+
+TEST(StrBufNumTest, DoublesShortestKnownValues) {
+    EXPECT_EQ(dbl_str(0.0), "0");
+    EXPECT_EQ(dbl_str(-0.0), "-0");
+    EXPECT_EQ(dbl_str(0.1), "0.1");
+    EXPECT_EQ(dbl_str(-2.5), "-2.5");
+    EXPECT_EQ(dbl_str(100.0), "100");
+    EXPECT_EQ(dbl_str(123456.789), "123456.789");
+    EXPECT_EQ(dbl_str(1.0 / 3.0), "0.3333333333333333");
+    EXPECT_EQ(dbl_str(0.00001), "0.00001");
+    EXPECT_EQ(dbl_str(1e-7), "1e-07");
+    EXPECT_EQ(dbl_str(1e20), "100000000000000000000");
+    EXPECT_EQ(dbl_str(1e21), "1e+21");
+    EXPECT_EQ(dbl_str(1.5e300), "1.5e+300");
+    EXPECT_EQ(dbl_str(5e-324), "5e-324");
+    EXPECT_EQ(dbl_str(1.7976931348623157e308), "1.7976931348623157e+308");
+    EXPECT_EQ(dbl_str(NAN), "nan");
+    EXPECT_EQ(dbl_str(INFINITY), "inf");
+    EXPECT_EQ(dbl_str(-INFINITY), "-inf");
+}
+
+TEST(StrBufNumTest, DoublesRoundTrip) {
+    std::mt19937_64 rng(2);
+    for (int i = 0; i < 200000; ++i) {
+        uint64_t bits = rng();
+        double d;
+        memcpy(&d, &bits, sizeof(d));
+        if (std::isnan(d)) continue;
+        std::string s = dbl_str(d);
+        ASSERT_EQ(strtod(s.c_str(), nullptr), d) << s;
+    }
+    for (int i = 0; i < 100000; ++i) {
+        double d = (double)(rng() % 100000000) / (double)(1 + rng() % 10000);
+        std::string s = dbl_str(d);
+        ASSERT_EQ(strtod(s.c_str(), nullptr), d) << s;
+    }
+}
+
+TEST(StrBufNumTest, AppendsAfterExistingContent) {
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_init(&sb, 4), 0);
+    ASSERT_EQ(strbuf_append_cstr(&sb, "v="), 0);
+    ASSERT_EQ(strbuf_append_int(&sb, -42), 0);
+    ASSERT_EQ(strbuf_append_cstr(&sb, " x="), 0);
+    ASSERT_EQ(strbuf_append_hex(&sb, 0xbeef), 0);
+    ASSERT_EQ(strbuf_append_cstr(&sb, " d="), 0);
+    ASSERT_EQ(strbuf_append_double(&sb, 0.25), 0);
+    EXPECT_STREQ(strbuf_c_str(&sb), "v=-42 x=beef d=0.25");
+    EXPECT_EQ(sb.data[sb.size], '\0');
+    strbuf_free(&sb);
+
+    EXPECT_EQ(strbuf_append_int(nullptr, 1), -1);
+    EXPECT_EQ(strbuf_append_double(nullptr, 1.0), -1);
+}
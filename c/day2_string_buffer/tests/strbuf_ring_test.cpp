@@ -0,0 +1,152 @@
+#include <gtest/gtest.h>
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+extern "C" {
+#include "strbuf_ring.h"
+}
+
+TEST(StrBufRingTest, CapacityIsRoundedToPages) {
+    strbuf_ring_t ring;
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    ASSERT_EQ(strbuf_ring_init(&ring, 1, 0), 0);
+    EXPECT_EQ(ring.capacity, page);
+    strbuf_ring_free(&ring);
+
+    ASSERT_EQ(strbuf_ring_init(&ring, 3 * page, 0), 0);
+    EXPECT_EQ(ring.capacity, 4 * page);
+    strbuf_ring_free(&ring);
+    strbuf_ring_free(&ring);
+    EXPECT_EQ(ring.data, nullptr);
+}
+
+TEST(StrBufRingTest, StorageIsMirrored) {
+    strbuf_ring_t ring;
+    ASSERT_EQ(strbuf_ring_init(&ring, 4096, 0), 0);
+    ring.data[5] = 'x';
+    EXPECT_EQ(ring.data[ring.capacity + 5], 'x');
+    ring.data[ring.capacity + 7] = 'y';
+    EXPECT_EQ(ring.data[7], 'y');
+    strbuf_ring_free(&ring);
+}
+
+TEST(StrBufRingTest, SpansStayContiguousAcrossTheWrap) {
+    strbuf_ring_t ring;
+    ASSERT_EQ(strbuf_ring_init(&ring, 4096, 0), 0);
+    const size_t cap = ring.capacity;
+
+    // move both indexes close to the end of the storage
+    std::string filler(cap - 10, 'f');
+    ASSERT_EQ(strbuf_ring_write(&ring, filler.data(), filler.size()), 0);
+    size_t avail;
+    strbuf_ring_read_ptr(&ring, &avail);
+    ASSERT_EQ(avail, filler.size());
+    strbuf_ring_consume(&ring, avail);
+
+    // the whole ring is free and writable in one span that wraps
+    char* w = strbuf_ring_write_ptr(&ring, &avail);
+    ASSERT_EQ(avail, cap);
+    std::string msg = "a message that crosses the end of the storage";
+    memcpy(w, msg.data(), msg.size());
+    strbuf_ring_commit(&ring, msg.size());
+
+    const char* r = strbuf_ring_read_ptr(&ring, &avail);
+    ASSERT_EQ(avail, msg.size());
+    EXPECT_EQ(std::string(r, avail), msg);
+    EXPECT_EQ(r + 10, ring.data + cap);  // read span runs into the mirror
+
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_init(&sb, 0), 0);
+    EXPECT_EQ(strbuf_ring_read_into(&ring, &sb, 9), 9);
+    EXPECT_EQ(strbuf_ring_read_into(&ring, &sb, SIZE_MAX), (long)msg.size() - 9);
+    EXPECT_EQ(strbuf_ring_read_into(&ring, &sb, SIZE_MAX), 0);
+    EXPECT_EQ(std::string(sb.data, sb.size), msg);
+    EXPECT_EQ(ring.head - ring.tail, 0u);
+
+    strbuf_free(&sb);
+    strbuf_ring_free(&ring);
+}
+
+TEST(StrBufRingTest, WriteIsAllOrNothing) {
+    strbuf_ring_t ring;
+    ASSERT_EQ(strbuf_ring_init(&ring, 4096, 0), 0);
+    std::string full(ring.capacity - 3, 'a');
+    ASSERT_EQ(strbuf_ring_write(&ring, full.data(), full.size()), 0);
+    EXPECT_EQ(strbuf_ring_write(&ring, "1234", 4), -1);
+    EXPECT_EQ(ring.head, full.size());
+    EXPECT_EQ(strbuf_ring_write(&ring, "123", 3), 0);
+
+    size_t avail;
+    strbuf_ring_write_ptr(&ring, &avail);
+    EXPECT_EQ(avail, 0u);
+    strbuf_ring_consume(&ring, 100);
+    EXPECT_EQ(strbuf_ring_write(&ring, std::string(100, 'b').data(), 100), 0);
+
+    strbuf_ring_free(&ring);
+}
+
+TEST(StrBufRingTest, SpscHandoffAcrossThreads) {
+    strbuf_ring_t ring;
+    ASSERT_EQ(strbuf_ring_init(&ring, 1 << 16, STRBUF_RING_SPSC), 0);
+    const size_t total = 32u << 20;
+
+    std::thread producer([&] {
+        size_t sent = 0;
+        while (sent < total) {
+            size_t avail;
+            char* w = strbuf_ring_write_ptr(&ring, &avail);
+            if (avail == 0) {
+                std::this_thread::yield();
+                continue;
+            }
+            size_t n = std::min(avail, total - sent);
+            n = std::min(n, (size_t)(sent % 5000) + 1);  // uneven chunk sizes
+            for (size_t i = 0; i < n; ++i) w[i] = (char)((sent + i) * 131 >> 3);
+            strbuf_ring_commit(&ring, n);
+            sent += n;
+        }
+    });
+
+    size_t received = 0;
+    size_t mismatches = 0;
+    while (received < total) {
+        size_t avail;
+        const char* r = strbuf_ring_read_ptr(&ring, &avail);
+        if (avail == 0) {
+            std::this_thread::yield();
+            continue;
+        }
+        for (size_t i = 0; i < avail; ++i) {
+            mismatches += r[i] != (char)((received + i) * 131 >> 3);
+        }
+        strbuf_ring_consume(&ring, avail);
+        received += avail;
+    }
+    producer.join();
+
+    EXPECT_EQ(received, total);
+    EXPECT_EQ(mismatches, 0u);
+    strbuf_ring_free(&ring);
+}
+
+TEST(StrBufRingTest, InvalidArgs) {
+    strbuf_ring_t ring;
+    errno = 0;
+    EXPECT_EQ(strbuf_ring_init(nullptr, 4096, 0), -1);
+    EXPECT_EQ(errno, EINVAL);
+    EXPECT_EQ(strbuf_ring_init(&ring, 4096, 0x80), -1);
+    EXPECT_EQ(strbuf_ring_init(&ring, SIZE_MAX, 0), -1);
+
+    ASSERT_EQ(strbuf_ring_init(&ring, 4096, 0), 0);
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_init(&sb, 0), 0);
+    EXPECT_EQ(strbuf_ring_write(nullptr, "a", 1), -1);
+    EXPECT_EQ(strbuf_ring_write(&ring, nullptr, 1), -1);
+    EXPECT_EQ(strbuf_ring_read_into(&ring, nullptr, 1), -1);
+    EXPECT_EQ(strbuf_ring_read_into(nullptr, &sb, 1), -1);
+    strbuf_free(&sb);
+    strbuf_ring_free(&ring);
+}
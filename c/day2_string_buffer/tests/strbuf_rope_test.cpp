@@ -0,0 +1,196 @@
+#include <gtest/gtest.h>
+#include <cerrno>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+extern "C" {
+#include "strbuf_io.h"
+#include "strbuf_rope.h"
+}
+
+static std::string rope_content(const strbuf_rope_t& rope) {
+    std::string out;
+    for (size_t i = 0; i < rope.nchunks; ++i) {
+        const char* data;
+        size_t len = strbuf_rope_chunk(&rope, i, &data);
+        out.append(data, len);
+    }
+    return out;
+}
+
+TEST(StrBufRopeTest, AppendsFillFixedChunksWithoutMovingBytes) {
+    strbuf_rope_t rope;
+    ASSERT_EQ(strbuf_rope_init(&rope, 16), 0);
+    EXPECT_EQ(rope.nchunks, 0u);
+
+    ASSERT_EQ(strbuf_rope_append(&rope, "0123456789", 10), 0);
+    const char* first = rope.chunks[0].data;
+    ASSERT_EQ(strbuf_rope_append(&rope, "abcdefghij", 10), 0);
+    EXPECT_EQ(rope.nchunks, 2u);
+    EXPECT_EQ(rope.size, 20u);
+
+    std::string expect = "0123456789abcdefghij";
+    std::string big(100, 'z');
+    ASSERT_EQ(strbuf_rope_append(&rope, big.data(), big.size()), 0);
+    ASSERT_EQ(strbuf_rope_append(&rope, nullptr, 0), 0);
+    expect += big;
+    EXPECT_EQ(rope.chunks[0].data, first);
+    EXPECT_EQ(rope.nchunks, (expect.size() + 15) / 16);
+    EXPECT_EQ(rope_content(rope), expect);
+
+    // exactly filling a chunk does not allocate the next one early
+    strbuf_rope_t exact;
+    ASSERT_EQ(strbuf_rope_init(&exact, 8), 0);
+    ASSERT_EQ(strbuf_rope_append(&exact, "12345678", 8), 0);
+    EXPECT_EQ(exact.nchunks, 1u);
+
+    strbuf_rope_free(&exact);
+    strbuf_rope_free(&rope);
+    strbuf_rope_free(&rope);
+}
+
+TEST(StrBufRopeTest, AppendfInPlaceAndAcrossChunks) {
+    strbuf_rope_t rope;
+    ASSERT_EQ(strbuf_rope_init(&rope, 32), 0);
+    std::string expect;
+
+    for (int i = 0; i < 50; ++i) {
+        ASSERT_EQ(strbuf_rope_appendf(&rope, "row %d,%s;", i, i % 7 ? "x" : "a longer field value"), 0);
+        expect += "row " + std::to_string(i) + "," + (i % 7 ? "x" : "a longer field value") + ";";
+    }
+    ASSERT_EQ(strbuf_rope_appendf(&rope, "%s", ""), 0);
+    EXPECT_EQ(rope.size, expect.size());
+    EXPECT_EQ(rope_content(rope), expect);
+
+    strbuf_rope_free(&rope);
+}
+
+TEST(StrBufRopeTest, LongAppendfGetsAChunkOfItsOwn) {
+    strbuf_rope_t rope;
+    ASSERT_EQ(strbuf_rope_init(&rope, 16), 0);
+
+    ASSERT_EQ(strbuf_rope_append(&rope, "0123456789", 10), 0);
+    // does not fit the 6 bytes left: formatted whole into a new chunk
+    ASSERT_EQ(strbuf_rope_appendf(&rope, "<%s>", "abcdef"), 0);
+    ASSERT_EQ(rope.nchunks, 2u);
+    EXPECT_EQ(rope.chunks[0].size, 10u);
+    EXPECT_EQ(rope.chunks[1].size, 8u);
+    EXPECT_EQ(rope.chunks[1].capacity, 16u);
+
+    // longer than a chunk: one oversized chunk, no split
+    std::string big(40, 'b');
+    ASSERT_EQ(strbuf_rope_appendf(&rope, "[%s]", big.c_str()), 0);
+    ASSERT_EQ(rope.nchunks, 3u);
+    EXPECT_EQ(rope.chunks[2].size, 42u);
+    EXPECT_EQ(rope.chunks[2].capacity, 43u);
+
+    // plain appends use the spare byte, then continue in regular chunks
+    ASSERT_EQ(strbuf_rope_append(&rope, "xyz", 3), 0);
+    EXPECT_EQ(rope.chunks[2].size, 43u);
+    EXPECT_EQ(rope.chunks[3].capacity, 16u);
+
+    std::string expect = "0123456789<abcdef>[" + big + "]xyz";
+    EXPECT_EQ(rope.size, expect.size());
+    EXPECT_EQ(rope_content(rope), expect);
+
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_init(&sb, 0), 0);
+    ASSERT_EQ(strbuf_rope_flatten(&rope, &sb), 0);
+    EXPECT_EQ(std::string(sb.data, sb.size), expect);
+
+    strbuf_free(&sb);
+    strbuf_rope_free(&rope);
+}
+
+TEST(StrBufRopeTest, FlattenCopiesOnceAndEmptiesRope) {
+    std::mt19937 rng(47);
+    strbuf_rope_t rope;
+    ASSERT_EQ(strbuf_rope_init(&rope, 4096), 0);
+    std::string expect;
+    while (expect.size() < 100000) {
+        std::string piece(rng() % 3000, (char)('a' + rng() % 26));
+        ASSERT_EQ(strbuf_rope_append(&rope, piece.data(), piece.size()), 0);
+        expect += piece;
+    }
+
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_init(&sb, 0), 0);
+    ASSERT_EQ(strbuf_append_cstr(&sb, "head:"), 0);
+    ASSERT_EQ(strbuf_rope_flatten(&rope, &sb), 0);
+    EXPECT_EQ(std::string(sb.data, sb.size), "head:" + expect);
+    EXPECT_EQ(sb.data[sb.size], '\0');
+    EXPECT_EQ(sb.capacity, sb.size + 1);
+    EXPECT_EQ(rope.size, 0u);
+    EXPECT_EQ(rope.nchunks, 0u);
+
+    // the rope can be reused
+    ASSERT_EQ(strbuf_rope_append(&rope, "again", 5), 0);
+    EXPECT_EQ(rope_content(rope), "again");
+
+    strbuf_free(&sb);
+    strbuf_rope_free(&rope);
+}
+
+TEST(StrBufRopeTest, WritevSendsAllChunks) {
+    strbuf_rope_t rope;
+    ASSERT_EQ(strbuf_rope_init(&rope, 1000), 0);
+    std::string expect;
+    // more chunks than one writev call takes
+    for (int i = 0; i < 3000; ++i) {
+        std::string line = std::to_string(i * 7919) + "\n";
+        ASSERT_EQ(strbuf_rope_append(&rope, line.data(), line.size()), 0);
+        expect += line;
+    }
+    ASSERT_EQ(strbuf_rope_append(&rope, std::string(2000 * 1000, 'q').data(), 2000 * 1000), 0);
+    expect += std::string(2000 * 1000, 'q');
+
+    int p[2];
+    ASSERT_EQ(pipe(p), 0);
+    std::string got;
+    std::thread reader([&] {
+        char buf[65536];
+        ssize_t n;
+        while ((n = read(p[0], buf, sizeof(buf))) > 0) got.append(buf, (size_t)n);
+    });
+    size_t consumed = 0;
+    EXPECT_EQ(strbuf_rope_writev_fd(p[1], &rope, &consumed), STRBUF_IO_DONE);
+    close(p[1]);
+    reader.join();
+    close(p[0]);
+
+    EXPECT_EQ(consumed, expect.size());
+    EXPECT_EQ(got, expect);
+
+    strbuf_rope_free(&rope);
+}
+
+TEST(StrBufRopeTest, InvalidArgs) {
+    strbuf_rope_t rope;
+    ASSERT_EQ(strbuf_rope_init(&rope, 0), 0);
+    EXPECT_EQ(rope.chunk_size, 1u << 20);
+
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_init(&sb, 0), 0);
+    size_t consumed = 0;
+    EXPECT_EQ(strbuf_rope_init(nullptr, 0), -1);
+    EXPECT_EQ(strbuf_rope_append(nullptr, "a", 1), -1);
+    EXPECT_EQ(strbuf_rope_append(&rope, nullptr, 1), -1);
+    EXPECT_EQ(strbuf_rope_appendf(&rope, nullptr), -1);
+    EXPECT_EQ(strbuf_rope_flatten(nullptr, &sb), -1);
+    EXPECT_EQ(strbuf_rope_flatten(&rope, nullptr), -1);
+    errno = 0;
+    EXPECT_EQ(strbuf_rope_writev_fd(1, nullptr, &consumed), STRBUF_IO_ERR);
+    EXPECT_EQ(errno, EINVAL);
+
+    // an empty rope flattens and writes nothing
+    EXPECT_EQ(strbuf_rope_flatten(&rope, &sb), 0);
+    EXPECT_EQ(sb.size, 0u);
+    EXPECT_EQ(strbuf_rope_writev_fd(1, &rope, &consumed), STRBUF_IO_DONE);
+    EXPECT_EQ(consumed, 0u);
+
+    strbuf_free(&sb);
+    strbuf_rope_free(&rope);
+}
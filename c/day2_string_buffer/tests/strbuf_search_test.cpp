@@ -0,0 +1,204 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include "strbuf.h"
+}
+
+static void set(strbuf_t* sb, const std::string& s) {
+    strbuf_clear(sb);
+    ASSERT_EQ(strbuf_append_n(sb, s.data(), s.size()), 0);
+}
+
+static size_t ref_find(const std::string& h, size_t start, const std::string& n) {
+    size_t r = h.find(n, start);
+    return r == std::string::npos ? STRBUF_NPOS : r;
+}
+
+static size_t ref_rfind(const std::string& h, const std::string& n) {
+    size_t r = h.rfind(n);
+    return r == std::string::npos ? STRBUF_NPOS : r;
+}
+
+TEST(StrBufSearchTest, FindByte) {
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_init(&sb, 0), 0);
+    EXPECT_EQ(strbuf_find_byte(&sb, 0, 'a'), STRBUF_NPOS);
+
+    set(&sb, std::string("ab\0cb", 5));
+    EXPECT_EQ(strbuf_find_byte(&sb, 0, 'b'), 1u);
+    EXPECT_EQ(strbuf_find_byte(&sb, 2, 'b'), 4u);
+    EXPECT_EQ(strbuf_find_byte(&sb, 0, '\0'), 2u);
+    EXPECT_EQ(strbuf_find_byte(&sb, 5, 'b'), STRBUF_NPOS);
+    EXPECT_EQ(strbuf_find_byte(&sb, 0, 'z'), STRBUF_NPOS);
+    EXPECT_EQ(strbuf_find_byte(nullptr, 0, 'a'), STRBUF_NPOS);
+
+    strbuf_free(&sb);
+}
+
+TEST(StrBufSearchTest, FindSeesPastEmbeddedNul) {
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_init(&sb, 0), 0);
+    set(&sb, std::string("key\0value\0key2", 14));
+
+    EXPECT_EQ(strbuf_find(&sb, 0, "value", 5), 4u);
+    EXPECT_EQ(strbuf_find(&sb, 0, "key2", 4), 10u);
+    EXPECT_EQ(strbuf_find(&sb, 0, "\0key", 4), 9u);
+    EXPECT_EQ(strbuf_rfind(&sb, "key", 3), 10u);
+    EXPECT_EQ(strbuf_find(&sb, 1, "key", 3), 10u);
+
+    strbuf_free(&sb);
+}
+
+TEST(StrBufSearchTest, EdgeCases) {
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_init(&sb, 0), 0);
+
+    EXPECT_EQ(strbuf_find(&sb, 0, "", 0), 0u);
+    EXPECT_EQ(strbuf_rfind(&sb, "", 0), 0u);
+    EXPECT_EQ(strbuf_find(&sb, 0, "a", 1), STRBUF_NPOS);
+    EXPECT_EQ(strbuf_rfind(&sb, "a", 1), STRBUF_NPOS);
+
+    set(&sb, "hello");
+    EXPECT_EQ(strbuf_find(&sb, 3, "", 0), 3u);
+    EXPECT_EQ(strbuf_find(&sb, 6, "", 0), STRBUF_NPOS);
+    EXPECT_EQ(strbuf_rfind(&sb, "", 0), 5u);
+    EXPECT_EQ(strbuf_find(&sb, 0, "hello!", 6), STRBUF_NPOS);
+    EXPECT_EQ(strbuf_find(&sb, 0, "hello", 5), 0u);
+    EXPECT_EQ(strbuf_rfind(&sb, "hello", 5), 0u);
+    EXPECT_EQ(strbuf_find(&sb, 0, nullptr, 1), STRBUF_NPOS);
+
+    strbuf_free(&sb);
+}
+
+TEST(StrBufSearchTest, RandomSmallAlphabetMatchesStdString) {
+    std::mt19937 rng(3);
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_init(&sb, 0), 0);
+
+    for (int iter = 0; iter < 3000; ++iter) {
+        int alpha = 2 + (int)(rng() % 3);
+        size_t hl = rng() % 300;
+        size_t nl = 1 + rng() % (iter % 2 ? 12 : 40);
+        std::string h, n;
+        for (size_t i = 0; i < hl; ++i) h.push_back((char)('a' + rng() % alpha));
+        for (size_t i = 0; i < nl; ++i) n.push_back((char)('a' + rng() % alpha));
+        // plant the needle sometimes
+        if (hl >= nl && rng() % 2) h.replace(rng() % (hl - nl + 1), nl, n);
+        set(&sb, h);
+
+        size_t start = hl ? rng() % (hl + 1) : 0;
+        ASSERT_EQ(strbuf_find(&sb, start, n.data(), n.size()), ref_find(h, start, n))
+            << "h=" << h << " n=" << n << " start=" << start;
+        ASSERT_EQ(strbuf_rfind(&sb, n.data(), n.size()), ref_rfind(h, n))
+            << "h=" << h << " n=" << n;
+    }
+
+    strbuf_free(&sb);
+}
+
+TEST(StrBufSearchTest, AdversarialInputStaysCorrect) {
+    // first/last byte filter matches everywhere; forces the Two-Way fallback
+    std::string h(200000, 'a');
+    std::string n = std::string(500, 'a') + "b" + std::string(500, 'a');
+
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_init(&sb, 0), 0);
+    set(&sb, h);
+    EXPECT_EQ(strbuf_find(&sb, 0, n.data(), n.size()), STRBUF_NPOS);
+    EXPECT_EQ(strbuf_rfind(&sb, n.data(), n.size()), STRBUF_NPOS);
+
+    h[150000] = 'b';
+    set(&sb, h);
+    EXPECT_EQ(strbuf_find(&sb, 0, n.data(), n.size()), 150000u - 500u);
+    EXPECT_EQ(strbuf_rfind(&sb, n.data(), n.size()), 150000u - 500u);
+
+    strbuf_free(&sb);
+}
+
+static std::vector<std::string> ref_split(const std::string& s, const std::string& delims) {
+    std::vector<std::string> out;
+    size_t start = 0;
+    for (size_t i = 0; i < s.size(); ++i) {
+        if (delims.find(s[i]) != std::string::npos) {
+            out.push_back(s.substr(start, i - start));
+            start = i + 1;
+        }
+    }
+    out.push_back(s.substr(start));
+    return out;
+}
+
+static std::vector<std::string> collect(strbuf_split_t* it) {
+    std::vector<std::string> out;
+    strbuf_view_t field;
+    int rc;
+    while ((rc = strbuf_split_next(it, &field)) == 1) {
+        out.emplace_back(field.data, field.size);
+    }
+    EXPECT_EQ(rc, 0);
+    EXPECT_EQ(strbuf_split_next(it, &field), 0);
+    return out;
+}
+
+TEST(StrBufSplitTest, SingleDelimiterKeepsEmptyFields) {
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_init(&sb, 0), 0);
+    strbuf_split_t it;
+
+    ASSERT_EQ(strbuf_split_init(&it, &sb, ','), 0);
+    EXPECT_EQ(collect(&it), (std::vector<std::string>{""}));
+
+    set(&sb, "a,,b,");
+    ASSERT_EQ(strbuf_split_init(&it, &sb, ','), 0);
+    EXPECT_EQ(collect(&it), (std::vector<std::string>{"a", "", "b", ""}));
+
+    // fields point into the buffer
+    ASSERT_EQ(strbuf_split_init(&it, &sb, ','), 0);
+    strbuf_view_t field;
+    ASSERT_EQ(strbuf_split_next(&it, &field), 1);
+    EXPECT_EQ(field.data, sb.data);
+
+    set(&sb, std::string("x\0y\0", 4));
+    ASSERT_EQ(strbuf_split_init(&it, &sb, '\0'), 0);
+    EXPECT_EQ(collect(&it), (std::vector<std::string>{"x", "y", ""}));
+
+    strbuf_free(&sb);
+}
+
+TEST(StrBufSplitTest, MatchesReferenceOnRandomInput) {
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_init(&sb, 0), 0);
+    std::mt19937 rng(11);
+    // small sets use the SIMD compare, the 12-byte set the table path
+    const std::string sets[] = {",", "\t", ",;\n", "\xff\x80", "abcdefghijkl"};
+
+    for (int iter = 0; iter < 500; ++iter) {
+        std::string s(rng() % 300, 'x');
+        for (auto& c : s) c = (char)("abcdefghijklm,;\t\n\xff\x80"[rng() % 19]);
+        set(&sb, s);
+        for (const auto& d : sets) {
+            strbuf_split_t it;
+            ASSERT_EQ(strbuf_split_init_any(&it, &sb, d.data(), d.size()), 0);
+            ASSERT_EQ(collect(&it), ref_split(s, d)) << "input " << s << " delims " << d;
+        }
+    }
+
+    strbuf_free(&sb);
+}
+
+TEST(StrBufSplitTest, InvalidArgs) {
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_init(&sb, 0), 0);
+    strbuf_split_t it;
+    strbuf_view_t field;
+    EXPECT_EQ(strbuf_split_init(nullptr, &sb, ','), -1);
+    EXPECT_EQ(strbuf_split_init(&it, nullptr, ','), -1);
+    EXPECT_EQ(strbuf_split_init_any(&it, &sb, nullptr, 2), -1);
+    ASSERT_EQ(strbuf_split_init(&it, &sb, ','), 0);
+    EXPECT_EQ(strbuf_split_next(&it, nullptr), -1);
+    EXPECT_EQ(strbuf_split_next(nullptr, &field), -1);
+    strbuf_free(&sb);
+}
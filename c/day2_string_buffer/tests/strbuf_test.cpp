@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include <cstring>
+#include <string>
 
 extern "C" {
 #include "strbuf.h"
@@ -323,6 +324,25 @@ TEST(StrBufExtraTest, AppendAfterFreeReinitWorks) {
     strbuf_free(&sb);
 }
 
+TEST(StrBufExtraTest, AppendFromOwnContentSurvivesReallocation) {
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_init(&sb, 0), 0);
+    std::string expect = "this string is long enough for the heap";
+    ASSERT_EQ(strbuf_append_cstr(&sb, expect.c_str()), 0);
+
+    // each doubling reallocates while reading from the old storage
+    for (int i = 0; i < 8; ++i) {
+        ASSERT_EQ(strbuf_append_cstr(&sb, strbuf_c_str(&sb)), 0);
+        expect += expect;
+    }
+    ASSERT_EQ(strbuf_append_n(&sb, sb.data + 5, 6), 0);
+    expect += expect.substr(5, 6);
+    EXPECT_EQ(std::string(sb.data, sb.size), expect);
+    assert_basic_invariants(sb);
+
+    strbuf_free(&sb);
+}
+
 TEST(StrBufExtraTest, AppendNThenAppendCStrKeepsTrailingNullAtLogicalEnd) {
     strbuf_t sb;
     ASSERT_EQ(strbuf_init(&sb, 1), 0);
@@ -785,3 +805,302 @@ TEST(StrBufBugCatcher, InitWithCapacityOneThenAppendSingleCharSucceeds) {
     assert_basic_invariants(sb);
     strbuf_free(&sb);
 }
+
+TEST(StrBufGrowthTest, ReserveMakesFollowingAppendsAllocationFree) {
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_init(&sb, 0), 0);
+
+    ASSERT_EQ(strbuf_reserve(&sb, 100), 0);
+    EXPECT_GE(sb.capacity, 101u);
+    EXPECT_STREQ(strbuf_c_str(&sb), "");
+    assert_basic_invariants(sb);
+
+    const char* data_before = sb.data;
+    const size_t cap_before = sb.capacity;
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_EQ(strbuf_append_cstr(&sb, "0123456789"), 0);
+    }
+    EXPECT_EQ(sb.data, data_before);
+    EXPECT_EQ(sb.capacity, cap_before);
+    EXPECT_EQ(sb.size, 100u);
+    assert_basic_invariants(sb);
+
+    strbuf_free(&sb);
+}
+
+TEST(StrBufGrowthTest, CapacityGrowsGeometrically) {
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_init(&sb, 1), 0);
+
+    size_t growths = 0;
+    size_t last_cap = sb.capacity;
+    for (int i = 0; i < 1000000; ++i) {
+        ASSERT_EQ(strbuf_append_n(&sb, "x", 1), 0);
+        if (sb.capacity != last_cap) {
+            ++growths;
+            last_cap = sb.capacity;
+        }
+    }
+    EXPECT_EQ(sb.size, 1000000u);
+    EXPECT_LE(growths, 64u);
+    assert_basic_invariants(sb);
+
+    strbuf_free(&sb);
+}
+
+TEST(StrBufGrowthTest, OverflowingSizeIsRejectedAndStateUnchanged) {
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_init(&sb, 4), 0);
+    ASSERT_EQ(strbuf_append_cstr(&sb, "abc"), 0);
+
+    const size_t cap_before = sb.capacity;
+    EXPECT_EQ(strbuf_reserve(&sb, SIZE_MAX), -1);
+    EXPECT_EQ(strbuf_reserve(&sb, SIZE_MAX - 3), -1);
+    EXPECT_EQ(strbuf_append_n(&sb, "x", SIZE_MAX - 1), -1);
+    EXPECT_EQ(sb.capacity, cap_before);
+    EXPECT_STREQ(strbuf_c_str(&sb), "abc");
+    assert_basic_invariants(sb);
+
+    EXPECT_EQ(strbuf_reserve(nullptr, 1), -1);
+
+    strbuf_free(&sb);
+}
+
+static int vappendf_wrapper(strbuf_t* sb, const char* fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    int ret = strbuf_vappendf(sb, fmt, ap);
+    va_end(ap);
+    return ret;
+}
+
+TEST(StrBufFormatTest, AppendfFormatsIntoBuffer) {
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_init(&sb, 0), 0);
+
+    ASSERT_EQ(strbuf_appendf(&sb, "id=%d", 42), 0);
+    ASSERT_EQ(strbuf_appendf(&sb, " name=%s ratio=%.2f", "abc", 0.5), 0);
+    EXPECT_STREQ(strbuf_c_str(&sb), "id=42 name=abc ratio=0.50");
+    EXPECT_EQ(sb.size, strlen("id=42 name=abc ratio=0.50"));
+    assert_basic_invariants(sb);
+
+    // empty result is a no-op
+    ASSERT_EQ(strbuf_appendf(&sb, "%s", ""), 0);
+    EXPECT_EQ(sb.size, strlen("id=42 name=abc ratio=0.50"));
+
+    strbuf_free(&sb);
+}
+
+TEST(StrBufFormatTest, AppendfGrowsWhenSpareCapacityIsTooSmall) {
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_init(&sb, 8), 0);
+    ASSERT_EQ(strbuf_append_cstr(&sb, "head:"), 0);
+
+    std::string big(5000, 'q');
+    ASSERT_EQ(strbuf_appendf(&sb, "[%s]%d", big.c_str(), 7), 0);
+    EXPECT_EQ(std::string(strbuf_c_str(&sb)), "head:[" + big + "]7");
+    assert_basic_invariants(sb);
+
+    strbuf_free(&sb);
+}
+
+TEST(StrBufFormatTest, VappendfAndEmbeddedNul) {
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_init(&sb, 0), 0);
+
+    ASSERT_EQ(vappendf_wrapper(&sb, "%c%c%c", 'a', '\0', 'b'), 0);
+    EXPECT_EQ(sb.size, 3u);
+    EXPECT_EQ(sb.data[1], '\0');
+    EXPECT_EQ(sb.data[2], 'b');
+    assert_basic_invariants(sb);
+
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_EQ(vappendf_wrapper(&sb, "%04d,", i), 0);
+    }
+    EXPECT_EQ(sb.size, 3u + 1000u * 5u);
+    EXPECT_EQ(std::string(sb.data + sb.size - 5), "0999,");
+    assert_basic_invariants(sb);
+
+    strbuf_free(&sb);
+}
+
+TEST(StrBufFormatTest, AppendfInvalidArgs) {
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_init(&sb, 0), 0);
+    EXPECT_EQ(strbuf_appendf(nullptr, "x"), -1);
+    EXPECT_EQ(vappendf_wrapper(&sb, nullptr), -1);
+    EXPECT_STREQ(strbuf_c_str(&sb), "");
+    strbuf_free(&sb);
+}
+
+TEST(StrBufInlineTest, InlineBufferAddsNoSize) {
+    // inline_buf reuses the heap-only fields and is the last member
+    EXPECT_EQ(sizeof(strbuf_t), offsetof(strbuf_t, inline_buf) + STRBUF_INLINE_CAP);
+    EXPECT_EQ(offsetof(strbuf_t, arena), offsetof(strbuf_t, inline_buf));
+}
+
+TEST(StrBufInlineTest, ShortStringsStayInsideTheStruct) {
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_init(&sb, 0), 0);
+    EXPECT_EQ(sb.data, nullptr);
+
+    std::string expected(STRBUF_INLINE_CAP - 1, 'a');
+    ASSERT_EQ(strbuf_append_n(&sb, expected.data(), expected.size()), 0);
+    EXPECT_EQ(sb.data, sb.inline_buf);
+    EXPECT_TRUE(sb.flags & STRBUF_F_INLINE);
+    EXPECT_EQ(sb.capacity, (size_t)STRBUF_INLINE_CAP);
+    EXPECT_EQ(strbuf_c_str(&sb), expected);
+    assert_basic_invariants(sb);
+
+    // one more byte no longer fits with its terminator: spill to the heap
+    ASSERT_EQ(strbuf_append_cstr(&sb, "b"), 0);
+    expected += "b";
+    EXPECT_NE(sb.data, sb.inline_buf);
+    EXPECT_FALSE(sb.flags & STRBUF_F_INLINE);
+    EXPECT_EQ(strbuf_c_str(&sb), expected);
+    assert_basic_invariants(sb);
+
+    strbuf_free(&sb);
+    EXPECT_EQ(sb.flags, 0u);
+    strbuf_free(&sb);
+}
+
+TEST(StrBufInlineTest, AppendingOwnInlineBytesSpillsIntact) {
+    // spilling reuses the inline bytes for heap-only fields, which must
+    // not corrupt a source pointing into them
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_init(&sb, 0), 0);
+    ASSERT_EQ(strbuf_append_cstr(&sb, "abcdefghijklmnop"), 0);
+    ASSERT_EQ(sb.data, sb.inline_buf);
+    ASSERT_EQ(strbuf_append_n(&sb, sb.data, sb.size), 0);
+    EXPECT_NE(sb.data, sb.inline_buf);
+    EXPECT_EQ(std::string(sb.data, sb.size), "abcdefghijklmnopabcdefghijklmnop");
+    assert_basic_invariants(sb);
+    strbuf_free(&sb);
+
+    ASSERT_EQ(strbuf_init(&sb, 0), 0);
+    ASSERT_EQ(strbuf_append_cstr(&sb, "0123456789abcdef"), 0);
+    strbuf_view_t self[] = {{sb.data + 8, 8}, {sb.data, 16}};
+    ASSERT_EQ(strbuf_append_iov(&sb, self, 2), 0);
+    EXPECT_EQ(std::string(sb.data, sb.size), "0123456789abcdef89abcdef0123456789abcdef");
+    strbuf_free(&sb);
+}
+
+TEST(StrBufInlineTest, SmallInitialCapacityAndFormattingUseInlineBuffer) {
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_init(&sb, 8), 0);
+    EXPECT_EQ(sb.data, sb.inline_buf);
+
+    ASSERT_EQ(strbuf_appendf(&sb, "%d-%s", 42, "ok"), 0);
+    ASSERT_EQ(strbuf_append_int(&sb, -7), 0);
+    EXPECT_STREQ(strbuf_c_str(&sb), "42-ok-7");
+    EXPECT_EQ(sb.data, sb.inline_buf);
+
+    strbuf_clear(&sb);
+    EXPECT_EQ(sb.data, sb.inline_buf);
+    EXPECT_STREQ(strbuf_c_str(&sb), "");
+
+    ASSERT_EQ(strbuf_appendf(&sb, "%64s", "spilled"), 0);
+    EXPECT_NE(sb.data, sb.inline_buf);
+    EXPECT_EQ(sb.size, 64u);
+    assert_basic_invariants(sb);
+
+    strbuf_free(&sb);
+}
+
+TEST(StrBufInlineTest, MoveKeepsDataPointingAtOwnStorage) {
+    strbuf_t a, b;
+    ASSERT_EQ(strbuf_init(&a, 0), 0);
+    ASSERT_EQ(strbuf_append_cstr(&a, "short"), 0);
+
+    strbuf_move(&b, &a);
+    EXPECT_EQ(b.data, b.inline_buf);
+    EXPECT_STREQ(strbuf_c_str(&b), "short");
+    EXPECT_EQ(a.data, nullptr);
+    EXPECT_EQ(a.size, 0u);
+    ASSERT_EQ(strbuf_append_cstr(&b, " and now a much longer string"), 0);
+    EXPECT_STREQ(strbuf_c_str(&b), "short and now a much longer string");
+
+    // heap buffers move by pointer
+    const char* heap = b.data;
+    strbuf_move(&a, &b);
+    EXPECT_EQ(a.data, heap);
+    EXPECT_EQ(b.data, nullptr);
+
+    strbuf_free(&a);
+    strbuf_free(&b);
+}
+
+TEST(StrBufJoinTest, AppendIovGrowsOnce) {
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_init(&sb, 0), 0);
+    ASSERT_EQ(strbuf_append_cstr(&sb, "GET "), 0);
+
+    std::string long_path(100, 'p');
+    strbuf_view_t pieces[] = {
+        {"/", 1}, {long_path.data(), long_path.size()}, {nullptr, 0},
+        {"?q=", 3}, {"a\0b", 3}, {" HTTP/1.1\r\n", 11},
+    };
+    ASSERT_EQ(strbuf_append_iov(&sb, pieces, 6), 0);
+    EXPECT_EQ(std::string(sb.data, sb.size),
+              "GET /" + long_path + std::string("?q=a\0b HTTP/1.1\r\n", 17));
+    // a single exact growth: 4 + 118 bytes plus the '\0'
+    EXPECT_EQ(sb.capacity, sb.size + 1);
+    assert_basic_invariants(sb);
+
+    ASSERT_EQ(strbuf_append_iov(&sb, pieces, 0), 0);
+    ASSERT_EQ(strbuf_append_iov(&sb, nullptr, 0), 0);
+    EXPECT_EQ(sb.size, 122u);
+
+    strbuf_free(&sb);
+}
+
+TEST(StrBufJoinTest, JoinWithSeparator) {
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_init(&sb, 0), 0);
+    strbuf_view_t cols[] = {{"id", 2}, {"", 0}, {"name", 4}};
+
+    ASSERT_EQ(strbuf_join(&sb, cols, 3, ", "), 0);
+    EXPECT_STREQ(strbuf_c_str(&sb), "id, , name");
+    ASSERT_EQ(strbuf_join(&sb, cols, 1, "|"), 0);
+    EXPECT_STREQ(strbuf_c_str(&sb), "id, , nameid");
+    ASSERT_EQ(strbuf_join(&sb, cols, 3, nullptr), 0);
+    EXPECT_STREQ(strbuf_c_str(&sb), "id, , nameididname");
+    assert_basic_invariants(sb);
+
+    strbuf_free(&sb);
+}
+
+TEST(StrBufJoinTest, PiecesMayPointIntoTheBuffer) {
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_init(&sb, 0), 0);
+    ASSERT_EQ(strbuf_append_cstr(&sb, "ab"), 0);
+
+    // repeatedly doubling forces reallocation while reading from sb
+    for (int i = 0; i < 10; ++i) {
+        strbuf_view_t self[] = {{sb.data, sb.size}, {sb.data, 1}};
+        ASSERT_EQ(strbuf_join(&sb, self, 2, ""), 0);
+    }
+    std::string expect = "ab";
+    for (int i = 0; i < 10; ++i) expect = expect + expect + "a";
+    EXPECT_EQ(std::string(sb.data, sb.size), expect);
+    assert_basic_invariants(sb);
+
+    strbuf_free(&sb);
+}
+
+TEST(StrBufJoinTest, InvalidArgsLeaveContentUnchanged) {
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_init(&sb, 0), 0);
+    ASSERT_EQ(strbuf_append_cstr(&sb, "keep"), 0);
+
+    strbuf_view_t bad[] = {{"x", 1}, {nullptr, 3}};
+    strbuf_view_t huge[] = {{"x", 1}, {"y", SIZE_MAX}};
+    EXPECT_EQ(strbuf_append_iov(nullptr, bad, 1), -1);
+    EXPECT_EQ(strbuf_append_iov(&sb, nullptr, 1), -1);
+    EXPECT_EQ(strbuf_append_iov(&sb, bad, 2), -1);
+    EXPECT_EQ(strbuf_join(&sb, huge, 2, ","), -1);
+    EXPECT_STREQ(strbuf_c_str(&sb), "keep");
+
+    strbuf_free(&sb);
+}
@@ -0,0 +1,197 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+
+extern "C" {
+#include "strbuf.h"
+}
+
+static void set(strbuf_t* sb, const std::string& s) {
+    strbuf_clear(sb);
+    ASSERT_EQ(strbuf_append_n(sb, s.data(), s.size()), 0);
+}
+
+// Straightforward decoder used as the reference.
+static bool ref_valid(const std::string& s, size_t* count) {
+    size_t i = 0, n = 0;
+    while (i < s.size()) {
+        unsigned char c = (unsigned char)s[i];
+        uint32_t cp;
+        size_t len;
+        if (c < 0x80) { cp = c; len = 1; }
+        else if ((c & 0xE0) == 0xC0) { cp = c & 0x1F; len = 2; }
+        else if ((c & 0xF0) == 0xE0) { cp = c & 0x0F; len = 3; }
+        else if ((c & 0xF8) == 0xF0) { cp = c & 0x07; len = 4; }
+        else return false;
+        if (i + len > s.size()) return false;
+        for (size_t k = 1; k < len; ++k) {
+            unsigned char d = (unsigned char)s[i + k];
+            if ((d & 0xC0) != 0x80) return false;
+            cp = (cp << 6) | (d & 0x3F);
+        }
+        static const uint32_t min_cp[] = {0, 0, 0x80, 0x800, 0x10000};
+        if (cp < min_cp[len] || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) return false;
+        i += len;
+        ++n;
+    }
+    *count = n;
+    return true;
+}
+
+static std::string encode(uint32_t cp) {
+    std::string out;
+    if (cp < 0x80) {
+        out += (char)cp;
+    } else if (cp < 0x800) {
+        out += (char)(0xC0 | (cp >> 6));
+        out += (char)(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += (char)(0xE0 | (cp >> 12));
+        out += (char)(0x80 | ((cp >> 6) & 0x3F));
+        out += (char)(0x80 | (cp & 0x3F));
+    } else {
+        out += (char)(0xF0 | (cp >> 18));
+        out += (char)(0x80 | ((cp >> 12) & 0x3F));
+        out += (char)(0x80 | ((cp >> 6) & 0x3F));
+        out += (char)(0x80 | (cp & 0x3F));
+    }
+    return out;
+}
+
+static std::string random_text(std::mt19937& rng, size_t n) {
+    std::string s;
+    while (s.size() < n) {
+        uint32_t cp;
+        switch (rng() % 4) {
+        case 0: cp = rng() % 0x80; break;
+        case 1: cp = 0x80 + rng() % 0x780; break;
+        case 2: cp = 0x800 + rng() % 0xF800; break;
+        default: cp = 0x10000 + rng() % 0x100000; break;
+        }
+        if (cp >= 0xD800 && cp <= 0xDFFF) continue;
+        s += encode(cp);
+    }
+    return s;
+}
+
+TEST(StrBufUtf8Test, KnownValidAndInvalidSequences) {
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_init(&sb, 0), 0);
+    EXPECT_EQ(strbuf_validate_utf8(&sb), 1);
+    EXPECT_EQ(strbuf_utf8_length(&sb), 0u);
+
+    const char* valid[] = {"plain ascii", "\xC3\xA9t\xC3\xA9", "\xE2\x82\xAC", "\xF0\x9F\x98\x80",
+                           "\xED\x9F\xBF", "\xEE\x80\x80", "\xF4\x8F\xBF\xBF", "\xEF\xBB\xBF"};
+    for (const char* s : valid) {
+        set(&sb, s);
+        EXPECT_EQ(strbuf_validate_utf8(&sb), 1) << s;
+    }
+
+    const char* invalid[] = {
+        "\x80",             // lone continuation
+        "\xC0\xAF",         // overlong 2-byte
+        "\xE0\x80\xAF",     // overlong 3-byte
+        "\xF0\x80\x80\xAF", // overlong 4-byte
+        "\xED\xA0\x80",     // surrogate
+        "\xF4\x90\x80\x80", // above U+10FFFF
+        "\xF5\x80\x80\x80", // invalid lead
+        "\xFF",
+        "\xC3",             // truncated
+        "\xE2\x82",
+        "\xC3\x28",         // bad continuation
+        "\xE2\x28\xA1",
+        "\xF0\x9F\x98",
+    };
+    for (const char* s : invalid) {
+        set(&sb, s);
+        EXPECT_EQ(strbuf_validate_utf8(&sb), 0) << s;
+        // the same error deep inside a SIMD block and at a block boundary
+        for (size_t pad : {1u, 29u, 30u, 31u, 32u, 63u, 100u}) {
+            set(&sb, std::string(pad, 'a') + s + std::string(40, 'b'));
+            EXPECT_EQ(strbuf_validate_utf8(&sb), 0) << s << " at " << pad;
+        }
+    }
+
+    set(&sb, "h\xC3\xA9llo \xF0\x9F\x98\x80");
+    EXPECT_EQ(strbuf_utf8_length(&sb), 7u);
+    EXPECT_EQ(strbuf_validate_utf8(nullptr), -1);
+    EXPECT_EQ(strbuf_utf8_length(nullptr), 0u);
+
+    strbuf_free(&sb);
+}
+
+TEST(StrBufUtf8Test, MatchesReferenceOnRandomAndCorruptedText) {
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_init(&sb, 0), 0);
+    std::mt19937 rng(3);
+
+    for (int iter = 0; iter < 3000; ++iter) {
+        std::string s = random_text(rng, rng() % 200);
+        size_t expected_count = 0;
+        ASSERT_TRUE(ref_valid(s, &expected_count));
+        set(&sb, s);
+        ASSERT_EQ(strbuf_validate_utf8(&sb), 1);
+        ASSERT_EQ(strbuf_utf8_length(&sb), expected_count);
+
+        // flip a byte somewhere and compare the verdict
+        if (!s.empty()) {
+            s[rng() % s.size()] = (char)(rng() & 0xFF);
+            size_t count;
+            set(&sb, s);
+            ASSERT_EQ(strbuf_validate_utf8(&sb), ref_valid(s, &count) ? 1 : 0);
+        }
+    }
+
+    strbuf_free(&sb);
+}
+
+TEST(StrBufUtf8Test, AppendValidatesAcrossChunkBoundaries) {
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_init(&sb, 0), 0);
+    std::mt19937 rng(5);
+    std::string text = random_text(rng, 5000);
+
+    // feed in random chunk sizes that split multi-byte sequences
+    for (size_t pos = 0; pos < text.size();) {
+        size_t n = std::min<size_t>(1 + rng() % 7, text.size() - pos);
+        ASSERT_EQ(strbuf_append_utf8(&sb, &text[pos], n), 0) << "at " << pos;
+        pos += n;
+    }
+    EXPECT_EQ(std::string(sb.data, sb.size), text);
+    EXPECT_EQ(strbuf_validate_utf8(&sb), 1);
+
+    // an incomplete tail is accepted until completed, but cannot be broken
+    set(&sb, "ok");
+    ASSERT_EQ(strbuf_append_utf8(&sb, "\xE2", 1), 0);
+    EXPECT_EQ(strbuf_validate_utf8(&sb), 0);
+    EXPECT_EQ(strbuf_append_utf8(&sb, "x", 1), -1);
+    ASSERT_EQ(strbuf_append_utf8(&sb, "\x80\x80", 2), 0);
+    EXPECT_EQ(sb.size, 5u);
+    EXPECT_EQ(strbuf_validate_utf8(&sb), 1);
+    EXPECT_EQ(strbuf_append_utf8(&sb, "\xED\xA0", 2), -1);
+    EXPECT_EQ(strbuf_append_utf8(&sb, "\xC3\xA9\xFF", 3), -1);
+    EXPECT_STREQ(strbuf_c_str(&sb), "ok\xE2\x80\x80");
+
+    EXPECT_EQ(strbuf_append_utf8(nullptr, "a", 1), -1);
+    EXPECT_EQ(strbuf_append_utf8(&sb, nullptr, 1), -1);
+    strbuf_free(&sb);
+}
+
+TEST(StrBufUtf8Test, RejectedAppendLeavesStorageAlone) {
+    // invalid input is refused before the buffer is grown or written
+    strbuf_t sb;
+    ASSERT_EQ(strbuf_init(&sb, 64), 0);
+    set(&sb, "caf\xC3");
+    const char* data = sb.data;
+    size_t capacity = sb.capacity;
+    std::string big(4 * capacity, 'a');
+    big[0] = 'x';
+    EXPECT_EQ(strbuf_append_utf8(&sb, big.data(), big.size()), -1);
+    big[0] = '\xA9';
+    big.back() = '\xFF';
+    EXPECT_EQ(strbuf_append_utf8(&sb, big.data(), big.size()), -1);
+    EXPECT_EQ(sb.data, data);
+    EXPECT_EQ(sb.capacity, capacity);
+    EXPECT_EQ(std::string(sb.data, sb.size + 1), std::string("caf\xC3", 5));
+    strbuf_free(&sb);
+}
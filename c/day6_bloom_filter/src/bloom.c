@@ -0,0 +1,270 @@
+#include "bloom.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BLOOM_X86 (1)
+#endif
+
+#define OK      (0)
+#define ERR    (-1)
+
+#define PREFETCH_DISTANCE (8)
+
+/* Odd multipliers picking one bit per word (same salts as Parquet's
+ * split-block filter). */
+static const uint32_t kSalt[BLOOM_BLOCK_WORDS] = {
+    0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+    0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U,
+};
+
+static inline uint64_t hash_key(int key)
+{
+    /* murmur3 fmix64 */
+    uint64_t h = (uint64_t)(uint32_t)key;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+static inline uint32_t* block_for(const bloom_t* bf, uint64_t h)
+{
+    /* high 32 bits pick the block (multiply-shift instead of modulo),
+     * low 32 bits pick the bits inside it */
+    size_t idx = (size_t)(((h >> 32) * (uint64_t)bf->nblocks) >> 32);
+    return &bf->blocks[idx * BLOOM_BLOCK_WORDS];
+}
+
+/* False-positive rate of a blocked filter whose blocks hold keys_per_block
+ * keys on average: the load of a block is Poisson distributed and a block
+ * holding k keys answers yes with (1 - (1 - 1/32)^k)^8. */
+static double block_fpp(double keys_per_block)
+{
+    double p_load = exp(-keys_per_block);
+    double rate = 0.0;
+    size_t max_load = (size_t)(keys_per_block + 10.0 * sqrt(keys_per_block) + 20.0);
+
+    for (size_t k = 0; k <= max_load; k++) {
+        rate += p_load * pow(1.0 - pow(1.0 - 1.0 / 32.0, (double)k), BLOOM_BLOCK_WORDS);
+        p_load *= keys_per_block / (double)(k + 1);
+    }
+    return rate;
+}
+
+static inline void block_insert_scalar(uint32_t* block, uint32_t h)
+{
+    for (int i = 0; i < BLOOM_BLOCK_WORDS; i++) {
+        block[i] |= 1u << ((h * kSalt[i]) >> 27);
+    }
+}
+
+static inline int block_contains_scalar(const uint32_t* block, uint32_t h)
+{
+    uint32_t missing = 0;
+    for (int i = 0; i < BLOOM_BLOCK_WORDS; i++) {
+        uint32_t bit = 1u << ((h * kSalt[i]) >> 27);
+        missing |= bit & ~block[i];
+    }
+    return missing == 0;
+}
+
+#ifdef BLOOM_X86
+__attribute__((target("avx2")))
+static inline __m256i block_mask_avx2(uint32_t h)
+{
+    const __m256i salt = _mm256_loadu_si256((const __m256i*)kSalt);
+    __m256i shift = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_set1_epi32((int)h), salt), 27);
+    return _mm256_sllv_epi32(_mm256_set1_epi32(1), shift);
+}
+
+__attribute__((target("avx2")))
+static inline void block_insert_avx2(uint32_t* block, uint32_t h)
+{
+    __m256i* p = (__m256i*)block;
+    _mm256_store_si256(p, _mm256_or_si256(_mm256_load_si256(p), block_mask_avx2(h)));
+}
+
+__attribute__((target("avx2")))
+static inline int block_contains_avx2(const uint32_t* block, uint32_t h)
+{
+    /* testc: (~block & mask) == 0 */
+    return _mm256_testc_si256(_mm256_load_si256((const __m256i*)block), block_mask_avx2(h));
+}
+
+__attribute__((target("avx2")))
+static void insert_bulk_avx2(bloom_t* bf, const int* keys, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        if (i + PREFETCH_DISTANCE < n) {
+            __builtin_prefetch(block_for(bf, hash_key(keys[i + PREFETCH_DISTANCE])), 1);
+        }
+        uint64_t h = hash_key(keys[i]);
+        block_insert_avx2(block_for(bf, h), (uint32_t)h);
+    }
+}
+
+__attribute__((target("avx2")))
+static long contains_bulk_avx2(const bloom_t* bf, const int* keys, size_t n, uint8_t* out)
+{
+    long found = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (i + PREFETCH_DISTANCE < n) {
+            __builtin_prefetch(block_for(bf, hash_key(keys[i + PREFETCH_DISTANCE])), 0);
+        }
+        uint64_t h = hash_key(keys[i]);
+        out[i] = (uint8_t)block_contains_avx2(block_for(bf, h), (uint32_t)h);
+        found += out[i];
+    }
+    return found;
+}
+
+static int have_avx2(void)
+{
+    return __builtin_cpu_supports("avx2");
+}
+#else
+static int have_avx2(void)
+{
+    return 0;
+}
+#endif
+
+int bloom_init(bloom_t* bf, size_t expected_keys, double fpp)
+{
+    if (bf == NULL || !(fpp > 0.0 && fpp < 1.0)) {
+        return ERR;
+    }
+
+    bf->blocks = NULL;
+    bf->nblocks = 0;
+
+    if (expected_keys == 0) {
+        expected_keys = 1;
+    }
+
+    /* start from the classic estimate for 8 bits per key, then grow until
+     * the block-load aware rate meets fpp */
+    double bits = -8.0 * (double)expected_keys / log(1.0 - pow(fpp, 1.0 / BLOOM_BLOCK_WORDS));
+    double nblocks = ceil(bits / (BLOOM_BLOCK_BYTES * 8));
+
+    if (nblocks < 1.0) {
+        nblocks = 1.0;
+    }
+    while (nblocks <= (double)UINT32_MAX && block_fpp((double)expected_keys / nblocks) > fpp) {
+        nblocks = ceil(nblocks * 1.02);
+    }
+    if (nblocks > (double)UINT32_MAX || nblocks > (double)(SIZE_MAX / BLOOM_BLOCK_BYTES)) {
+        return ERR;
+    }
+
+    size_t bytes = (size_t)nblocks * BLOOM_BLOCK_BYTES;
+    uint32_t* mem_chunk = aligned_alloc(BLOOM_BLOCK_BYTES, bytes);
+
+    if (mem_chunk == NULL) {
+        return ERR;
+    }
+    memset(mem_chunk, 0, bytes);
+
+    bf->blocks = mem_chunk;
+    bf->nblocks = (size_t)nblocks;
+
+    return OK;
+}
+
+void bloom_free(bloom_t* bf)
+{
+    if (bf == NULL) {
+        return;
+    }
+
+    free(bf->blocks);
+    bf->blocks = NULL;
+    bf->nblocks = 0;
+}
+
+void bloom_clear(bloom_t* bf)
+{
+    if (bf == NULL || bf->blocks == NULL) {
+        return;
+    }
+
+    memset(bf->blocks, 0, bf->nblocks * BLOOM_BLOCK_BYTES);
+}
+
+int bloom_insert(bloom_t* bf, int key)
+{
+    if (bf == NULL || bf->blocks == NULL) {
+        return ERR;
+    }
+
+    return bloom_insert_bulk(bf, &key, 1);
+}
+
+int bloom_contains(const bloom_t* bf, int key)
+{
+    if (bf == NULL || bf->blocks == NULL) {
+        return ERR;
+    }
+
+    uint64_t h = hash_key(key);
+#ifdef BLOOM_X86
+    if (have_avx2()) {
+        return block_contains_avx2(block_for(bf, h), (uint32_t)h);
+    }
+#endif
+    return block_contains_scalar(block_for(bf, h), (uint32_t)h);
+}
+
+int bloom_insert_bulk(bloom_t* bf, const int* keys, size_t n)
+{
+    if (bf == NULL || bf->blocks == NULL || (keys == NULL && n > 0)) {
+        return ERR;
+    }
+
+#ifdef BLOOM_X86
+    if (have_avx2()) {
+        insert_bulk_avx2(bf, keys, n);
+        return OK;
+    }
+#endif
+
+    for (size_t i = 0; i < n; i++) {
+        if (i + PREFETCH_DISTANCE < n) {
+            __builtin_prefetch(block_for(bf, hash_key(keys[i + PREFETCH_DISTANCE])), 1);
+        }
+        uint64_t h = hash_key(keys[i]);
+        block_insert_scalar(block_for(bf, h), (uint32_t)h);
+    }
+
+    return OK;
+}
+
+long bloom_contains_bulk(const bloom_t* bf, const int* keys, size_t n, uint8_t* out)
+{
+    if (bf == NULL || bf->blocks == NULL || ((keys == NULL || out == NULL) && n > 0)) {
+        return ERR;
+    }
+
+#ifdef BLOOM_X86
+    if (have_avx2()) {
+        return contains_bulk_avx2(bf, keys, n, out);
+    }
+#endif
+
+    long found = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (i + PREFETCH_DISTANCE < n) {
+            __builtin_prefetch(block_for(bf, hash_key(keys[i + PREFETCH_DISTANCE])), 0);
+        }
+        uint64_t h = hash_key(keys[i]);
+        out[i] = (uint8_t)block_contains_scalar(block_for(bf, h), (uint32_t)h);
+        found += out[i];
+    }
+
+    return found;
+}
@@ -0,0 +1,51 @@
+#ifndef BLOOM_H
+#define BLOOM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Blocked Bloom filter for int keys.
+ * The bit array is split into 256-bit blocks aligned to 32 bytes; a key sets
+ * one bit in each of the 8 32-bit words of a single block, so every insert
+ * and query touches exactly one cache line. On x86 with AVX2 the block mask
+ * is built and tested with one vector operation each.
+ * No false negatives: a key that was inserted is always reported present.
+ */
+
+#define BLOOM_BLOCK_WORDS (8)
+#define BLOOM_BLOCK_BYTES (BLOOM_BLOCK_WORDS * sizeof(uint32_t))
+
+typedef struct {
+    uint32_t* blocks;  // nblocks * BLOOM_BLOCK_WORDS words
+    size_t    nblocks;
+} bloom_t;
+
+/* Size the filter for expected_keys distinct keys at false-positive
+ * probability fpp (0 < fpp < 1).
+ * Returns 0 on success, -1 on allocation failure or invalid args.
+ */
+int bloom_init(bloom_t* bf, size_t expected_keys, double fpp);
+
+/* Free resources; safe to call multiple times. */
+void bloom_free(bloom_t* bf);
+
+/* Remove all keys, keep the size. */
+void bloom_clear(bloom_t* bf);
+
+/* Insert key. Returns 0 on success, -1 on invalid args. */
+int bloom_insert(bloom_t* bf, int key);
+
+/* Returns 1 if key may be present, 0 if it is definitely absent,
+ * -1 on invalid args.
+ */
+int bloom_contains(const bloom_t* bf, int key);
+
+/* Insert n keys. Returns 0 on success, -1 on invalid args. */
+int bloom_insert_bulk(bloom_t* bf, const int* keys, size_t n);
+
+/* Query n keys; out[i] = 1 if keys[i] may be present, else 0.
+ * Returns the number of keys that may be present, or -1 on invalid args.
+ */
+long bloom_contains_bulk(const bloom_t* bf, const int* keys, size_t n, uint8_t* out);
+
+#endif
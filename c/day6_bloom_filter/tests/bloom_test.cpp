@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+#include <bitset>
+#include <cstring>
+#include <random>
+#include <vector>
+
+extern "C" {
+#include "bloom.h"
+}
+
+static size_t popcount_all(const bloom_t& bf) {
+    size_t bits = 0;
+    for (size_t i = 0; i < bf.nblocks * BLOOM_BLOCK_WORDS; ++i) {
+        bits += std::bitset<32>(bf.blocks[i]).count();
+    }
+    return bits;
+}
+
+TEST(BloomTest, InitAndFree) {
+    bloom_t bf;
+    ASSERT_EQ(bloom_init(&bf, 1000, 0.01), 0);
+    EXPECT_NE(bf.blocks, nullptr);
+    EXPECT_GE(bf.nblocks, 1u);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(bf.blocks) % BLOOM_BLOCK_BYTES, 0u);
+    EXPECT_EQ(popcount_all(bf), 0u);
+
+    bloom_free(&bf);
+    EXPECT_EQ(bf.blocks, nullptr);
+    bloom_free(&bf);
+}
+
+TEST(BloomTest, InitRejectsInvalidArgs) {
+    bloom_t bf;
+    EXPECT_EQ(bloom_init(nullptr, 10, 0.01), -1);
+    EXPECT_EQ(bloom_init(&bf, 10, 0.0), -1);
+    EXPECT_EQ(bloom_init(&bf, 10, 1.0), -1);
+    EXPECT_EQ(bloom_init(&bf, 10, -0.5), -1);
+}
+
+TEST(BloomTest, LowerFppGivesLargerFilter) {
+    bloom_t a, b;
+    ASSERT_EQ(bloom_init(&a, 10000, 0.1), 0);
+    ASSERT_EQ(bloom_init(&b, 10000, 0.001), 0);
+    EXPECT_LT(a.nblocks, b.nblocks);
+    bloom_free(&a);
+    bloom_free(&b);
+}
+
+TEST(BloomTest, InsertSetsOneBitPerWordInOneBlock) {
+    bloom_t bf;
+    ASSERT_EQ(bloom_init(&bf, 100, 0.01), 0);
+    ASSERT_EQ(bloom_insert(&bf, 12345), 0);
+
+    size_t touched_blocks = 0;
+    for (size_t b = 0; b < bf.nblocks; ++b) {
+        const uint32_t* block = &bf.blocks[b * BLOOM_BLOCK_WORDS];
+        size_t bits = 0;
+        for (int w = 0; w < BLOOM_BLOCK_WORDS; ++w) {
+            size_t c = std::bitset<32>(block[w]).count();
+            bits += c;
+            if (bits) EXPECT_LE(c, 1u);
+        }
+        if (bits) {
+            ++touched_blocks;
+            EXPECT_EQ(bits, (size_t)BLOOM_BLOCK_WORDS);
+        }
+    }
+    EXPECT_EQ(touched_blocks, 1u);
+    EXPECT_EQ(bloom_contains(&bf, 12345), 1);
+
+    bloom_clear(&bf);
+    EXPECT_EQ(popcount_all(bf), 0u);
+
+    bloom_free(&bf);
+}
+
+TEST(BloomTest, NoFalseNegativesAndFppNearTarget) {
+    const size_t n = 20000;
+    const double fpp = 0.01;
+    bloom_t bf;
+    ASSERT_EQ(bloom_init(&bf, n, fpp), 0);
+
+    std::mt19937 rng(42);
+    std::vector<int> keys(n);
+    for (auto& k : keys) k = (int)(rng() & 0x7fffffff);
+    for (int k : keys) ASSERT_EQ(bloom_insert(&bf, k), 0);
+
+    for (int k : keys) ASSERT_EQ(bloom_contains(&bf, k), 1);
+
+    // negative keys were never inserted
+    size_t fp = 0;
+    const size_t probes = 200000;
+    for (size_t i = 0; i < probes; ++i) {
+        fp += bloom_contains(&bf, -(int)i - 1);
+    }
+    EXPECT_LT((double)fp / probes, fpp * 1.5);
+
+    bloom_free(&bf);
+}
+
+TEST(BloomTest, BulkApisMatchSingleKeyApis) {
+    const size_t n = 5000;
+    std::vector<int> keys(n), probes(3 * n);
+    for (size_t i = 0; i < n; ++i) keys[i] = (int)(i * 2654435761u);
+    for (size_t i = 0; i < probes.size(); ++i) probes[i] = (int)(i * 40503u);
+
+    bloom_t bulk, single;
+    ASSERT_EQ(bloom_init(&bulk, n, 0.02), 0);
+    ASSERT_EQ(bloom_init(&single, n, 0.02), 0);
+
+    ASSERT_EQ(bloom_insert_bulk(&bulk, keys.data(), keys.size()), 0);
+    for (int k : keys) ASSERT_EQ(bloom_insert(&single, k), 0);
+    ASSERT_EQ(0, memcmp(bulk.blocks, single.blocks, bulk.nblocks * BLOOM_BLOCK_BYTES));
+
+    std::vector<uint8_t> out(probes.size(), 0xff);
+    long found = bloom_contains_bulk(&bulk, probes.data(), probes.size(), out.data());
+    long expected = 0;
+    for (size_t i = 0; i < probes.size(); ++i) {
+        int one = bloom_contains(&bulk, probes[i]);
+        ASSERT_EQ(out[i], one);
+        expected += one;
+    }
+    EXPECT_EQ(found, expected);
+
+    std::vector<uint8_t> hits(n);
+    EXPECT_EQ(bloom_contains_bulk(&bulk, keys.data(), n, hits.data()), (long)n);
+
+    bloom_free(&bulk);
+    bloom_free(&single);
+}
+
+TEST(BloomTest, InvalidArgsOnUninitializedFilter) {
+    bloom_t bf = {nullptr, 0};
+    uint8_t out;
+    int key = 1;
+    EXPECT_EQ(bloom_insert(&bf, 1), -1);
+    EXPECT_EQ(bloom_contains(&bf, 1), -1);
+    EXPECT_EQ(bloom_insert_bulk(&bf, &key, 1), -1);
+    EXPECT_EQ(bloom_contains_bulk(&bf, &key, 1, &out), -1);
+    EXPECT_EQ(bloom_contains_bulk(nullptr, &key, 1, &out), -1);
+}